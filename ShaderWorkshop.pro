@@ -13,6 +13,9 @@ CONFIG += c++11
 QMAKE_CXXFLAGS += -std=c++11
 }
 
+# let compiler vectorize FFT butterfly and image comparison loops
+gcc: QMAKE_CXXFLAGS_RELEASE += -ftree-vectorize
+
 TARGET = ShaderWorkshop
 TEMPLATE = app
 
@@ -24,7 +27,34 @@ SOURCES += main.cpp\
     editorpage.cpp \
     codeeditor.cpp \
     glslhighlighter.cpp \
-    channelsettings.cpp
+    channelsettings.cpp \
+    channeltexture.cpp \
+    audiotexture.cpp \
+    audioanalyzer.cpp \
+    fft.cpp \
+    project.cpp \
+    shaderpreprocessor.cpp \
+    shaderparameter.cpp \
+    parameterswidget.cpp \
+    shadercompiler.cpp \
+    symbolindex.cpp \
+    tracer.cpp \
+    gputimer.cpp \
+    costheatmap.cpp \
+    framehistory.cpp \
+    glstatecache.cpp \
+    presenterwindow.cpp \
+    commandqueue.cpp \
+    renderthread.cpp \
+    shaderlog.cpp \
+    batchvalidator.cpp \
+    shaderlibrary.cpp \
+    librarybrowser.cpp \
+    imagedifference.cpp \
+    goldentest.cpp \
+    gpumemory.cpp \
+    glshader.cpp \
+    offscreenworker.cpp
 
 HEADERS  += shaderworkshop.h \
     renderer.h \
@@ -33,8 +63,42 @@ HEADERS  += shaderworkshop.h \
     linenumberarea.h \
     codeeditor.h \
     glslhighlighter.h \
-    channelsettings.h
+    channelsettings.h \
+    channeltexture.h \
+    audiotexture.h \
+    audioanalyzer.h \
+    fft.h \
+    project.h \
+    shaderpreprocessor.h \
+    shaderparameter.h \
+    parameterswidget.h \
+    shadercompiler.h \
+    symbolindex.h \
+    tracer.h \
+    gputimer.h \
+    costheatmap.h \
+    framehistory.h \
+    glstatecache.h \
+    presenterwindow.h \
+    commandqueue.h \
+    renderthread.h \
+    shaderlog.h \
+    batchvalidator.h \
+    shaderlibrary.h \
+    librarybrowser.h \
+    imagedifference.h \
+    goldentest.h \
+    gpumemory.h \
+    glshader.h \
+    offscreenworker.h
 
 FORMS    += shaderworkshop.ui \
     editorpage.ui \
     channelsettings.ui
+
+# 'make golden' renders reference scenes and compares them with golden images,
+# 'make check-vectorization' checks image comparison loops are vectorized
+golden.commands = $$PWD/scripts/golden.sh $$OUT_PWD/$$TARGET
+golden.depends = $(TARGET)
+check-vectorization.commands = $$PWD/scripts/check-vectorization.sh
+QMAKE_EXTRA_TARGETS += golden check-vectorization
@@ -0,0 +1,278 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "audioanalyzer.h"
+#include "tracer.h"
+#include <QMutexLocker>
+#include <QtEndian>
+#include <QtMath>
+#include <cstring>
+
+namespace {
+
+const quint16 formatPcm = 1;
+const quint16 formatFloat = 3;
+const quint16 formatExtensible = 0xFFFE;
+
+// same ranges as in Web Audio AnalyserNode, used by ShaderToy
+const float minDecibels = -100.0f;
+const float maxDecibels = -30.0f;
+const float smoothingTimeConstant = 0.8f;
+
+} // namespace
+
+AudioAnalyzer::AudioAnalyzer(QObject *parent) :
+    QObject(parent),
+    mapped(Q_NULLPTR),
+    samples(Q_NULLPTR),
+    frames(0),
+    channels(0),
+    sampleRate(0),
+    bytesPerSample(0),
+    floatSamples(false),
+    fft(textureWidth * 2),
+    window(textureWidth * 2),
+    re(textureWidth * 2),
+    im(textureWidth * 2),
+    smoothed(textureWidth, 0.0f),
+    requestedTime(0.0),
+    pending(false),
+    result(textureWidth * 2, 0),
+    resultReady(false)
+{
+    const int size = window.size();
+
+    // Blackman window
+    for (int i = 0; i < size; i++) {
+        double x = 2.0 * M_PI * i / size;
+
+        window[i] = 0.42 - 0.5 * qCos(x) + 0.08 * qCos(2.0 * x);
+    }
+}
+
+AudioAnalyzer::~AudioAnalyzer()
+{
+    if (mapped) {
+        file.unmap(mapped);
+    }
+}
+
+bool AudioAnalyzer::open(const QString &fileName, QString &error)
+{
+    file.setFileName(fileName);
+
+    if (!file.open(QFile::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    const qint64 size = file.size();
+    mapped = size > 12 ? file.map(0, size) : Q_NULLPTR;
+
+    if (!mapped || memcmp(mapped, "RIFF", 4) || memcmp(mapped + 8, "WAVE", 4)) {
+        error = tr("Not a WAV file");
+        return false;
+    }
+
+    quint16 format = 0;
+    qint64 offset = 12;
+    qint64 dataSize = 0;
+
+    // walk RIFF chunks looking for 'fmt ' and 'data'
+    while (offset + 8 <= size) {
+        const uchar *chunk = mapped + offset;
+        qint64 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+        const uchar *body = chunk + 8;
+
+        if (offset + 8 + chunkSize > size) {
+            // tolerate truncated data chunk
+            chunkSize = size - offset - 8;
+        }
+
+        if (!memcmp(chunk, "fmt ", 4) && chunkSize >= 16) {
+            format = qFromLittleEndian<quint16>(body);
+            channels = qFromLittleEndian<quint16>(body + 2);
+            sampleRate = qFromLittleEndian<quint32>(body + 4);
+            bytesPerSample = qFromLittleEndian<quint16>(body + 14) / 8;
+
+            if (format == formatExtensible && chunkSize >= 26) {
+                // sub format GUID starts with actual format tag
+                format = qFromLittleEndian<quint16>(body + 24);
+            }
+        }
+        else if (!memcmp(chunk, "data", 4)) {
+            samples = body;
+            dataSize = chunkSize;
+        }
+
+        // chunks are padded to even size
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    floatSamples = format == formatFloat;
+
+    bool supported = (format == formatPcm && bytesPerSample >= 1 && bytesPerSample <= 4)
+                  || (floatSamples && bytesPerSample == 4);
+
+    if (!supported || channels < 1 || sampleRate < 1) {
+        error = tr("Only 8, 16, 24, 32 bit integer or 32 bit float PCM WAV files "
+                   "are supported");
+        return false;
+    }
+
+    frames = samples ? dataSize / (bytesPerSample * channels) : 0;
+
+    if (frames == 0) {
+        error = tr("WAV file has no audio data");
+        return false;
+    }
+
+    return true;
+}
+
+void AudioAnalyzer::requestAnalysis(double time)
+{
+    QMutexLocker locker(&mutex);
+
+    requestedTime = time;
+
+    if (pending) {
+        return;
+    }
+
+    pending = true;
+    locker.unlock();
+
+    QMetaObject::invokeMethod(this, "analyze", Qt::QueuedConnection);
+}
+
+bool AudioAnalyzer::takeResult(QByteArray &pixels)
+{
+    QMutexLocker locker(&mutex);
+
+    if (!resultReady) {
+        return false;
+    }
+
+    pixels = result;
+    resultReady = false;
+
+    return true;
+}
+
+void AudioAnalyzer::analyze()
+{
+    TRACE_SCOPE("analyzeAudio", "audio");
+
+    mutex.lock();
+    double time = requestedTime;
+    pending = false;
+    mutex.unlock();
+
+    QByteArray pixels(textureWidth * 2, 0);
+    uchar *data = reinterpret_cast<uchar*>(pixels.data());
+    qint64 frame = qint64(time * sampleRate);
+
+    computeSpectrum(frame, data);
+    computeWaveform(frame, data + textureWidth);
+
+    QMutexLocker locker(&mutex);
+    result = pixels;
+    resultReady = true;
+}
+
+float AudioAnalyzer::sample(qint64 frame) const
+{
+    frame %= frames;
+
+    if (frame < 0) {
+        frame += frames;
+    }
+
+    const uchar *data = samples + frame * channels * bytesPerSample;
+    float sum = 0.0f;
+
+    for (int channel = 0; channel < channels; channel++, data += bytesPerSample) {
+        if (floatSamples) {
+            quint32 bits = qFromLittleEndian<quint32>(data);
+            float value;
+
+            memcpy(&value, &bits, sizeof(value));
+            sum += value;
+            continue;
+        }
+
+        switch (bytesPerSample) {
+        case 1:
+            sum += (data[0] - 128) / 128.0f;
+            break;
+        case 2:
+            sum += qFromLittleEndian<qint16>(data) / 32768.0f;
+            break;
+        case 3:
+            // sign-extend 24 bit sample stored in upper bytes
+            sum += qint32((data[0] << 8) | (data[1] << 16) | (quint32(data[2]) << 24))
+                    / 2147483648.0f;
+            break;
+        case 4:
+            sum += qFromLittleEndian<qint32>(data) / 2147483648.0f;
+            break;
+        }
+    }
+
+    return sum / channels;
+}
+
+void AudioAnalyzer::computeSpectrum(qint64 frame, uchar *row)
+{
+    const int size = fft.size();
+    // analysis window ends at current playback position
+    const qint64 first = frame - size;
+
+    for (int i = 0; i < size; i++) {
+        re[i] = sample(first + i) * window[i];
+        im[i] = 0.0f;
+    }
+
+    fft.transform(re.data(), im.data());
+
+    const float range = maxDecibels - minDecibels;
+
+    for (int i = 0; i < textureWidth; i++) {
+        float magnitude = qSqrt(re[i] * re[i] + im[i] * im[i]) / size;
+
+        smoothed[i] = smoothingTimeConstant * smoothed[i]
+                    + (1.0f - smoothingTimeConstant) * magnitude;
+
+        float decibels = 20.0f * std::log10(qMax(smoothed[i], 1e-10f));
+        float value = (decibels - minDecibels) / range;
+
+        row[i] = uchar(qBound(0.0f, value, 1.0f) * 255.0f);
+    }
+}
+
+void AudioAnalyzer::computeWaveform(qint64 frame, uchar *row) const
+{
+    const qint64 first = frame - textureWidth;
+
+    for (int i = 0; i < textureWidth; i++) {
+        float value = sample(first + i) * 0.5f + 0.5f;
+
+        row[i] = uchar(qBound(0.0f, value, 1.0f) * 255.0f);
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOANALYZER_H
+#define AUDIOANALYZER_H
+
+#include <QObject>
+#include <QFile>
+#include <QMutex>
+#include <QByteArray>
+#include <QVector>
+#include "fft.h"
+
+/// Computes ShaderToy-like audio texture data from memory-mapped WAV file:
+/// first row holds spectrum, second row holds waveform, one byte per texel.
+/// Analysis runs in the thread analyzer object lives in
+class AudioAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// audio texture width, height is always 2
+    static const int textureWidth = 512;
+
+    explicit AudioAnalyzer(QObject *parent = Q_NULLPTR);
+    ~AudioAnalyzer();
+
+    /// open WAV file, fill error on failure
+    bool open(const QString &fileName, QString &error);
+
+    /// request analysis at playback time in seconds, thread-safe.
+    /// Requests made while analysis is running replace each other
+    void requestAnalysis(double time);
+    /// take latest analysis result if there is a new one, thread-safe
+    bool takeResult(QByteArray &pixels);
+
+private slots:
+    void analyze();
+
+private:
+    /// mono sample of looped playback at specified frame
+    float sample(qint64 frame) const;
+    void computeSpectrum(qint64 frame, uchar *row);
+    void computeWaveform(qint64 frame, uchar *row) const;
+
+    QFile file;
+    uchar *mapped;
+    /// PCM data inside mapped file
+    const uchar *samples;
+    qint64 frames;
+    int channels;
+    int sampleRate;
+    int bytesPerSample;
+    bool floatSamples;
+
+    Fft fft;
+    QVector<float> window;
+    QVector<float> re;
+    QVector<float> im;
+    /// spectrum magnitudes smoothed over time
+    QVector<float> smoothed;
+
+    QMutex mutex;
+    double requestedTime;
+    bool pending;
+    QByteArray result;
+    bool resultReady;
+};
+
+#endif // AUDIOANALYZER_H
@@ -0,0 +1,84 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "audiotexture.h"
+#include "audioanalyzer.h"
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+AudioTexture::AudioTexture(GLuint id, AudioAnalyzer *analyzer) :
+    ChannelTexture(GL_TEXTURE_2D, id, false),
+    analyzer(analyzer)
+{
+    analyzer->moveToThread(&thread);
+    thread.setObjectName("Audio analyzer");
+    thread.start();
+}
+
+AudioTexture::~AudioTexture()
+{
+    thread.quit();
+    thread.wait();
+
+    delete analyzer;
+}
+
+AudioTexture* AudioTexture::load(const QString &fileName, QString &error)
+{
+    AudioAnalyzer *analyzer = new AudioAnalyzer();
+
+    if (!analyzer->open(fileName, error)) {
+        delete analyzer;
+        return Q_NULLPTR;
+    }
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+
+    Q_ASSERT(context != Q_NULLPTR);
+
+    QOpenGLFunctions *gl = context->functions();
+    const QByteArray silence(AudioAnalyzer::textureWidth * 2, 0);
+    GLuint id = 0;
+
+    gl->glGenTextures(1, &id);
+    gl->glBindTexture(GL_TEXTURE_2D, id);
+    gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, AudioAnalyzer::textureWidth, 2, 0,
+                     GL_RED, GL_UNSIGNED_BYTE, silence.constData());
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+
+    AudioTexture *texture = new AudioTexture(id, analyzer);
+    texture->fileName = fileName;
+
+    return texture;
+}
+
+void AudioTexture::update(float time)
+{
+    // result of the previous request is uploaded, so rendering never waits
+    // for analysis to finish
+    if (analyzer->takeResult(pixels)) {
+        QOpenGLFunctions *gl = QOpenGLContext::currentContext()->functions();
+
+        gl->glBindTexture(GL_TEXTURE_2D, id);
+        gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, AudioAnalyzer::textureWidth, 2,
+                            GL_RED, GL_UNSIGNED_BYTE, pixels.constData());
+        revision++;
+    }
+
+    analyzer->requestAnalysis(time);
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOTEXTURE_H
+#define AUDIOTEXTURE_H
+
+#include "channeltexture.h"
+#include <QThread>
+#include <QByteArray>
+
+class AudioAnalyzer;
+
+/// 512x2 audio texture updated from WAV file analyzed on worker thread.
+/// Playback position follows renderer time
+class AudioTexture : public ChannelTexture
+{
+public:
+    AudioTexture(GLuint id, AudioAnalyzer *analyzer);
+    ~AudioTexture();
+
+    /// load WAV file, return Q_NULLPTR and fill error on failure.
+    /// OpenGL context must be current
+    static AudioTexture* load(const QString &fileName, QString &error);
+
+    /// upload latest analysis result and request next one
+    void update(float time) Q_DECL_OVERRIDE;
+
+private:
+    AudioAnalyzer *analyzer;
+    QThread thread;
+    QByteArray pixels;
+};
+
+#endif // AUDIOTEXTURE_H
@@ -0,0 +1,297 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "batchvalidator.h"
+#include "shaderpreprocessor.h"
+#include "glshader.h"
+#include "tracer.h"
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+
+namespace {
+
+double milliseconds(qint64 microseconds)
+{
+    return microseconds / 1000.0;
+}
+
+} // namespace
+
+BatchValidator::Result::Result() :
+    success(false),
+    compileTimeUs(0),
+    linkTimeUs(0)
+{
+}
+
+BatchValidator::BatchValidator(int threadCount, QObject *parent) :
+    QObject(parent)
+{
+    const int count = threadCount > 0 ? threadCount : qMax(QThread::idealThreadCount(), 1);
+
+    for (int i = 0; i < count; i++) {
+        BatchValidatorWorker *worker = new BatchValidatorWorker();
+
+        worker->start(QString("Shader validator %1").arg(i));
+        workers.append(worker);
+    }
+}
+
+BatchValidator::~BatchValidator()
+{
+    for (BatchValidatorWorker *worker : workers) {
+        worker->stop();
+
+        delete worker;
+    }
+}
+
+QStringList BatchValidator::findShaders(const QString &directory)
+{
+    QStringList files;
+    QDirIterator it(directory, QStringList() << "*.frag", QDir::Files,
+                    QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+
+    while (it.hasNext()) {
+        files.append(it.next());
+    }
+
+    // report does not depend on directory listing order
+    files.sort();
+
+    return files;
+}
+
+QVector<BatchValidator::Result> BatchValidator::validate(const QStringList &files)
+{
+    TRACE_SCOPE("validateShaders", "compile");
+
+    QVector<Result> results(files.size());
+    BatchValidationJob job;
+
+    job.files = files;
+    job.results = results.data();
+    job.finished = &finished;
+
+    // workers take files one by one, so slow files do not hold others back
+    for (BatchValidatorWorker *worker : workers) {
+        worker->job = &job;
+        QMetaObject::invokeMethod(worker, "validate", Qt::QueuedConnection);
+    }
+
+    finished.acquire(workers.size());
+
+    return results;
+}
+
+QJsonObject BatchValidator::report(const QVector<Result> &results, qint64 elapsedMs) const
+{
+    QJsonArray files;
+    int failed = 0;
+
+    for (const Result &result : results) {
+        QJsonArray messages;
+
+        for (const ShaderLogMessage &message : result.messages) {
+            QJsonObject item;
+
+            item["severity"] = message.severity;
+            // empty for lines without known format
+            item["source"] = result.sources.value(message.source);
+            item["line"] = message.line;
+            item["message"] = message.description;
+
+            messages.append(item);
+        }
+
+        QJsonObject file;
+
+        file["file"] = result.fileName;
+        file["success"] = result.success;
+        file["compileMs"] = milliseconds(result.compileTimeUs);
+        file["linkMs"] = milliseconds(result.linkTimeUs);
+        file["messages"] = messages;
+
+        if (!result.error.isEmpty()) {
+            file["error"] = result.error;
+        }
+
+        files.append(file);
+
+        if (!result.success) {
+            failed++;
+        }
+    }
+
+    QJsonObject report;
+
+    report["files"] = files;
+    report["total"] = results.size();
+    report["failed"] = failed;
+    report["threads"] = workers.size();
+    report["elapsedMs"] = elapsedMs;
+
+    return report;
+}
+
+BatchValidatorWorker::BatchValidatorWorker() :
+    job(Q_NULLPTR),
+    vertexShader(0),
+    computeSupported(false)
+{
+}
+
+void BatchValidatorWorker::validate()
+{
+    Q_ASSERT(job != Q_NULLPTR);
+
+    const bool current = makeCurrent();
+
+    if (current && !vertexShader) {
+        QString log;
+
+        vertexShader = GlShader::compile(context->extraFunctions(), GL_VERTEX_SHADER,
+                                         GlShader::vertexSource, log);
+        computeSupported = !context->isOpenGLES()
+                && (context->format().version() >= qMakePair(4, 3)
+                    || context->hasExtension("GL_ARB_compute_shader"));
+    }
+
+    for (int i = job->next.fetchAndAddOrdered(1); i < job->files.size();
+         i = job->next.fetchAndAddOrdered(1)) {
+        if (current) {
+            job->results[i] = validateFile(job->files.at(i));
+        }
+        else {
+            job->results[i].fileName = job->files.at(i);
+            job->results[i].error = tr("Could not create OpenGL context");
+        }
+    }
+
+    job->finished->release();
+}
+
+void BatchValidatorWorker::releaseResources()
+{
+    if (vertexShader) {
+        context->extraFunctions()->glDeleteShader(vertexShader);
+    }
+}
+
+BatchValidator::Result BatchValidatorWorker::validateFile(const QString &fileName)
+{
+    TRACE_SCOPE("validateShader", "compile");
+
+    BatchValidator::Result result;
+    QFile file(fileName);
+
+    result.fileName = fileName;
+
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        result.error = file.errorString();
+        return result;
+    }
+
+    // includes are looked up next to including file, like in editor
+    const QDir directory = QFileInfo(fileName).absoluteDir();
+    ShaderPreprocessor preprocessor([&directory](const QString &name, QString &contents) {
+        QFile include(directory.absoluteFilePath(name));
+
+        if (!include.open(QFile::ReadOnly | QFile::Text)) {
+            return false;
+        }
+
+        contents = QString::fromUtf8(include.readAll());
+        return true;
+    });
+
+    QString source;
+    QStringList includes;
+
+    if (!preprocessor.process(QString::fromUtf8(file.readAll()), source, includes,
+                              result.error)) {
+        return result;
+    }
+
+    result.sources.append(fileName);
+
+    for (const QString &include : includes) {
+        result.sources.append(directory.filePath(include));
+    }
+
+    const bool compute = GlShader::isCompute(source);
+
+    if (compute && !computeSupported) {
+        result.error = tr("Compute shaders require OpenGL 4.3 or GL_ARB_compute_shader");
+        return result;
+    }
+
+    QOpenGLExtraFunctions *gl = context->extraFunctions();
+    QElapsedTimer timer;
+    QString log;
+
+    timer.start();
+
+    // compile status query waits for compilation to finish
+    GLuint shader = GlShader::compile(gl, compute ? GL_COMPUTE_SHADER : GL_FRAGMENT_SHADER,
+                                      source, log);
+
+    result.compileTimeUs = timer.nsecsElapsed() / 1000;
+
+    if (shader) {
+        timer.restart();
+
+        GLuint program = GlShader::link(gl, compute ? 0 : vertexShader, shader, log);
+
+        result.linkTimeUs = timer.nsecsElapsed() / 1000;
+        result.success = program != 0;
+
+        gl->glDeleteProgram(program);
+        gl->glDeleteShader(shader);
+    }
+
+    addMessages(log, result);
+
+    return result;
+}
+
+void BatchValidatorWorker::addMessages(const QString &log,
+                                       BatchValidator::Result &result) const
+{
+    for (const QString &line : log.split('\n')) {
+        // split behavior flags moved between Qt versions, skip empty lines here
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        ShaderLogMessage message;
+
+        // same parsing as log of editor page, unknown lines are kept whole
+        if (!ShaderLogMessage::parse(line, message)) {
+            message.description = line.trimmed();
+        }
+
+        result.messages.append(message);
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCHVALIDATOR_H
+#define BATCHVALIDATOR_H
+
+#include "offscreenworker.h"
+#include <QVector>
+#include <QStringList>
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QJsonObject>
+#include <QOpenGLFunctions>
+#include "shaderlog.h"
+
+class BatchValidatorWorker;
+
+/// Compiles and links shader files on a pool of threads, each of them
+/// with its own offscreen OpenGL context, to check whole shader library
+/// from command line
+class BatchValidator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result
+    {
+        Result();
+
+        QString fileName;
+        /// files by GLSL source string number of log messages,
+        /// validated file first, then its includes
+        QStringList sources;
+        /// compiled and linked without errors
+        bool success;
+        /// file could not be read or its includes could not be resolved
+        QString error;
+        /// compile and link log, lines without known format have no severity
+        QVector<ShaderLogMessage> messages;
+        qint64 compileTimeUs;
+        qint64 linkTimeUs;
+    };
+
+    /// must be created in GUI thread, threads below 1 mean one per core
+    explicit BatchValidator(int threadCount, QObject *parent = Q_NULLPTR);
+    ~BatchValidator();
+
+    /// fragment shaders in directory and its subdirectories, sorted by path
+    static QStringList findShaders(const QString &directory);
+
+    /// compile and link all files, results are in order of files
+    QVector<Result> validate(const QStringList &files);
+    /// machine readable report of results
+    QJsonObject report(const QVector<Result> &results, qint64 elapsedMs) const;
+
+private:
+    QVector<BatchValidatorWorker*> workers;
+    /// released by each worker once there are no files left
+    QSemaphore finished;
+};
+
+/// files of single validate() call shared by all workers
+struct BatchValidationJob
+{
+    QStringList files;
+    /// file next free worker takes
+    QAtomicInt next;
+    /// one result per file, each one is written by single worker
+    BatchValidator::Result *results;
+    QSemaphore *finished;
+};
+
+class BatchValidatorWorker : public OffscreenWorker
+{
+    Q_OBJECT
+
+public:
+    BatchValidatorWorker();
+
+    /// set before validate() is invoked
+    BatchValidationJob *job;
+
+public slots:
+    /// take files of job until there are none left
+    void validate();
+
+protected:
+    void releaseResources() Q_DECL_OVERRIDE;
+
+private:
+    BatchValidator::Result validateFile(const QString &fileName);
+    void addMessages(const QString &log, BatchValidator::Result &result) const;
+
+    /// compiled once, all fragment shaders are linked with it
+    GLuint vertexShader;
+    bool computeSupported;
+};
+
+#endif // BATCHVALIDATOR_H
@@ -17,12 +17,32 @@
  */
 
 #include "channelsettings.h"
+#include "effect.h"
 #include "ui_channelsettings.h"
+#include <QFileDialog>
+#include <QFileInfo>
+
+namespace {
+
+/// select combo box item with specified data without notifications
+int selectItem(QComboBox *box, const QVariant &data)
+{
+    int index = qMax(0, box->findData(data));
+
+    box->blockSignals(true);
+    box->setCurrentIndex(index);
+    box->blockSignals(false);
+
+    return index;
+}
+
+} // namespace
 
 ChannelSettings::ChannelSettings(const PagesData &data, const QString &name,
                                  QWidget *parent) :
     QWidget(parent),
-    ui(new Ui::ChannelSettings)
+    ui(new Ui::ChannelSettings),
+    previousInputIndex(0)
 {
     ui->setupUi(this);
     ui->channelName->setText(name);
@@ -33,6 +53,15 @@ ChannelSettings::ChannelSettings(const PagesData &data, const QString &name,
         ui->inputBox->addItem(item.second, item.first);
     }
 
+    ui->inputBox->addItem(tr("Texture file..."), textureFileInput);
+
+    for (int i = 0; i < Effect::maxOutputs; i++) {
+        ui->outputBox->addItem(QString::number(i), i);
+    }
+
+    // only buffers have several outputs
+    ui->outputBox->setEnabled(false);
+
     ui->filterBox->addItem("Mipmap", GL_LINEAR_MIPMAP_LINEAR);
     ui->filterBox->addItem("Linear", GL_LINEAR);
     ui->filterBox->addItem("Nearest", GL_NEAREST);
@@ -43,6 +72,12 @@ ChannelSettings::ChannelSettings(const PagesData &data, const QString &name,
     connect(ui->inputBox, SIGNAL(currentIndexChanged(int)),
             this, SLOT(inputChanged(int)));
 
+    connect(ui->inputBox, SIGNAL(activated(int)),
+            this, SLOT(inputActivated(int)));
+
+    connect(ui->outputBox, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(attachmentChanged(int)));
+
     connect(ui->filterBox, SIGNAL(currentIndexChanged(int)),
             this, SLOT(filteringChanged(int)));
 
@@ -55,13 +90,121 @@ ChannelSettings::~ChannelSettings()
     delete ui;
 }
 
+void ChannelSettings::resetInput()
+{
+    ui->inputBox->setCurrentIndex(0);
+}
+
+int ChannelSettings::inputPage() const
+{
+    int data = ui->inputBox->currentData().toInt();
+
+    return data == textureFileInput ? -1 : data;
+}
+
+QString ChannelSettings::textureFile() const
+{
+    if (ui->inputBox->currentData().toInt() != textureFileInput) {
+        return QString();
+    }
+
+    return ui->inputBox->currentData(Qt::ToolTipRole).toString();
+}
+
+int ChannelSettings::attachment() const
+{
+    return ui->outputBox->currentData().toInt();
+}
+
+GLint ChannelSettings::filtering() const
+{
+    return ui->filterBox->currentData().toInt();
+}
+
+GLint ChannelSettings::wrap() const
+{
+    return ui->wrapBox->currentData().toInt();
+}
+
+void ChannelSettings::setInputPage(int pageIndex)
+{
+    inputChanged(selectItem(ui->inputBox, pageIndex));
+}
+
+void ChannelSettings::setTextureFile(const QString &fileName)
+{
+    previousInputIndex = selectItem(ui->inputBox, textureFileInput);
+
+    showTextureFile(fileName);
+
+    emit channelTextureChanged(fileName);
+}
+
+void ChannelSettings::setAttachment(int value)
+{
+    attachmentChanged(selectItem(ui->outputBox, value));
+}
+
+void ChannelSettings::setFiltering(GLint value)
+{
+    filteringChanged(selectItem(ui->filterBox, value));
+}
+
+void ChannelSettings::setWrap(GLint value)
+{
+    wrapChanged(selectItem(ui->wrapBox, value));
+}
+
 void ChannelSettings::inputChanged(int index)
 {
     int data = ui->inputBox->itemData(index).toInt();
 
+    // texture file is chosen in inputActivated() after user interaction
+    if (data == textureFileInput) {
+        return;
+    }
+
+    int textureIndex = ui->inputBox->findData(textureFileInput);
+    ui->inputBox->setItemText(textureIndex, tr("Texture file..."));
+    ui->inputBox->setItemData(textureIndex, QString(), Qt::ToolTipRole);
+
+    previousInputIndex = index;
+    ui->outputBox->setEnabled(data >= 0);
+
     emit channelInputChanged(data);
 }
 
+void ChannelSettings::inputActivated(int index)
+{
+    int data = ui->inputBox->itemData(index).toInt();
+
+    if (data != textureFileInput) {
+        return;
+    }
+
+    if (selectTextureFile()) {
+        previousInputIndex = index;
+        return;
+    }
+
+    // failed load has already reset the input
+    if (ui->inputBox->currentIndex() != index) {
+        return;
+    }
+
+    // file selection canceled, restore previous input without notifications
+    ui->inputBox->blockSignals(true);
+    ui->inputBox->setCurrentIndex(previousInputIndex);
+    ui->inputBox->blockSignals(false);
+}
+
+void ChannelSettings::attachmentChanged(int index)
+{
+    int value = ui->outputBox->itemData(index).toInt();
+
+    emit channelAttachmentChanged(value);
+}
+
 void ChannelSettings::filteringChanged(int index)
 {
     GLint value = ui->filterBox->itemData(index).toInt();
@@ -75,3 +218,31 @@ void ChannelSettings::wrapChanged(int index)
 
     emit channelWrapChanged(value);
 }
+
+bool ChannelSettings::selectTextureFile()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open Texture"), "",
+                        tr("Textures (*.ktx *.dds *.raw *.wav);; KTX texture (*.ktx);; "
+                           "DDS texture (*.dds);; Raw 3D volume (*.raw);; "
+                           "WAV audio (*.wav)"));
+
+    if (fileName.isEmpty()) {
+        return false;
+    }
+
+    showTextureFile(fileName);
+
+    emit channelTextureChanged(fileName);
+
+    // failed load resets input to none before the signal returns
+    return ui->inputBox->currentData().toInt() == textureFileInput;
+}
+
+void ChannelSettings::showTextureFile(const QString &fileName)
+{
+    int textureIndex = ui->inputBox->findData(textureFileInput);
+
+    ui->inputBox->setItemText(textureIndex, QFileInfo(fileName).fileName());
+    ui->inputBox->setItemData(textureIndex, fileName, Qt::ToolTipRole);
+    ui->outputBox->setEnabled(false);
+}
@@ -36,18 +36,47 @@ public:
                              QWidget *parent = Q_NULLPTR);
     ~ChannelSettings();
 
+    /// switch channel back to 'No input'
+    void resetInput();
+
+    /// page index used as input, -1 if channel has no input page
+    int inputPage() const;
+    /// texture file used as input, empty if channel has no texture
+    QString textureFile() const;
+    /// shader output of input page sampled by channel
+    int attachment() const;
+    GLint filtering() const;
+    GLint wrap() const;
+
+    // setters below always notify about the value, even if it is unchanged
+    void setInputPage(int pageIndex);
+    void setTextureFile(const QString &fileName);
+    void setAttachment(int value);
+    void setFiltering(GLint value);
+    void setWrap(GLint value);
+
 signals:
     void channelInputChanged(int pageIndex);
+    void channelTextureChanged(const QString &fileName);
+    void channelAttachmentChanged(int attachment);
     void channelFilteringChanged(GLint value);
     void channelWrapChanged(GLint value);
 
 private slots:
     void inputChanged(int index);
+    void inputActivated(int index);
+    void attachmentChanged(int index);
     void filteringChanged(int index);
     void wrapChanged(int index);
 
 private:
+    bool selectTextureFile();
+    void showTextureFile(const QString &fileName);
+
     Ui::ChannelSettings *ui;
+    /// input box item data for static texture file input
+    static const int textureFileInput = -2;
+    int previousInputIndex;
 };
 
 #endif // CHANNELSETTINGS_H
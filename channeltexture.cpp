@@ -0,0 +1,436 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "channeltexture.h"
+#include "audiotexture.h"
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QVector>
+#include <QPair>
+#include <QObject>
+#include <QtEndian>
+#include <cstring>
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+#endif
+#ifndef GL_COMPRESSED_RG_RGTC2
+#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#endif
+#ifndef GL_R16
+#define GL_R16 0x822A
+#endif
+
+namespace {
+
+/// memory-mapped view of the whole file, unmapped on destruction
+class MappedFile
+{
+public:
+    explicit MappedFile(const QString &fileName) :
+        file(fileName),
+        data(Q_NULLPTR),
+        size(0)
+    {
+        if (file.open(QFile::ReadOnly)) {
+            size = file.size();
+            data = size > 0 ? file.map(0, size) : Q_NULLPTR;
+        }
+    }
+
+    ~MappedFile()
+    {
+        if (data) {
+            file.unmap(data);
+        }
+    }
+
+    QFile file;
+    uchar *data;
+    qint64 size;
+};
+
+/// texture upload parameters shared by all supported file formats
+struct TextureLayout
+{
+    TextureLayout() :
+        target(GL_TEXTURE_2D),
+        compressed(false),
+        internalFormat(0),
+        format(0),
+        type(0),
+        alignment(4),
+        width(0),
+        height(0),
+        depth(0)
+    {
+    }
+
+    GLenum target;
+    bool compressed;
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    GLint alignment;
+    GLsizei width;
+    GLsizei height;
+    GLsizei depth;
+    /// pointer to and size of each mip level inside mapped file
+    QVector<QPair<const uchar*, GLsizei>> levels;
+};
+
+quint32 readUInt32(const uchar *data, bool swap)
+{
+    quint32 value = qFromLittleEndian<quint32>(data);
+
+    return swap ? qbswap(value) : value;
+}
+
+bool parseKtx(const MappedFile &file, TextureLayout &layout, QString &error)
+{
+    static const uchar identifier[12] = {
+        0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+    };
+    const qint64 headerSize = 64;
+
+    if (file.size < headerSize || memcmp(file.data, identifier, 12)) {
+        error = QObject::tr("Not a KTX 1.1 file");
+        return false;
+    }
+
+    const uchar *header = file.data + 12;
+    bool swap = readUInt32(header, false) != 0x04030201;
+
+    layout.type = readUInt32(header + 4, swap);
+    layout.format = readUInt32(header + 12, swap);
+    layout.internalFormat = readUInt32(header + 16, swap);
+    layout.width = readUInt32(header + 24, swap);
+    layout.height = readUInt32(header + 28, swap);
+    layout.depth = readUInt32(header + 32, swap);
+    quint32 arrayElements = readUInt32(header + 36, swap);
+    quint32 faces = readUInt32(header + 40, swap);
+    quint32 mipLevels = qMax(1u, readUInt32(header + 44, swap));
+    quint32 keyValueBytes = readUInt32(header + 48, swap);
+
+    if (arrayElements > 0 || faces != 1 || layout.height == 0) {
+        error = QObject::tr("Only 2D and 3D KTX textures are supported");
+        return false;
+    }
+
+    layout.compressed = layout.type == 0;
+    layout.target = layout.depth > 0 ? GL_TEXTURE_3D : GL_TEXTURE_2D;
+
+    qint64 offset = headerSize + keyValueBytes;
+
+    for (quint32 level = 0; level < mipLevels; level++) {
+        if (offset + 4 > file.size) {
+            break;
+        }
+
+        quint32 imageSize = readUInt32(file.data + offset, swap);
+        offset += 4;
+
+        if (offset + imageSize > file.size) {
+            error = QObject::tr("KTX mip level %1 is truncated").arg(level);
+            return false;
+        }
+
+        layout.levels.append(qMakePair(static_cast<const uchar*>(file.data + offset),
+                                       static_cast<GLsizei>(imageSize)));
+        // mip levels are padded to 4 bytes
+        offset += (imageSize + 3) & ~3u;
+    }
+
+    if (layout.levels.isEmpty()) {
+        error = QObject::tr("KTX file has no image data");
+        return false;
+    }
+
+    return true;
+}
+
+bool parseDds(const MappedFile &file, TextureLayout &layout, QString &error)
+{
+    // magic + DDS_HEADER
+    const qint64 headerSize = 4 + 124;
+
+    if (file.size < headerSize || memcmp(file.data, "DDS ", 4)) {
+        error = QObject::tr("Not a DDS file");
+        return false;
+    }
+
+    const uchar *header = file.data + 4;
+
+    layout.height = readUInt32(header + 8, false);
+    layout.width = readUInt32(header + 12, false);
+    quint32 mipLevels = qMax(1u, readUInt32(header + 24, false));
+    // DDS_PIXELFORMAT starts at offset 72, FourCC at 80
+    const uchar *fourCC = header + 80;
+    GLsizei blockSize = 16;
+
+    if (!memcmp(fourCC, "DXT1", 4)) {
+        layout.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        blockSize = 8;
+    }
+    else if (!memcmp(fourCC, "DXT3", 4)) {
+        layout.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    }
+    else if (!memcmp(fourCC, "DXT5", 4)) {
+        layout.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    else if (!memcmp(fourCC, "ATI1", 4) || !memcmp(fourCC, "BC4U", 4)) {
+        layout.internalFormat = GL_COMPRESSED_RED_RGTC1;
+        blockSize = 8;
+    }
+    else if (!memcmp(fourCC, "ATI2", 4) || !memcmp(fourCC, "BC5U", 4)) {
+        layout.internalFormat = GL_COMPRESSED_RG_RGTC2;
+    }
+    else {
+        error = QObject::tr("Unsupported DDS pixel format, "
+                            "expected DXT1, DXT3, DXT5, BC4 or BC5");
+        return false;
+    }
+
+    layout.compressed = true;
+
+    qint64 offset = headerSize;
+    GLsizei width = layout.width;
+    GLsizei height = layout.height;
+
+    for (quint32 level = 0; level < mipLevels; level++) {
+        GLsizei size = qMax(1, (width + 3) / 4) * qMax(1, (height + 3) / 4) * blockSize;
+
+        if (offset + size > file.size) {
+            error = QObject::tr("DDS mip level %1 is truncated").arg(level);
+            return false;
+        }
+
+        layout.levels.append(qMakePair(static_cast<const uchar*>(file.data + offset), size));
+
+        offset += size;
+        width = qMax(1, width / 2);
+        height = qMax(1, height / 2);
+    }
+
+    return true;
+}
+
+bool parseRawVolume(const QString &fileName, const MappedFile &file,
+                    TextureLayout &layout, QString &error)
+{
+    // volume dimensions are encoded in file name: 'name_<W>x<H>x<D>.raw'
+    QRegularExpression re("_(\\d+)x(\\d+)x(\\d+)$");
+    auto match = re.match(QFileInfo(fileName).completeBaseName());
+
+    if (!match.hasMatch()) {
+        error = QObject::tr("Raw volume file name must end with "
+                            "'_<width>x<height>x<depth>'");
+        return false;
+    }
+
+    layout.width = match.captured(1).toInt();
+    layout.height = match.captured(2).toInt();
+    layout.depth = match.captured(3).toInt();
+
+    qint64 voxels = qint64(layout.width) * layout.height * layout.depth;
+
+    if (voxels == 0 || file.size % voxels) {
+        error = QObject::tr("Raw volume file size does not match its dimensions");
+        return false;
+    }
+
+    // voxel format is deduced from file size: 8, 16 bit normalized or float
+    switch (file.size / voxels) {
+    case 1:
+        layout.internalFormat = GL_R8;
+        layout.type = GL_UNSIGNED_BYTE;
+        break;
+    case 2:
+        layout.internalFormat = GL_R16;
+        layout.type = GL_UNSIGNED_SHORT;
+        break;
+    case 4:
+        layout.internalFormat = GL_R32F;
+        layout.type = GL_FLOAT;
+        break;
+    default:
+        error = QObject::tr("Raw volume voxels must be 1, 2 or 4 bytes in size");
+        return false;
+    }
+
+    layout.target = GL_TEXTURE_3D;
+    layout.format = GL_RED;
+    layout.alignment = 1;
+    layout.levels.append(qMakePair(static_cast<const uchar*>(file.data),
+                                   static_cast<GLsizei>(file.size)));
+
+    return true;
+}
+
+void uploadLevels(QOpenGLExtraFunctions *gl, const TextureLayout &layout)
+{
+    GLsizei width = layout.width;
+    GLsizei height = layout.height;
+    GLsizei depth = layout.depth;
+
+    for (int level = 0; level < layout.levels.size(); level++) {
+        const uchar *data = layout.levels[level].first;
+        GLsizei size = layout.levels[level].second;
+
+        if (layout.target == GL_TEXTURE_3D) {
+            if (layout.compressed) {
+                gl->glCompressedTexImage3D(GL_TEXTURE_3D, level, layout.internalFormat,
+                                           width, height, depth, 0, size, data);
+            }
+            else {
+                gl->glTexImage3D(GL_TEXTURE_3D, level, layout.internalFormat,
+                                 width, height, depth, 0, layout.format, layout.type, data);
+            }
+        }
+        else {
+            if (layout.compressed) {
+                gl->glCompressedTexImage2D(GL_TEXTURE_2D, level, layout.internalFormat,
+                                           width, height, 0, size, data);
+            }
+            else {
+                gl->glTexImage2D(GL_TEXTURE_2D, level, layout.internalFormat,
+                                 width, height, 0, layout.format, layout.type, data);
+            }
+        }
+
+        width = qMax(1, width / 2);
+        height = qMax(1, height / 2);
+        depth = qMax(1, depth / 2);
+    }
+}
+
+} // namespace
+
+ChannelTexture::ChannelTexture(GLenum target, GLuint id, bool mipmaps) :
+    target(target),
+    id(id),
+    mipmaps(mipmaps),
+    revision(0)
+{
+}
+
+ChannelTexture::~ChannelTexture()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+
+    Q_ASSERT(context != Q_NULLPTR);
+
+    context->functions()->glDeleteTextures(1, &id);
+}
+
+void ChannelTexture::update(float time)
+{
+    Q_UNUSED(time);
+}
+
+ChannelTexture* ChannelTexture::load(const QString &fileName, QString &error)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+
+    if (suffix == "wav") {
+        return AudioTexture::load(fileName, error);
+    }
+
+    MappedFile file(fileName);
+
+    if (!file.data) {
+        error = file.file.errorString();
+        return Q_NULLPTR;
+    }
+
+    TextureLayout layout;
+    bool parsed = false;
+
+    if (suffix == "ktx") {
+        parsed = parseKtx(file, layout, error);
+    }
+    else if (suffix == "dds") {
+        parsed = parseDds(file, layout, error);
+    }
+    else if (suffix == "raw") {
+        parsed = parseRawVolume(fileName, file, layout, error);
+    }
+    else {
+        error = QObject::tr("Unknown texture file format '%1'").arg(suffix);
+    }
+
+    if (!parsed) {
+        return Q_NULLPTR;
+    }
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+
+    Q_ASSERT(context != Q_NULLPTR);
+
+    QOpenGLExtraFunctions *gl = context->extraFunctions();
+    GLuint id = 0;
+
+    gl->glGenTextures(1, &id);
+    gl->glBindTexture(layout.target, id);
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, layout.alignment);
+
+    // driver copies data directly from mapped file pages
+    uploadLevels(gl, layout);
+
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    bool mipmaps = layout.levels.size() > 1;
+
+    if (mipmaps) {
+        gl->glTexParameteri(layout.target, GL_TEXTURE_MAX_LEVEL, layout.levels.size() - 1);
+    }
+    else if (!layout.compressed) {
+        // texture is static, build mip chain only once
+        gl->glGenerateMipmap(layout.target);
+        mipmaps = true;
+    }
+    else {
+        gl->glTexParameteri(layout.target, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+
+    gl->glBindTexture(layout.target, 0);
+
+    if (gl->glGetError() != GL_NO_ERROR) {
+        gl->glDeleteTextures(1, &id);
+        error = QObject::tr("OpenGL could not create texture from %1, "
+                            "format may be unsupported by driver").arg(fileName);
+        return Q_NULLPTR;
+    }
+
+    ChannelTexture *texture = new ChannelTexture(layout.target, id, mipmaps);
+    texture->fileName = fileName;
+
+    return texture;
+}
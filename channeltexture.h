@@ -0,0 +1,57 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHANNELTEXTURE_H
+#define CHANNELTEXTURE_H
+
+#include <QOpenGLFunctions>
+#include <QString>
+
+/// Texture loaded from file and used as effect input channel.
+/// Supported files are uploaded straight from memory-mapped file data:
+/// KTX (2D or 3D, compressed or not), DDS (BC1-BC5 compressed 2D)
+/// and raw 3D volumes named like 'density_256x256x256.raw'.
+/// WAV files are loaded as audio textures
+class ChannelTexture
+{
+public:
+    ChannelTexture(GLenum target, GLuint id, bool mipmaps);
+    /// OpenGL context used to load texture must be current
+    virtual ~ChannelTexture();
+
+    /// update texture contents for current frame time in seconds.
+    /// Called before texture is bound, OpenGL context is current
+    virtual void update(float time);
+
+    /// load texture from file, return Q_NULLPTR and fill error on failure.
+    /// OpenGL context must be current
+    static ChannelTexture* load(const QString &fileName, QString &error);
+
+    /// texture target: GL_TEXTURE_2D or GL_TEXTURE_3D
+    GLenum target;
+    /// OpenGL texture object name
+    GLuint id;
+    /// true if texture has complete mipmap chain
+    bool mipmaps;
+    /// file texture was loaded from
+    QString fileName;
+    /// incremented each time texture contents change after loading
+    quint64 revision;
+};
+
+#endif // CHANNELTEXTURE_H
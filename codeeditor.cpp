@@ -20,12 +20,44 @@
 #include "linenumberarea.h"
 #include <QPainter>
 #include <QTextBlock>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QCompleter>
+#include <QAbstractItemView>
+#include <QScrollBar>
+
+namespace {
+
+/// approximate size in characters of text appended at once when loading
+const int chunkSize = 64 * 1024;
+/// time spent appending chunks per event loop iteration
+const int loadSliceMs = 16;
+/// identifier characters typed before completion popup is shown
+const int completionPrefixLength = 3;
+
+} // namespace
 
 CodeEditor::CodeEditor(QWidget *parent) :
     QPlainTextEdit(parent),
     lineNumberArea(new LineNumberArea(this)),
-    lineHighlightColor("#e9ffcc")
+    lineHighlightColor("#e9ffcc"),
+    loadTimer(new QTimer(this)),
+    completer(new QCompleter(this)),
+    loadedLength(0),
+    firstVisible(-1),
+    lastVisible(-1)
 {
+    loadTimer->setSingleShot(true);
+    loadTimer->setInterval(0);
+
+    connect(loadTimer, SIGNAL(timeout()), this, SLOT(loadNextChunks()));
+
+    completer->setWidget(this);
+    completer->setCompletionMode(QCompleter::PopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseSensitive);
+    completer->setModelSorting(QCompleter::CaseSensitivelySortedModel);
+
+    connect(completer, SIGNAL(activated(QString)), this, SLOT(insertCompletion(QString)));
     connect(this, SIGNAL(blockCountChanged(int)),
             this, SLOT(updateLineNumberAreaWidth(int)));
     connect(this, SIGNAL(updateRequest(QRect,int)),
@@ -86,6 +118,44 @@ void CodeEditor::highlightLine(int line)
     setTextCursor(cur);
 }
 
+QString CodeEditor::source() const
+{
+    return isLoading() ? loadingSource : toPlainText();
+}
+
+void CodeEditor::setSource(const QString &source)
+{
+    loadTimer->stop();
+
+    if (source.size() <= chunkSize) {
+        loadingSource.clear();
+        setReadOnly(false);
+        setUndoRedoEnabled(true);
+        setPlainText(source);
+        return;
+    }
+
+    // show beginning of the file right away, the rest is appended later
+    loadingSource = source;
+    loadedLength = chunkEnd(0);
+
+    setUndoRedoEnabled(false);
+    setReadOnly(true);
+    setPlainText(source.left(loadedLength));
+
+    loadTimer->start();
+}
+
+bool CodeEditor::isLoading() const
+{
+    return !loadingSource.isNull();
+}
+
+void CodeEditor::setCompletionModel(QAbstractItemModel *model)
+{
+    completer->setModel(model);
+}
+
 void CodeEditor::resizeEvent(QResizeEvent *e)
 {
     QPlainTextEdit::resizeEvent(e);
@@ -97,6 +167,46 @@ void CodeEditor::resizeEvent(QResizeEvent *e)
 
 void CodeEditor::keyPressEvent(QKeyEvent *e)
 {
+    if (completer->popup()->isVisible()) {
+        // keys used by completion popup
+        switch (e->key()) {
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+        case Qt::Key_Escape:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+            e->ignore();
+            return;
+        default:
+            break;
+        }
+    }
+
+    if (e->key() == Qt::Key_F12) {
+        const QString name = wordUnderCursor();
+
+        if (!name.isEmpty()) {
+            if (e->modifiers() & Qt::ShiftModifier) {
+                emit usagesRequested(name);
+            }
+            else {
+                emit definitionRequested(name);
+            }
+        }
+
+        e->accept();
+        return;
+    }
+
+    const bool completionShortcut = (e->modifiers() & Qt::ControlModifier)
+            && e->key() == Qt::Key_Space;
+
+    if (completionShortcut) {
+        updateCompletion(true, QString());
+        e->accept();
+        return;
+    }
+
     // insert 4 spaces instead of TAB
     if (e->key() == Qt::Key_Tab) {
         insertPlainText("    ");
@@ -105,6 +215,8 @@ void CodeEditor::keyPressEvent(QKeyEvent *e)
     }
 
     QPlainTextEdit::keyPressEvent(e);
+
+    updateCompletion(false, e->text());
 }
 
 void CodeEditor::updateLineNumberAreaWidth(int)
@@ -142,4 +254,110 @@ void CodeEditor::updateLineNumberArea(const QRect &rect, int dy)
     if (rect.contains(viewport()->rect())) {
         updateLineNumberAreaWidth(0);
     }
+
+    updateVisibleBlocks();
+}
+
+void CodeEditor::loadNextChunks()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+
+    while (loadedLength < loadingSource.size() && elapsed.elapsed() < loadSliceMs) {
+        const int end = chunkEnd(loadedLength);
+
+        cursor.insertText(loadingSource.mid(loadedLength, end - loadedLength));
+        loadedLength = end;
+    }
+
+    if (loadedLength < loadingSource.size()) {
+        loadTimer->start();
+        return;
+    }
+
+    loadingSource.clear();
+    loadedLength = 0;
+
+    setReadOnly(false);
+    setUndoRedoEnabled(true);
+    document()->setModified(false);
+    highlightCurrentLine();
+}
+
+void CodeEditor::updateVisibleBlocks()
+{
+    QTextBlock block = firstVisibleBlock();
+    const int first = block.blockNumber();
+    const int height = viewport()->height();
+    int last = first;
+    int top = (int)blockBoundingGeometry(block).translated(contentOffset()).top();
+
+    while (block.isValid() && top <= height) {
+        top += (int)blockBoundingRect(block).height();
+        block = block.next();
+        last++;
+    }
+
+    if (first != firstVisible || last != lastVisible) {
+        firstVisible = first;
+        lastVisible = last;
+
+        emit visibleBlocksChanged(first, last);
+    }
+}
+
+void CodeEditor::insertCompletion(const QString &completion)
+{
+    QTextCursor cursor = textCursor();
+    const int missing = completion.length() - completer->completionPrefix().length();
+
+    cursor.movePosition(QTextCursor::Left);
+    cursor.movePosition(QTextCursor::EndOfWord);
+    cursor.insertText(completion.right(missing));
+
+    setTextCursor(cursor);
+}
+
+void CodeEditor::updateCompletion(bool forced, const QString &typed)
+{
+    QAbstractItemView *popup = completer->popup();
+    const QString prefix = wordUnderCursor();
+    const bool identifierTyped = !typed.isEmpty()
+            && (typed.at(typed.size() - 1).isLetterOrNumber() || typed.endsWith('_'));
+
+    if (isReadOnly() || (!forced && (!identifierTyped
+                                     || prefix.length() < completionPrefixLength))) {
+        popup->hide();
+        return;
+    }
+
+    if (prefix != completer->completionPrefix()) {
+        completer->setCompletionPrefix(prefix);
+        popup->setCurrentIndex(completer->completionModel()->index(0, 0));
+    }
+
+    QRect rect = cursorRect();
+    rect.setWidth(popup->sizeHintForColumn(0) + popup->verticalScrollBar()->sizeHint().width());
+
+    completer->complete(rect);
+}
+
+QString CodeEditor::wordUnderCursor() const
+{
+    QTextCursor cursor = textCursor();
+
+    cursor.select(QTextCursor::WordUnderCursor);
+
+    return cursor.selectedText();
+}
+
+int CodeEditor::chunkEnd(int position) const
+{
+    // chunks end at line breaks
+    const int end = loadingSource.indexOf('\n', position + chunkSize);
+
+    return end < 0 ? loadingSource.size() : end + 1;
 }
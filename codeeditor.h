@@ -21,6 +21,10 @@
 
 #include <QPlainTextEdit>
 
+class QTimer;
+class QCompleter;
+class QAbstractItemModel;
+
 class CodeEditor : public QPlainTextEdit
 {
     Q_OBJECT
@@ -33,6 +37,24 @@ public:
 
     void highlightLine(int line);
 
+    /// full source text, including parts that are not loaded yet
+    QString source() const;
+    /// replace editor text. Large sources are appended in chunks
+    /// in background, editor is read-only until loading is finished
+    void setSource(const QString &source);
+    bool isLoading() const;
+
+    /// words offered while typing identifiers or on Ctrl+Space
+    void setCompletionModel(QAbstractItemModel *model);
+
+signals:
+    /// range of block numbers shown in editor changed
+    void visibleBlocksChanged(int first, int last);
+    /// F12 pressed on identifier
+    void definitionRequested(const QString &name);
+    /// Shift+F12 pressed on identifier
+    void usagesRequested(const QString &name);
+
 protected:
     void resizeEvent(QResizeEvent *e) Q_DECL_OVERRIDE;
     void keyPressEvent(QKeyEvent *e) Q_DECL_OVERRIDE;
@@ -41,10 +63,27 @@ private slots:
     void updateLineNumberAreaWidth(int newBlockCount);
     void highlightCurrentLine();
     void updateLineNumberArea(const QRect &rect, int dy);
+    void loadNextChunks();
+    void insertCompletion(const QString &completion);
 
 private:
+    void updateVisibleBlocks();
+    /// show, update or hide completion popup after key press
+    void updateCompletion(bool forced, const QString &typed);
+    QString wordUnderCursor() const;
+    /// position after end of chunk starting at specified position
+    int chunkEnd(int position) const;
+
     QWidget *lineNumberArea;
     QColor lineHighlightColor;
+    QTimer *loadTimer;
+    QCompleter *completer;
+    /// source being loaded, null if there is no loading in progress
+    QString loadingSource;
+    /// position in loading source up to which text is already in editor
+    int loadedLength;
+    int firstVisible;
+    int lastVisible;
 };
 
 #endif // CODEEDITOR_H
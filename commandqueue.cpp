@@ -0,0 +1,69 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commandqueue.h"
+#include <QThread>
+
+CommandQueue::CommandQueue(int capacity) :
+    // one slot stays empty to tell full queue from empty one
+    commands(capacity + 1),
+    head(0),
+    tail(0)
+{
+    Q_ASSERT(capacity > 0);
+}
+
+void CommandQueue::push(const std::function<void()> &command)
+{
+    // consumer frees slots as it runs commands
+    while (!tryPush(command)) {
+        QThread::yieldCurrentThread();
+    }
+}
+
+bool CommandQueue::tryPush(const std::function<void()> &command)
+{
+    const int current = tail.load();
+    const int next = (current + 1) % int(commands.size());
+
+    if (next == head.loadAcquire()) {
+        return false;
+    }
+
+    commands[current] = command;
+    // publish command together with new tail
+    tail.storeRelease(next);
+
+    return true;
+}
+
+bool CommandQueue::pop(std::function<void()> &command)
+{
+    const int current = head.load();
+
+    if (current == tail.loadAcquire()) {
+        return false;
+    }
+
+    command = std::move(commands[current]);
+    // release captured state now, not when slot is reused
+    commands[current] = nullptr;
+    head.storeRelease((current + 1) % int(commands.size()));
+
+    return true;
+}
@@ -0,0 +1,50 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <QAtomicInt>
+#include <functional>
+#include <vector>
+
+/// Fixed size ring of commands passed from one producer thread to one
+/// consumer thread without locking. Producer owns tail, consumer owns head,
+/// each of them only reads the other one
+class CommandQueue
+{
+public:
+    explicit CommandQueue(int capacity);
+
+    /// add command to queue, waits while queue is full. Producer thread only
+    void push(const std::function<void()> &command);
+    /// add command to queue, false if queue is full. Producer thread only
+    bool tryPush(const std::function<void()> &command);
+    /// take oldest command, false if queue is empty. Consumer thread only
+    bool pop(std::function<void()> &command);
+
+private:
+    /// ring is written by both threads, unlike QVector it never detaches
+    std::vector<std::function<void()>> commands;
+    /// next slot to pop, written by consumer
+    QAtomicInt head;
+    /// next slot to push, written by producer
+    QAtomicInt tail;
+};
+
+#endif // COMMANDQUEUE_H
@@ -0,0 +1,291 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "costheatmap.h"
+#include <QOpenGLShaderProgram>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTimerQuery>
+#include <QOpenGLContext>
+
+namespace {
+
+/// tile side in pixels
+const int tileSize = 32;
+/// tiles timed each frame
+const int tilesPerFrame = 32;
+/// queries waiting for results at most
+const int maxQueries = 256;
+/// weight of new measurement in tile average
+const float smoothing = 0.25f;
+
+const char overlaySource[] =
+    "#version 330 core\n"
+    "out vec4 fragColor;\n"
+    "uniform sampler2D costs;\n"
+    "uniform vec2 viewSize;\n"
+    "uniform float maxCost;\n"
+    "void main() {\n"
+    "    ivec2 grid = textureSize(costs, 0);\n"
+    "    ivec2 tile = min(ivec2(gl_FragCoord.xy / viewSize * vec2(grid)), grid - 1);\n"
+    "    float cost = texelFetch(costs, tile, 0).r;\n"
+    "    if (cost < 0.0) {\n"
+    "        discard;\n"
+    "    }\n"
+    "    float t = cost / maxCost;\n"
+    "    vec3 cheap = mix(vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0), clamp(t * 2.0, 0.0, 1.0));\n"
+    "    vec3 color = mix(cheap, vec3(1.0, 0.0, 0.0), clamp(t * 2.0 - 1.0, 0.0, 1.0));\n"
+    "    fragColor = vec4(color, 0.45);\n"
+    "}\n";
+
+} // namespace
+
+CostHeatmap::CostHeatmap() :
+    program(Q_NULLPTR),
+    framebuffer(Q_NULLPTR),
+    costTexture(0),
+    queryCount(0),
+    nextTile(0),
+    supported(false)
+{
+}
+
+CostHeatmap::~CostHeatmap()
+{
+    Q_ASSERT(program == Q_NULLPTR);
+}
+
+bool CostHeatmap::create(QOpenGLShader *vertexShader)
+{
+    initializeOpenGLFunctions();
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+
+    supported = !context->isOpenGLES()
+            && (context->format().version() >= qMakePair(3, 3)
+                || context->hasExtension("GL_ARB_timer_query"));
+
+    if (!supported) {
+        return false;
+    }
+
+    program = new QOpenGLShaderProgram();
+
+    bool result = program->addShader(vertexShader);
+
+    Q_ASSERT(result == true);
+
+    result = program->addShaderFromSourceCode(QOpenGLShader::Fragment, overlaySource);
+
+    Q_ASSERT(result == true);
+
+    result = program->link();
+
+    Q_ASSERT(result == true);
+
+    glGenTextures(1, &costTexture);
+    glBindTexture(GL_TEXTURE_2D, costTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
+void CostHeatmap::destroy()
+{
+    for (const auto &item : pending) {
+        delete item.query;
+    }
+
+    pending.clear();
+    qDeleteAll(freeQueries);
+    freeQueries.clear();
+    queryCount = 0;
+
+    delete framebuffer;
+    framebuffer = Q_NULLPTR;
+
+    delete program;
+    program = Q_NULLPTR;
+
+    if (costTexture) {
+        glDeleteTextures(1, &costTexture);
+        costTexture = 0;
+    }
+}
+
+void CostHeatmap::reset()
+{
+    for (const auto &item : pending) {
+        freeQueries.append(item.query);
+    }
+
+    pending.clear();
+    costs.fill(-1.0f);
+    nextTile = 0;
+}
+
+void CostHeatmap::measure(QSize size, GLenum format, const std::function<void()> &draw)
+{
+    if (!supported) {
+        return;
+    }
+
+    collectResults();
+
+    if (size != passSize || !framebuffer
+            || framebuffer->format().internalTextureFormat() != format) {
+        resize(size, format);
+    }
+
+    const int tileCount = grid.width() * grid.height();
+
+    framebuffer->bind();
+    glViewport(0, 0, size.width(), size.height());
+    glEnable(GL_SCISSOR_TEST);
+
+    for (int i = 0; i < tilesPerFrame; i++) {
+        QOpenGLTimerQuery *query = takeQuery();
+
+        if (!query) {
+            // GPU is behind, measure more tiles later
+            break;
+        }
+
+        const int tile = nextTile;
+        const int x = tile % grid.width() * tileSize;
+        const int y = tile / grid.width() * tileSize;
+
+        nextTile = (nextTile + 1) % tileCount;
+
+        glScissor(x, y, tileSize, tileSize);
+
+        query->begin();
+        draw();
+        query->end();
+
+        pending.append(PendingTile{query, tile});
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+
+    uploadCosts();
+}
+
+void CostHeatmap::drawOverlay(QSize viewSize)
+{
+    if (!supported || costs.isEmpty()) {
+        return;
+    }
+
+    float maxCost = 0.0f;
+
+    for (float cost : costs) {
+        maxCost = qMax(maxCost, cost);
+    }
+
+    if (maxCost <= 0.0f) {
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, costTexture);
+
+    program->bind();
+    program->setUniformValue("costs", 0);
+    program->setUniformValue("viewSize", QSizeF(viewSize));
+    program->setUniformValue("maxCost", maxCost);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glDisable(GL_BLEND);
+}
+
+void CostHeatmap::collectResults()
+{
+    for (int i = 0; i < pending.size();) {
+        const PendingTile &item = pending[i];
+
+        if (!item.query->isResultAvailable()) {
+            i++;
+            continue;
+        }
+
+        const float time = item.query->waitForResult();
+
+        if (item.tile < costs.size()) {
+            float &cost = costs[item.tile];
+
+            cost = cost < 0.0f ? time : cost + smoothing * (time - cost);
+        }
+
+        freeQueries.append(item.query);
+        pending.remove(i);
+    }
+}
+
+QOpenGLTimerQuery* CostHeatmap::takeQuery()
+{
+    if (!freeQueries.isEmpty()) {
+        return freeQueries.takeLast();
+    }
+
+    if (queryCount == maxQueries) {
+        return Q_NULLPTR;
+    }
+
+    QOpenGLTimerQuery *query = new QOpenGLTimerQuery();
+
+    query->create();
+    queryCount++;
+
+    return query;
+}
+
+void CostHeatmap::resize(QSize size, GLenum format)
+{
+    delete framebuffer;
+    framebuffer = new QOpenGLFramebufferObject(size, QOpenGLFramebufferObject::NoAttachment,
+                                               GL_TEXTURE_2D, format);
+
+    if (size != passSize) {
+        passSize = size;
+        grid = QSize((size.width() + tileSize - 1) / tileSize,
+                     (size.height() + tileSize - 1) / tileSize);
+
+        // results of pending queries refer to old tiles
+        for (const auto &item : pending) {
+            freeQueries.append(item.query);
+        }
+
+        pending.clear();
+        costs.fill(-1.0f, grid.width() * grid.height());
+        nextTile = 0;
+    }
+}
+
+void CostHeatmap::uploadCosts()
+{
+    glBindTexture(GL_TEXTURE_2D, costTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, grid.width(), grid.height(), 0,
+                 GL_RED, GL_FLOAT, costs.constData());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef COSTHEATMAP_H
+#define COSTHEATMAP_H
+
+#include <QOpenGLExtraFunctions>
+#include <QVector>
+#include <QSize>
+#include <functional>
+
+class QOpenGLShader;
+class QOpenGLShaderProgram;
+class QOpenGLFramebufferObject;
+class QOpenGLTimerQuery;
+
+/// Measures how much rendering of each screen tile of a pass costs
+/// and draws the result as colored overlay.
+/// Only a few tiles are timed each frame, into a scratch framebuffer,
+/// so measuring neither blocks rendering nor changes pass outputs.
+/// OpenGL context must be current for all methods
+class CostHeatmap : protected QOpenGLExtraFunctions
+{
+public:
+    CostHeatmap();
+    ~CostHeatmap();
+
+    /// vertex shader must draw full screen quad from currently bound buffers.
+    /// Returns false if timer queries are not supported
+    bool create(QOpenGLShader *vertexShader);
+    void destroy();
+
+    /// forget measured costs
+    void reset();
+    /// time next tiles of pass with specified size, draw renders pass
+    /// with its textures already bound
+    void measure(QSize size, GLenum format, const std::function<void()> &draw);
+    /// blend costs measured so far over currently bound framebuffer
+    void drawOverlay(QSize viewSize);
+
+private:
+    struct PendingTile
+    {
+        QOpenGLTimerQuery *query;
+        int tile;
+    };
+
+    /// read finished queries without waiting for the rest
+    void collectResults();
+    QOpenGLTimerQuery* takeQuery();
+    void resize(QSize size, GLenum format);
+    void uploadCosts();
+
+    QOpenGLShaderProgram *program;
+    QOpenGLFramebufferObject *framebuffer;
+    GLuint costTexture;
+    QVector<QOpenGLTimerQuery*> freeQueries;
+    QVector<PendingTile> pending;
+    int queryCount;
+    QSize passSize;
+    QSize grid;
+    /// average time of each tile in nanoseconds, negative if not measured yet
+    QVector<float> costs;
+    /// next tile to measure
+    int nextTile;
+    bool supported;
+};
+
+#endif // COSTHEATMAP_H
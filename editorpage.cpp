@@ -20,7 +20,15 @@
 #include "glslhighlighter.h"
 #include "codeeditor.h"
 #include "channelsettings.h"
+#include "parameterswidget.h"
+#include "effect.h"
+#include "shaderlog.h"
 #include "ui_editorpage.h"
+#include <QTextBlock>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QLabel>
+#include <QHBoxLayout>
 
 EditorPage::EditorPage(int pageIndex, const PagesData &data, QWidget *parent) :
     QWidget(parent),
@@ -36,6 +44,21 @@ EditorPage::EditorPage(int pageIndex, const PagesData &data, QWidget *parent) :
 
     highlighter = new GLSLHighlighter(editor->document());
 
+    connect(editor, SIGNAL(visibleBlocksChanged(int,int)),
+            highlighter, SLOT(setVisibleBlocks(int,int)));
+    connect(editor, SIGNAL(definitionRequested(QString)),
+            this, SIGNAL(definitionRequested(QString)));
+    connect(editor, SIGNAL(usagesRequested(QString)),
+            this, SIGNAL(usagesRequested(QString)));
+
+    parametersWidget = new ParametersWidget(this);
+    ui->verticalLayout->addWidget(parametersWidget);
+
+    setupUpdatePolicy();
+
+    connect(parametersWidget, SIGNAL(parameterChanged(QString,QVector4D)),
+            this, SLOT(onParameterChanged(QString,QVector4D)));
+
     connect(logList, SIGNAL(itemDoubleClicked(QListWidgetItem*)),
             this, SLOT(logMessageSelected(QListWidgetItem*)));
 }
@@ -47,17 +70,39 @@ EditorPage::~EditorPage()
 
 QString EditorPage::shaderSource() const
 {
-    return editor->toPlainText();
+    return editor->source();
 }
 
 void EditorPage::setShaderSource(const QString &source)
 {
-    editor->setPlainText(source);
+    editor->setSource(source);
 }
 
 bool EditorPage::isShaderSourceModified() const
 {
-    return editor->document()->isModified();
+    // appending loaded chunks is not a modification
+    return !editor->isLoading() && editor->document()->isModified();
+}
+
+QTextDocument* EditorPage::document() const
+{
+    return editor->document();
+}
+
+QString EditorPage::lineText(int line) const
+{
+    return editor->document()->findBlockByNumber(line - 1).text();
+}
+
+void EditorPage::showLine(int line)
+{
+    editor->highlightLine(line);
+    editor->setFocus();
+}
+
+void EditorPage::setCompletionModel(QAbstractItemModel *model)
+{
+    editor->setCompletionModel(model);
 }
 
 void EditorPage::shaderLogUpdated(const QString &log)
@@ -80,6 +125,76 @@ void EditorPage::clearShaderLog()
     logList->hide();
 }
 
+void EditorPage::resetChannelInput(int channelNumber)
+{
+    Q_ASSERT(channelNumber >= 0 && channelNumber < channels.size());
+
+    channels[channelNumber]->resetInput();
+}
+
+void EditorPage::setParameters(const QList<ShaderParameter> &parameters)
+{
+    parametersWidget->setParameters(parameters);
+}
+
+QList<ShaderParameter> EditorPage::parameters() const
+{
+    return parametersWidget->parameters();
+}
+
+void EditorPage::setParameterValues(const QHash<QString, QVector4D> &values)
+{
+    parametersWidget->setValues(values);
+}
+
+void EditorPage::setUpdatePolicyEnabled(bool enabled)
+{
+    updatePolicyWidget->setVisible(enabled);
+}
+
+int EditorPage::updateMode() const
+{
+    return updateModeBox->currentData().toInt();
+}
+
+int EditorPage::updateValue() const
+{
+    return updateValueBox->value();
+}
+
+void EditorPage::setUpdatePolicy(int mode, int value)
+{
+    const QSignalBlocker modeBlocker(updateModeBox);
+    const QSignalBlocker valueBlocker(updateValueBox);
+    const int index = updateModeBox->findData(mode);
+
+    updateModeBox->setCurrentIndex(qMax(index, 0));
+    updateValueBox->setValue(value);
+
+    onUpdatePolicyChanged();
+}
+
+int EditorPage::channelCount() const
+{
+    return channels.size();
+}
+
+void EditorPage::setChannelCount(int count)
+{
+    if (inputPages.isEmpty()) {
+        return;
+    }
+
+    channelCountBox->setValue(count);
+}
+
+ChannelSettings* EditorPage::channelSettings(int channelNumber) const
+{
+    Q_ASSERT(channelNumber >= 0 && channelNumber < channels.size());
+
+    return channels[channelNumber];
+}
+
 void EditorPage::logMessageSelected(QListWidgetItem *item)
 {
     int line = 1;
@@ -114,39 +229,157 @@ void EditorPage::onChannelWrapChanged(GLint value)
     emit channelWrapChanged(pageIndex, num, value);
 }
 
+void EditorPage::onChannelTextureChanged(const QString &fileName)
+{
+    ChannelSettings *channel = qobject_cast<ChannelSettings*>(sender());
+    int num = channelNumber(channel);
+
+    emit channelTextureChanged(pageIndex, num, fileName);
+}
+
+void EditorPage::onChannelAttachmentChanged(int attachment)
+{
+    ChannelSettings *channel = qobject_cast<ChannelSettings*>(sender());
+    int num = channelNumber(channel);
+
+    emit channelAttachmentChanged(pageIndex, num, attachment);
+}
+
+void EditorPage::onChannelCountChanged(int count)
+{
+    while (channels.size() < count) {
+        addChannel();
+    }
+
+    while (channels.size() > count) {
+        delete channels.takeLast();
+    }
+
+    emit channelCountChanged(pageIndex, count);
+}
+
+void EditorPage::onParameterChanged(const QString &name, const QVector4D &value)
+{
+    emit parameterChanged(pageIndex, name, value);
+}
+
+void EditorPage::onUpdatePolicyChanged()
+{
+    const int mode = updateMode();
+
+    updateValueBox->setVisible(mode == EffectUpdatePolicy::EveryNthFrame
+                               || mode == EffectUpdatePolicy::FixedRate);
+    updateValueBox->setSuffix(mode == EffectUpdatePolicy::FixedRate ? tr(" Hz")
+                                                                      : tr(" frames"));
+
+    emit updatePolicyChanged(pageIndex, mode, updateValue());
+}
+
+void EditorPage::setupUpdatePolicy()
+{
+    updatePolicyWidget = new QWidget(this);
+    updateModeBox = new QComboBox(updatePolicyWidget);
+    updateValueBox = new QSpinBox(updatePolicyWidget);
+
+    updateModeBox->addItem(tr("Every frame"), EffectUpdatePolicy::EveryFrame);
+    updateModeBox->addItem(tr("Every Nth frame"), EffectUpdatePolicy::EveryNthFrame);
+    updateModeBox->addItem(tr("Fixed rate"), EffectUpdatePolicy::FixedRate);
+    updateModeBox->addItem(tr("When inputs change"), EffectUpdatePolicy::InputsChanged);
+    updateModeBox->addItem(tr("On mouse interaction"),
+                           EffectUpdatePolicy::MouseInteraction);
+
+    updateValueBox->setRange(1, 240);
+    updateValueBox->setValue(2);
+    updateValueBox->hide();
+
+    QHBoxLayout *layout = new QHBoxLayout(updatePolicyWidget);
+
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(new QLabel(tr("Update:"), updatePolicyWidget));
+    layout->addWidget(updateModeBox);
+    layout->addWidget(updateValueBox);
+    layout->addStretch();
+
+    ui->verticalLayout->addWidget(updatePolicyWidget);
+    // main image and shared code pages are not scheduled
+    updatePolicyWidget->hide();
+
+    connect(updateModeBox, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(onUpdatePolicyChanged()));
+    connect(updateValueBox, SIGNAL(valueChanged(int)),
+            this, SLOT(onUpdatePolicyChanged()));
+}
+
 void EditorPage::setupChannelSettings(const PagesData &data)
 {
-    QGridLayout *grid = ui->gridLayout;
+    inputPages = data;
 
-    for (int i = 0; i < data.size(); i++) {
-        QString name = QString("iChannel%0").arg(i);
-        ChannelSettings *channel = new ChannelSettings(data, name, this);
+    QWidget *countWidget = new QWidget(this);
+    channelCountBox = new QSpinBox(countWidget);
+    channelCountBox->setRange(1, Effect::maxChannels);
 
-        grid->addWidget(channel, 0, i);
-        channels.append(channel);
+    QHBoxLayout *layout = new QHBoxLayout(countWidget);
 
-        connect(channel, SIGNAL(channelInputChanged(int)),
-                this, SLOT(onChannelInputSettingChanged(int)));
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(new QLabel(tr("Channels:"), countWidget));
+    layout->addWidget(channelCountBox);
+    layout->addStretch();
 
-        connect(channel, SIGNAL(channelFilteringChanged(GLint)),
-                this, SLOT(onChannelFilteringChanged(GLint)));
+    ui->verticalLayout->addWidget(countWidget);
+
+    // shared code page has no input pages and no channels
+    if (data.isEmpty()) {
+        countWidget->hide();
+        return;
+    }
 
-        connect(channel, SIGNAL(channelWrapChanged(GLint)),
-                this, SLOT(onChannelWrapChanged(GLint)));
+    for (int i = 0; i < Effect::defaultChannels; i++) {
+        addChannel();
     }
+
+    channelCountBox->setValue(channels.size());
+
+    connect(channelCountBox, SIGNAL(valueChanged(int)),
+            this, SLOT(onChannelCountChanged(int)));
+}
+
+void EditorPage::addChannel()
+{
+    // wrap channels to rows, pages may have up to Effect::maxChannels of them
+    static const int channelsPerRow = 4;
+
+    const int i = channels.size();
+    QString name = QString("iChannel%0").arg(i);
+    ChannelSettings *channel = new ChannelSettings(inputPages, name, this);
+
+    ui->gridLayout->addWidget(channel, i / channelsPerRow, i % channelsPerRow);
+    channels.append(channel);
+
+    connect(channel, SIGNAL(channelInputChanged(int)),
+            this, SLOT(onChannelInputSettingChanged(int)));
+
+    connect(channel, SIGNAL(channelFilteringChanged(GLint)),
+            this, SLOT(onChannelFilteringChanged(GLint)));
+
+    connect(channel, SIGNAL(channelWrapChanged(GLint)),
+            this, SLOT(onChannelWrapChanged(GLint)));
+
+    connect(channel, SIGNAL(channelTextureChanged(QString)),
+            this, SLOT(onChannelTextureChanged(QString)));
+
+    connect(channel, SIGNAL(channelAttachmentChanged(int)),
+            this, SLOT(onChannelAttachmentChanged(int)));
 }
 
 bool EditorPage::parseLogMessage(const QString &message, int &line) const
 {
-    // typical OpenGL shader compilation error message:
-    // "ERROR: 0:<line>: <description>"
-    QRegularExpression re("(\\w+): \\d+:(\\d+): ([^\n]*)");
+    ShaderLogMessage parsed;
 
-    auto match = re.match(message);
-    bool matched = match.hasMatch();
+    // messages from included sources have nonzero source numbers
+    bool matched = ShaderLogMessage::parse(message, parsed) && parsed.source == 0;
 
     if (matched) {
-        line = match.captured(2).toInt();
+        line = parsed.line;
     }
 
     return matched;
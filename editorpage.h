@@ -24,6 +24,9 @@
 #include <QList>
 #include <QPair>
 #include <QOpenGLFunctions>
+#include <QHash>
+#include <QVector4D>
+#include "shaderparameter.h"
 
 namespace Ui {
 class EditorPage;
@@ -32,6 +35,11 @@ class EditorPage;
 class GLSLHighlighter;
 class CodeEditor;
 class ChannelSettings;
+class ParametersWidget;
+class QTextDocument;
+class QAbstractItemModel;
+class QComboBox;
+class QSpinBox;
 
 using PagesData = QList<QPair<int, QString>>;
 
@@ -46,14 +54,49 @@ public:
     QString shaderSource() const;
     void setShaderSource(const QString &source);
     bool isShaderSourceModified() const;
+    QTextDocument* document() const;
+    /// text of source line, numbered from 1
+    QString lineText(int line) const;
+    /// move cursor to source line and focus editor
+    void showLine(int line);
+    void setCompletionModel(QAbstractItemModel *model);
 
     void shaderLogUpdated(const QString &log);
     void clearShaderLog();
+    /// switch input channel back to 'No input'
+    void resetChannelInput(int channelNumber);
+
+    /// replace user parameters found in compiled source
+    void setParameters(const QList<ShaderParameter> &parameters);
+    QList<ShaderParameter> parameters() const;
+    /// set user parameter values by name, notifies about each of them
+    void setParameterValues(const QHash<QString, QVector4D> &values);
+
+    /// show update policy controls, only buffer pages have them
+    void setUpdatePolicyEnabled(bool enabled);
+    /// mode is one of EffectUpdatePolicy::Mode values
+    int updateMode() const;
+    int updateValue() const;
+    /// set update policy controls, notifies about the policy
+    void setUpdatePolicy(int mode, int value);
+
+    int channelCount() const;
+    /// add or remove channels at the end, notifies if count is changed.
+    /// Pages without input pages have no channels
+    void setChannelCount(int count);
+    ChannelSettings* channelSettings(int channelNumber) const;
 
 signals:
     void channelInputChanged(int pageIndex, int channelNumber, int newPageIndex);
     void channelFilteringChanged(int pageIndex, int channelNumber, GLint value);
     void channelWrapChanged(int pageIndex, int channelNumber, GLint value);
+    void channelTextureChanged(int pageIndex, int channelNumber, const QString &fileName);
+    void channelAttachmentChanged(int pageIndex, int channelNumber, int attachment);
+    void channelCountChanged(int pageIndex, int count);
+    void parameterChanged(int pageIndex, const QString &name, const QVector4D &value);
+    void updatePolicyChanged(int pageIndex, int mode, int value);
+    void definitionRequested(const QString &name);
+    void usagesRequested(const QString &name);
 
 private slots:
     void logMessageSelected(QListWidgetItem *item);
@@ -61,9 +104,16 @@ private slots:
     void onChannelInputSettingChanged(int newPageIndex);
     void onChannelFilteringChanged(GLint value);
     void onChannelWrapChanged(GLint value);
+    void onChannelTextureChanged(const QString &fileName);
+    void onChannelAttachmentChanged(int attachment);
+    void onChannelCountChanged(int count);
+    void onParameterChanged(const QString &name, const QVector4D &value);
+    void onUpdatePolicyChanged();
 
 private:
     void setupChannelSettings(const PagesData &data);
+    void addChannel();
+    void setupUpdatePolicy();
     bool parseLogMessage(const QString &message, int &line) const;
     int channelNumber(ChannelSettings *channel) const;
 
@@ -71,6 +121,14 @@ private:
     CodeEditor *editor;
     GLSLHighlighter *highlighter;
     QListWidget *logList;
+    ParametersWidget *parametersWidget;
+    QWidget *updatePolicyWidget;
+    QComboBox *updateModeBox;
+    /// frame divisor or rate, hidden for modes without value
+    QSpinBox *updateValueBox;
+    QSpinBox *channelCountBox;
+    /// pages available as channel inputs
+    PagesData inputPages;
     QList<ChannelSettings*> channels;
     int pageIndex;
 };
@@ -17,15 +17,26 @@
  */
 
 #include "effect.h"
+#include <QOpenGLContext>
 
 Effect::Effect(QOpenGLShaderProgram *program, QOpenGLShader *fragmentShader,
                QOpenGLFramebufferObject *fbo, const QString &source) :
     program(program),
+    computeProgram(0),
+    workGroupSize(1, 1),
     fragmentShader(fragmentShader),
     framebuffer(fbo),
-    inputs(4),
+    textures(fbo->textures()),
+    mipmapOutputs(0),
+    inputs(defaultChannels),
     fallbackSource(source),
-    frame(0)
+    frame(0),
+    dirty(true),
+    renderCount(0),
+    lastRenderFrame(0),
+    nextRenderTime(0.0f),
+    inputRevisions(defaultChannels, 0),
+    mouseRevision(0)
 {
 }
 
@@ -34,4 +45,25 @@ Effect::~Effect()
     delete program;
     delete fragmentShader;
     delete framebuffer;
+
+    for (auto &input : inputs) {
+        delete input.texture;
+    }
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+
+    Q_ASSERT(context);
+
+    if (!context) {
+        // programs can not be deleted, leaking them is better than crashing
+        return;
+    }
+
+    QOpenGLFunctions *gl = context->functions();
+
+    for (const auto &variant : variants) {
+        gl->glDeleteProgram(variant.program);
+    }
+
+    gl->glDeleteProgram(computeProgram);
 }
@@ -23,6 +23,10 @@
 #include <QOpenGLShader>
 #include <QOpenGLFramebufferObject>
 #include <QVector>
+#include <QVector4D>
+#include <QHash>
+#include <QByteArray>
+#include "channeltexture.h"
 
 class Effect;
 
@@ -30,17 +34,100 @@ struct EffectChannelSettings
 {
     EffectChannelSettings() :
         effect(Q_NULLPTR),
+        texture(Q_NULLPTR),
         filter(GL_LINEAR_MIPMAP_LINEAR),
-        wrap(GL_REPEAT)
+        wrap(GL_REPEAT),
+        attachment(0)
     {
     }
 
     /// effect used by this channel
     Effect *effect;
+    /// static texture used by this channel, owned by effect
+    ChannelTexture *texture;
     /// texture filtering setting
     GLint filter;
     /// texture wrap setting
     GLint wrap;
+    /// color attachment of effect framebuffer sampled by this channel
+    int attachment;
+};
+
+/// locations of the built-in uniforms in effect program
+struct EffectUniforms
+{
+    EffectUniforms() :
+        time(-1),
+        frame(-1),
+        resolution(-1),
+        mouse(-1),
+        mouseHistory(-1)
+    {
+    }
+
+    GLint time;
+    GLint frame;
+    GLint resolution;
+    GLint mouse;
+    /// location of optional iMouseHistory array
+    GLint mouseHistory;
+    /// location of each input channel sampler
+    QVector<GLint> channels;
+};
+
+/// user parameter uniform uploaded every frame
+struct EffectParameter
+{
+    EffectParameter() :
+        type(GL_FLOAT),
+        location(-1)
+    {
+    }
+
+    QByteArray name;
+    GLenum type;
+    GLint location;
+    QVector4D value;
+};
+
+/// program with user parameters compiled in as constants
+struct EffectVariant
+{
+    EffectVariant() :
+        program(0)
+    {
+    }
+
+    GLuint program;
+    EffectUniforms uniforms;
+};
+
+/// how often effect is rendered, main image is rendered every frame
+struct EffectUpdatePolicy
+{
+    enum Mode
+    {
+        /// render every frame
+        EveryFrame = 0,
+        /// render every value-th frame
+        EveryNthFrame,
+        /// render value times per second
+        FixedRate,
+        /// render when any input effect or texture changed
+        InputsChanged,
+        /// render while mouse is pressed or moved over preview
+        MouseInteraction
+    };
+
+    EffectUpdatePolicy() :
+        mode(EveryFrame),
+        value(1)
+    {
+    }
+
+    Mode mode;
+    /// frame divisor or rate in Hz, depending on mode
+    int value;
 };
 
 class Effect
@@ -49,20 +136,61 @@ public:
     Effect(QOpenGLShaderProgram *program, QOpenGLShader *fragmentShader,
            QOpenGLFramebufferObject *fbo, const QString &source);
 
+    /// OpenGL context effect was created with must be current
     ~Effect();
 
+    /// fragment shader outputs backed by framebuffer attachments at most
+    static const int maxOutputs = 4;
+    /// input channels of new effect
+    static const int defaultChannels = 4;
+    /// input channels at most, each one takes texture unit with the same number.
+    /// OpenGL 3.3 guarantees 16 texture units for fragment shader
+    static const int maxChannels = 16;
+
     /// shader program used by this effect
     QOpenGLShaderProgram *program;
+    /// compute program used instead of program, 0 for fragment effects
+    GLuint computeProgram;
+    /// local work group size of compute program
+    QSize workGroupSize;
     /// fragment shader used by this effect
     QOpenGLShader *fragmentShader;
     /// framebuffer this effect renders to
     QOpenGLFramebufferObject *framebuffer;
+    /// color attachment textures of framebuffer, one per shader output
+    QVector<GLuint> textures;
+    /// bit per output sampled with mipmaps by some effect, mip chains of these
+    /// outputs are generated once after effect is rendered
+    int mipmapOutputs;
     /// settings for each of the input channels
     QVector<EffectChannelSettings> inputs;
+    /// uniform locations, updated each time program is linked
+    EffectUniforms uniforms;
+    /// user parameters declared in effect source
+    QVector<EffectParameter> parameters;
+    /// compiled variants with baked parameters by their source hash
+    QHash<QByteArray, EffectVariant> variants;
+    /// variant used instead of program, empty if parameters are not baked
+    QByteArray activeVariant;
+    /// variant to use as soon as it is compiled
+    QByteArray requestedVariant;
     /// fragment shader source code used for fallback
     QString fallbackSource;
     /// frame counter
     int frame;
+    EffectUpdatePolicy updatePolicy;
+    /// effect must be rendered in next frame regardless of its policy
+    bool dirty;
+    /// number of times effect was rendered, lets consumers detect changes
+    quint64 renderCount;
+    /// renderer frame effect was last rendered at
+    quint64 lastRenderFrame;
+    /// time in seconds effect is due to be rendered at with fixed rate
+    float nextRenderTime;
+    /// input effect render counts or texture revisions seen at last render
+    QVector<quint64> inputRevisions;
+    /// renderer mouse revision seen at last render
+    quint64 mouseRevision;
 };
 
 #endif // EFFECT_H
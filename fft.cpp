@@ -0,0 +1,101 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fft.h"
+#include <QtMath>
+
+Fft::Fft(int size) :
+    length(size)
+{
+    Q_ASSERT(size > 1 && (size & (size - 1)) == 0);
+
+    int bits = 0;
+
+    while ((1 << bits) < size) {
+        bits++;
+    }
+
+    for (int i = 0; i < size; i++) {
+        int reversed = 0;
+
+        for (int bit = 0; bit < bits; bit++) {
+            reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+        }
+
+        if (i < reversed) {
+            swaps.append(i);
+            swaps.append(reversed);
+        }
+    }
+
+    twiddleRe.resize(size - 1);
+    twiddleIm.resize(size - 1);
+
+    for (int half = 1; half < size; half *= 2) {
+        for (int k = 0; k < half; k++) {
+            double angle = -M_PI * k / half;
+
+            twiddleRe[half - 1 + k] = qCos(angle);
+            twiddleIm[half - 1 + k] = qSin(angle);
+        }
+    }
+}
+
+int Fft::size() const
+{
+    return length;
+}
+
+void Fft::transform(float *re, float *im) const
+{
+    reorder(re, im);
+
+    for (int half = 1; half < length; half *= 2) {
+        const float *wr = twiddleRe.constData() + half - 1;
+        const float *wi = twiddleIm.constData() + half - 1;
+
+        for (int start = 0; start < length; start += 2 * half) {
+            float *ar = re + start;
+            float *ai = im + start;
+            float *br = ar + half;
+            float *bi = ai + half;
+
+            // independent iterations over contiguous arrays
+            for (int k = 0; k < half; k++) {
+                float tr = wr[k] * br[k] - wi[k] * bi[k];
+                float ti = wr[k] * bi[k] + wi[k] * br[k];
+
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+}
+
+void Fft::reorder(float *re, float *im) const
+{
+    for (int i = 0; i < swaps.size(); i += 2) {
+        int a = swaps[i];
+        int b = swaps[i + 1];
+
+        qSwap(re[a], re[b]);
+        qSwap(im[a], im[b]);
+    }
+}
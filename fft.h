@@ -0,0 +1,48 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+
+/// In-place radix-2 complex FFT.
+/// Real and imaginary parts are kept in separate arrays and twiddle factors
+/// of each stage are stored contiguously, so butterfly loops are
+/// vectorized by compiler
+class Fft
+{
+public:
+    /// size must be a power of two
+    explicit Fft(int size);
+
+    int size() const;
+    void transform(float *re, float *im) const;
+
+private:
+    void reorder(float *re, float *im) const;
+
+    const int length;
+    /// pairs of indices to swap for bit-reversal permutation
+    QVector<int> swaps;
+    /// twiddle factors for all stages, stage with half size h starts at h - 1
+    QVector<float> twiddleRe;
+    QVector<float> twiddleIm;
+};
+
+#endif // FFT_H
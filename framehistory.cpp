@@ -0,0 +1,528 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "framehistory.h"
+#include "effect.h"
+#include "tracer.h"
+#include "gpumemory.h"
+#include <QOpenGLFramebufferObject>
+#include <QRect>
+#include <cstring>
+
+namespace {
+
+/// GPU memory used for stored frames at most
+const qint64 gpuBudget = 256 * 1024 * 1024;
+/// frames kept in GPU memory regardless of their size
+const int minGpuFrames = 8;
+const int maxGpuFrames = 600;
+/// compressed frames kept in CPU memory at most
+const qint64 cpuBudget = 512 * 1024 * 1024;
+/// frames between keyframes
+const int keyframeInterval = 120;
+const int maxKeyframes = 32;
+/// GPU memory used for keyframes at most without memory limit
+const qint64 keyframeBudget = 256 * 1024 * 1024;
+
+} // namespace
+
+FrameHistory::FrameHistory(QObject *parent) :
+    QObject(parent),
+    worker(new FrameHistoryWorker()),
+    spilledBytes(0),
+    uploadFramebuffer(Q_NULLPTR),
+    keyframeBytes(0),
+    memoryLimit(0),
+    generation(0),
+    spillEnabled(false)
+{
+    worker->moveToThread(&thread);
+
+    connect(worker, &FrameHistoryWorker::compressed,
+            this, &FrameHistory::frameCompressed);
+
+    thread.setObjectName("Frame history");
+    thread.start();
+}
+
+FrameHistory::~FrameHistory()
+{
+    thread.quit();
+    thread.wait();
+
+    delete worker;
+
+    Q_ASSERT(frames.isEmpty() && keyframes.isEmpty());
+}
+
+void FrameHistory::create()
+{
+    initializeOpenGLFunctions();
+}
+
+void FrameHistory::destroy()
+{
+    clear();
+    collectReadbacks();
+
+    // readbacks still in flight are waited for, their results are ignored
+    for (const auto &readback : readbacks) {
+        glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(readback.fence);
+        freeBuffers.append(readback.buffer);
+    }
+
+    readbacks.clear();
+
+    if (!freeBuffers.isEmpty()) {
+        glDeleteBuffers(freeBuffers.size(), freeBuffers.constData());
+        freeBuffers.clear();
+    }
+
+    qDeleteAll(freeFramebuffers);
+    freeFramebuffers.clear();
+
+    delete uploadFramebuffer;
+    uploadFramebuffer = Q_NULLPTR;
+}
+
+void FrameHistory::setSpillEnabled(bool enabled)
+{
+    spillEnabled = enabled;
+
+    if (!spillEnabled) {
+        spilledFrames.clear();
+        spilledBytes = 0;
+        generation++;
+    }
+}
+
+void FrameHistory::setMemoryLimit(qint64 bytes)
+{
+    Q_ASSERT(bytes >= 0);
+
+    memoryLimit = bytes;
+}
+
+qint64 FrameHistory::gpuBytes() const
+{
+    qint64 bytes = keyframeBytes;
+
+    for (const auto *framebuffer : frames) {
+        bytes += GpuMemory::framebufferBytes(framebuffer, false);
+    }
+
+    for (const auto *framebuffer : freeFramebuffers) {
+        bytes += GpuMemory::framebufferBytes(framebuffer, false);
+    }
+
+    if (uploadFramebuffer) {
+        bytes += GpuMemory::framebufferBytes(uploadFramebuffer, false);
+    }
+
+    for (const auto &readback : readbacks) {
+        bytes += qint64(readback.size.width()) * readback.size.height() * 4;
+    }
+
+    return bytes;
+}
+
+void FrameHistory::clearFrames()
+{
+    freeFramebuffers.append(frames.values().toVector());
+    frames.clear();
+    spilledFrames.clear();
+    spilledBytes = 0;
+    generation++;
+}
+
+void FrameHistory::clear()
+{
+    clearFrames();
+
+    for (auto &keyframe : keyframes) {
+        deleteKeyframe(keyframe);
+    }
+
+    keyframes.clear();
+}
+
+void FrameHistory::truncate(int frame)
+{
+    while (!frames.isEmpty() && frames.lastKey() > frame) {
+        freeFramebuffers.append(frames.take(frames.lastKey()));
+    }
+
+    while (!spilledFrames.isEmpty() && spilledFrames.lastKey() > frame) {
+        spilledBytes -= spilledFrames.take(spilledFrames.lastKey()).data.size();
+    }
+
+    while (!keyframes.isEmpty() && keyframes.lastKey() > frame) {
+        Keyframe keyframe = keyframes.take(keyframes.lastKey());
+
+        deleteKeyframe(keyframe);
+    }
+
+    // frames being compressed may be newer than frame
+    generation++;
+}
+
+void FrameHistory::storeFrame(int frame, QOpenGLFramebufferObject *source, QSize size)
+{
+    TRACE_SCOPE("storeFrame", "history", frame);
+
+    collectReadbacks();
+
+    const int count = capacity(size);
+
+    while (!frames.contains(frame) && frames.size() >= count) {
+        if (frame < frames.firstKey()) {
+            // older than everything stored, it is cheaper to render it again
+            return;
+        }
+
+        evictFrame();
+    }
+
+    // frames of previous view size are not reused
+    while (!freeFramebuffers.isEmpty() && frames.size() + freeFramebuffers.size() > count) {
+        delete freeFramebuffers.takeLast();
+    }
+
+    QOpenGLFramebufferObject *&framebuffer = frames[frame];
+
+    if (!framebuffer || framebuffer->size() != size) {
+        delete framebuffer;
+        framebuffer = takeFramebuffer(size);
+    }
+
+    QOpenGLFramebufferObject::blitFramebuffer(framebuffer, QRect(QPoint(), size),
+                                              source, QRect(QPoint(), size));
+
+    spilledBytes -= spilledFrames.take(frame).data.size();
+}
+
+bool FrameHistory::showFrame(int frame, QOpenGLFramebufferObject *target, QSize viewSize)
+{
+    QOpenGLFramebufferObject *framebuffer = frames.value(frame, Q_NULLPTR);
+
+    if (!framebuffer && spilledFrames.contains(frame)) {
+        TRACE_SCOPE("uploadSpilledFrame", "history", frame);
+
+        const SpilledFrame &spilled = spilledFrames[frame];
+        const QByteArray pixels = qUncompress(spilled.data);
+
+        if (pixels.size() != spilled.size.width() * spilled.size.height() * 4) {
+            return false;
+        }
+
+        if (!uploadFramebuffer || uploadFramebuffer->size() != spilled.size) {
+            delete uploadFramebuffer;
+            uploadFramebuffer = new QOpenGLFramebufferObject(spilled.size);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, uploadFramebuffer->texture());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, spilled.size.width(), spilled.size.height(),
+                        GL_RGBA, GL_UNSIGNED_BYTE, pixels.constData());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        framebuffer = uploadFramebuffer;
+    }
+
+    if (!framebuffer) {
+        return false;
+    }
+
+    // frames stored at other view size are stretched
+    QOpenGLFramebufferObject::blitFramebuffer(target, QRect(QPoint(), viewSize),
+                                              framebuffer,
+                                              QRect(QPoint(), framebuffer->size()),
+                                              GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    return true;
+}
+
+int FrameHistory::firstFrame() const
+{
+    if (frames.isEmpty() && spilledFrames.isEmpty()) {
+        return -1;
+    }
+
+    if (frames.isEmpty()) {
+        return spilledFrames.firstKey();
+    }
+
+    if (spilledFrames.isEmpty()) {
+        return frames.firstKey();
+    }
+
+    return qMin(frames.firstKey(), spilledFrames.firstKey());
+}
+
+bool FrameHistory::needsKeyframe(int frame) const
+{
+    return keyframes.isEmpty() || frame - keyframes.lastKey() >= keyframeInterval;
+}
+
+void FrameHistory::storeKeyframe(int frame, const QHash<int, Effect*> &buffers)
+{
+    TRACE_SCOPE("storeKeyframe", "history", frame);
+
+    qint64 bytes = 0;
+
+    for (const Effect *effect : buffers) {
+        bytes += GpuMemory::framebufferBytes(effect->framebuffer, false);
+    }
+
+    // keyframes take at most half of memory limit, frames get the rest.
+    // Large buffers need a budget even without limit
+    const qint64 budget = memoryLimit > 0 ? memoryLimit / 2 : keyframeBudget;
+
+    while (!keyframes.isEmpty() && (keyframes.size() >= maxKeyframes
+            || keyframeBytes + bytes > budget)) {
+        Keyframe oldest = keyframes.take(keyframes.firstKey());
+
+        deleteKeyframe(oldest);
+    }
+
+    Keyframe &keyframe = keyframes[frame];
+
+    for (auto it = buffers.cbegin(); it != buffers.cend(); ++it) {
+        const Effect *effect = it.value();
+        QOpenGLFramebufferObject *source = effect->framebuffer;
+        const GLenum format = source->format().internalTextureFormat();
+        KeyframeBuffer buffer;
+
+        buffer.framebuffer = new QOpenGLFramebufferObject(source->size(),
+                                    QOpenGLFramebufferObject::NoAttachment, GL_TEXTURE_2D,
+                                    format);
+        buffer.frame = effect->frame;
+        buffer.lastRenderFrame = effect->lastRenderFrame;
+        buffer.nextRenderTime = effect->nextRenderTime;
+
+        for (int i = 1; i < effect->textures.size(); i++) {
+            buffer.framebuffer->addColorAttachment(source->size(), format);
+        }
+
+        copyAttachments(buffer.framebuffer, source);
+
+        keyframe.insert(it.key(), buffer);
+    }
+
+    keyframeBytes += bytes;
+}
+
+int FrameHistory::keyframeBefore(int frame) const
+{
+    auto it = keyframes.upperBound(frame);
+
+    if (it == keyframes.cbegin()) {
+        return -1;
+    }
+
+    return (--it).key();
+}
+
+int FrameHistory::firstKeyframe() const
+{
+    return keyframes.isEmpty() ? -1 : keyframes.firstKey();
+}
+
+void FrameHistory::restoreKeyframe(int keyframe, const QHash<int, Effect*> &buffers)
+{
+    TRACE_SCOPE("restoreKeyframe", "history", keyframe);
+
+    Q_ASSERT(keyframes.contains(keyframe));
+
+    const Keyframe &stored = keyframes[keyframe];
+
+    for (auto it = buffers.cbegin(); it != buffers.cend(); ++it) {
+        Effect *effect = it.value();
+
+        if (!stored.contains(it.key())) {
+            continue;
+        }
+
+        const KeyframeBuffer &buffer = stored[it.key()];
+
+        // buffer could be resized since then
+        if (buffer.framebuffer->size() == effect->framebuffer->size()) {
+            copyAttachments(effect->framebuffer, buffer.framebuffer);
+        }
+
+        effect->frame = buffer.frame;
+        effect->lastRenderFrame = buffer.lastRenderFrame;
+        effect->nextRenderTime = buffer.nextRenderTime;
+    }
+}
+
+void FrameHistory::frameCompressed(int frameGeneration, int frame, QSize size,
+                                   const QByteArray &data)
+{
+    if (frameGeneration != generation || !spillEnabled || frames.contains(frame)) {
+        return;
+    }
+
+    SpilledFrame &spilled = spilledFrames[frame];
+
+    spilledBytes += data.size() - spilled.data.size();
+    spilled.size = size;
+    spilled.data = data;
+
+    while (spilledBytes > cpuBudget && spilledFrames.size() > 1) {
+        spilledBytes -= spilledFrames.take(spilledFrames.firstKey()).data.size();
+    }
+}
+
+int FrameHistory::capacity(QSize size) const
+{
+    const qint64 bytes = qMax(qint64(size.width()) * size.height() * 4, qint64(1));
+    const qint64 budget = memoryLimit > 0 ? qMin(gpuBudget, memoryLimit - keyframeBytes)
+                                          : gpuBudget;
+
+    return qBound(qint64(minGpuFrames), budget / bytes, qint64(maxGpuFrames));
+}
+
+void FrameHistory::evictFrame()
+{
+    const int frame = frames.firstKey();
+    QOpenGLFramebufferObject *framebuffer = frames.take(frame);
+
+    freeFramebuffers.append(framebuffer);
+
+    if (!spillEnabled) {
+        return;
+    }
+
+    const QSize size = framebuffer->size();
+    Readback readback;
+
+    readback.generation = generation;
+    readback.frame = frame;
+    readback.size = size;
+
+    if (freeBuffers.isEmpty()) {
+        glGenBuffers(1, &readback.buffer);
+    }
+    else {
+        readback.buffer = freeBuffers.takeLast();
+    }
+
+    GLint readFramebuffer = 0;
+
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer->handle());
+
+    // copy to buffer object happens on GPU, framebuffer can be reused right away
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size.width() * size.height() * 4, Q_NULLPTR,
+                 GL_STREAM_READ);
+    glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, Q_NULLPTR);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readbacks.append(readback);
+}
+
+void FrameHistory::collectReadbacks()
+{
+    for (auto it = readbacks.begin(); it != readbacks.end();) {
+        if (glClientWaitSync(it->fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            ++it;
+            continue;
+        }
+
+        glDeleteSync(it->fence);
+
+        if (it->generation == generation) {
+            const int length = it->size.width() * it->size.height() * 4;
+            QByteArray pixels(length, Qt::Uninitialized);
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, it->buffer);
+
+            const void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, length,
+                                                GL_MAP_READ_BIT);
+
+            if (data) {
+                memcpy(pixels.data(), data, length);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+                QMetaObject::invokeMethod(worker, "compress", Qt::QueuedConnection,
+                                          Q_ARG(int, it->generation), Q_ARG(int, it->frame),
+                                          Q_ARG(QSize, it->size), Q_ARG(QByteArray, pixels));
+            }
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+
+        freeBuffers.append(it->buffer);
+        it = readbacks.erase(it);
+    }
+}
+
+void FrameHistory::copyAttachments(QOpenGLFramebufferObject *target,
+                                   QOpenGLFramebufferObject *source)
+{
+    const QRect rect(QPoint(), source->size());
+    const int count = qMin(target->textures().size(), source->textures().size());
+
+    for (int i = 0; i < count; i++) {
+        QOpenGLFramebufferObject::blitFramebuffer(target, rect, source, rect,
+                                                  GL_COLOR_BUFFER_BIT, GL_NEAREST, i, i);
+    }
+}
+
+QOpenGLFramebufferObject* FrameHistory::takeFramebuffer(QSize size)
+{
+    while (!freeFramebuffers.isEmpty()) {
+        QOpenGLFramebufferObject *framebuffer = freeFramebuffers.takeLast();
+
+        if (framebuffer->size() == size) {
+            return framebuffer;
+        }
+
+        delete framebuffer;
+    }
+
+    return new QOpenGLFramebufferObject(size);
+}
+
+void FrameHistory::deleteKeyframe(Keyframe &keyframe)
+{
+    for (const auto &buffer : keyframe) {
+        keyframeBytes -= GpuMemory::framebufferBytes(buffer.framebuffer, false);
+        delete buffer.framebuffer;
+    }
+
+    keyframe.clear();
+}
+
+FrameHistoryWorker::FrameHistoryWorker(QObject *parent) :
+    QObject(parent)
+{
+}
+
+void FrameHistoryWorker::compress(int generation, int frame, QSize size,
+                                  const QByteArray &pixels)
+{
+    TRACE_SCOPE("compressFrame", "history", frame);
+
+    emit compressed(generation, frame, size, qCompress(pixels, 1));
+}
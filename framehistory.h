@@ -0,0 +1,162 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMEHISTORY_H
+#define FRAMEHISTORY_H
+
+#include <QObject>
+#include <QThread>
+#include <QOpenGLExtraFunctions>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QSize>
+#include <QByteArray>
+
+class QOpenGLFramebufferObject;
+class Effect;
+class FrameHistoryWorker;
+
+/// Recently rendered main image frames and buffer keyframes for timeline
+/// scrubbing. Frames are kept in a bounded ring of GPU framebuffers,
+/// frames evicted from it can be read back asynchronously and kept
+/// compressed in memory. Keyframes hold copies of all buffers,
+/// so seeking re-simulates only frames after the nearest keyframe.
+/// OpenGL context must be current for all methods except setSpillEnabled()
+class FrameHistory : public QObject, protected QOpenGLExtraFunctions
+{
+    Q_OBJECT
+
+public:
+    explicit FrameHistory(QObject *parent = Q_NULLPTR);
+    ~FrameHistory();
+
+    void create();
+    void destroy();
+
+    /// keep frames evicted from GPU memory compressed in CPU memory
+    void setSpillEnabled(bool enabled);
+    /// GPU memory frames and keyframes may use together, 0 for default budget.
+    /// Frames over limit are evicted as new ones are stored
+    void setMemoryLimit(qint64 bytes);
+    /// GPU memory used by stored frames, keyframes and pending readbacks
+    qint64 gpuBytes() const;
+
+    /// forget stored frames, keyframes are kept
+    void clearFrames();
+    /// forget frames and keyframes
+    void clear();
+    /// forget frames and keyframes after specified frame
+    void truncate(int frame);
+
+    /// store contents of source framebuffer as frame,
+    /// Q_NULLPTR is default framebuffer of current surface
+    void storeFrame(int frame, QOpenGLFramebufferObject *source, QSize size);
+    /// draw stored frame over target framebuffer, Q_NULLPTR is default
+    /// framebuffer of current surface. False if frame is not stored
+    bool showFrame(int frame, QOpenGLFramebufferObject *target, QSize viewSize);
+    /// first stored frame, -1 if there is none
+    int firstFrame() const;
+
+    /// true if keyframe should be taken after simulating frame
+    bool needsKeyframe(int frame) const;
+    /// copy buffers and their playback state
+    void storeKeyframe(int frame, const QHash<int, Effect*> &buffers);
+    /// nearest keyframe not after frame, -1 if there is none
+    int keyframeBefore(int frame) const;
+    int firstKeyframe() const;
+    /// copy keyframe buffers and playback state back to effects
+    void restoreKeyframe(int keyframe, const QHash<int, Effect*> &buffers);
+
+private slots:
+    void frameCompressed(int frameGeneration, int frame, QSize size, const QByteArray &data);
+
+private:
+    struct Readback
+    {
+        int generation;
+        int frame;
+        QSize size;
+        GLuint buffer;
+        GLsync fence;
+    };
+
+    struct SpilledFrame
+    {
+        QSize size;
+        QByteArray data;
+    };
+
+    struct KeyframeBuffer
+    {
+        QOpenGLFramebufferObject *framebuffer;
+        int frame;
+        quint64 lastRenderFrame;
+        float nextRenderTime;
+    };
+
+    using Keyframe = QHash<int, KeyframeBuffer>;
+
+    /// GPU frames fitting into memory budget at specified size
+    int capacity(QSize size) const;
+    /// start reading evicted frame back, if spilling is enabled
+    void evictFrame();
+    /// pass finished readbacks to worker without waiting for the rest
+    void collectReadbacks();
+    QOpenGLFramebufferObject* takeFramebuffer(QSize size);
+    /// copy all color attachments of framebuffers with the same size
+    static void copyAttachments(QOpenGLFramebufferObject *target,
+                                QOpenGLFramebufferObject *source);
+    void deleteKeyframe(Keyframe &keyframe);
+
+    QThread thread;
+    FrameHistoryWorker *worker;
+    /// frames stored in GPU memory
+    QMap<int, QOpenGLFramebufferObject*> frames;
+    QVector<QOpenGLFramebufferObject*> freeFramebuffers;
+    QVector<Readback> readbacks;
+    QVector<GLuint> freeBuffers;
+    /// frames evicted from GPU memory, compressed
+    QMap<int, SpilledFrame> spilledFrames;
+    qint64 spilledBytes;
+    /// scratch framebuffer spilled frames are uploaded to
+    QOpenGLFramebufferObject *uploadFramebuffer;
+    QMap<int, Keyframe> keyframes;
+    qint64 keyframeBytes;
+    /// 0 if frames use default budget
+    qint64 memoryLimit;
+    /// incremented when frames are dropped, so late readbacks are ignored
+    int generation;
+    bool spillEnabled;
+};
+
+class FrameHistoryWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrameHistoryWorker(QObject *parent = Q_NULLPTR);
+
+public slots:
+    void compress(int generation, int frame, QSize size, const QByteArray &pixels);
+
+signals:
+    void compressed(int generation, int frame, QSize size, const QByteArray &data);
+};
+
+#endif // FRAMEHISTORY_H
@@ -0,0 +1,105 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "glshader.h"
+#include <QRegularExpression>
+
+const char GlShader::vertexSource[] =
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 pos;\n"
+        "void main() {\n"
+        "gl_Position = vec4(pos, 0.0, 1.0);\n"
+        "}\n";
+
+bool GlShader::isCompute(const QString &source)
+{
+    static const QRegularExpression workGroup("layout\\s*\\([^)]*\\blocal_size_x\\b");
+
+    return workGroup.match(source).hasMatch();
+}
+
+GLuint GlShader::compile(QOpenGLExtraFunctions *gl, GLenum type, const QString &source,
+                         QString &log)
+{
+    const QByteArray code = source.toLocal8Bit();
+    const char *data = code.constData();
+    GLuint shader = gl->glCreateShader(type);
+    GLint status = GL_FALSE;
+
+    gl->glShaderSource(shader, 1, &data, Q_NULLPTR);
+    gl->glCompileShader(shader);
+    gl->glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+    log += shaderInfoLog(gl, shader);
+
+    if (status != GL_TRUE) {
+        gl->glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+GLuint GlShader::link(QOpenGLExtraFunctions *gl, GLuint vertex, GLuint shader,
+                      QString &log)
+{
+    GLuint program = gl->glCreateProgram();
+    GLint status = GL_FALSE;
+
+    if (vertex) {
+        gl->glAttachShader(program, vertex);
+    }
+
+    gl->glAttachShader(program, shader);
+    gl->glLinkProgram(program);
+    gl->glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+    log += programInfoLog(gl, program);
+
+    // shaders stay attached and are released together with program
+    if (status != GL_TRUE) {
+        gl->glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+QString GlShader::shaderInfoLog(QOpenGLExtraFunctions *gl, GLuint shader)
+{
+    GLint length = 0;
+
+    gl->glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+
+    QByteArray log(qMax(length, 1), '\0');
+    gl->glGetShaderInfoLog(shader, log.size(), Q_NULLPTR, log.data());
+
+    return QString::fromLocal8Bit(log.constData());
+}
+
+QString GlShader::programInfoLog(QOpenGLExtraFunctions *gl, GLuint program)
+{
+    GLint length = 0;
+
+    gl->glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+
+    QByteArray log(qMax(length, 1), '\0');
+    gl->glGetProgramInfoLog(program, log.size(), Q_NULLPTR, log.data());
+
+    return QString::fromLocal8Bit(log.constData());
+}
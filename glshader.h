@@ -0,0 +1,49 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GLSHADER_H
+#define GLSHADER_H
+
+#include <QOpenGLExtraFunctions>
+#include <QString>
+
+/// Shader sources and compilation shared by renderer and offscreen workers.
+/// OpenGL context of functions must be current
+class GlShader
+{
+public:
+    /// vertex shader of fullscreen quad, all fragment shaders are linked with it
+    static const char vertexSource[];
+
+    /// compute shaders declare their work group size
+    static bool isCompute(const QString &source);
+
+    /// compile shader and append its info log to log, including warnings.
+    /// Returns 0 if compilation failed
+    static GLuint compile(QOpenGLExtraFunctions *gl, GLenum type, const QString &source,
+                          QString &log);
+    /// link program of vertex shader, 0 for compute programs, and fragment or
+    /// compute shader, append its info log to log. Returns 0 if linking failed
+    static GLuint link(QOpenGLExtraFunctions *gl, GLuint vertex, GLuint shader,
+                       QString &log);
+
+    static QString shaderInfoLog(QOpenGLExtraFunctions *gl, GLuint shader);
+    static QString programInfoLog(QOpenGLExtraFunctions *gl, GLuint program);
+};
+
+#endif // GLSHADER_H
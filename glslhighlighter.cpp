@@ -17,11 +17,114 @@
  */
 
 #include "glslhighlighter.h"
+#include "tracer.h"
+#include <QTextBlockUserData>
+#include <QTextDocument>
+#include <QElapsedTimer>
+#include <QTimer>
+
+namespace {
+
+/// blocks around visible ones that are formatted immediately
+const int visibleMargin = 50;
+/// time spent formatting deferred blocks per event loop iteration
+const int sliceMs = 8;
+
+/// marks blocks that were scanned for state only and still need formatting
+class HighlightData : public QTextBlockUserData
+{
+public:
+    HighlightData() :
+        pending(false)
+    {
+    }
+
+    bool pending;
+};
+
+/// GLSL keywords
+QStringList keywordList()
+{
+    return QStringList{
+        "attribute", "const", "uniform", "varying",
+        "buffer", "shared", "coherent", "volatile",
+        "restrict", "readonly", "writeonly", "layout",
+        "centroid", "flat", "smooth", "noperspective",
+        "patch", "sample", "break", "continue",
+        "do", "for", "while", "switch", "case",
+        "default", "if", "else", "subroutine",
+        "in", "out", "inout", "true", "false",
+        "invariant", "precise", "discard", "return",
+        "lowp", "mediump", "highp", "precision",
+        "struct"
+    };
+}
+
+/// GLSL built-in types
+QStringList typeList()
+{
+    return QStringList{
+        "void", "bool", "int", "uint", "float",
+        "double", "vec2", "vec3", "vec4", "bvec2",
+        "bvec3", "bvec4", "ivec2", "ivec3", "ivec4",
+        "uvec2", "uvec3", "uvec4", "mat2", "mat3",
+        "mat4", "mat2x2", "mat2x3", "mat2x4",
+        "mat3x2", "mat3x3", "mat3x4", "mat4x2",
+        "mat4x3", "mat4x4", "sampler1D", "image1D",
+        "sampler2D", "image2D", "sampler3D", "image3D"
+    };
+}
+
+/// GLSL built-in special variables
+QStringList variableList()
+{
+    return QStringList{
+        "gl_FragCoord", "gl_FrontFacing", "gl_ClipDistance",
+        "gl_CullDistance", "gl_PointCoord", "gl_PrimitiveID",
+        "gl_SampleID", "gl_SamplePosition", "gl_SampleMaskIn",
+        "gl_Layer", "gl_ViewportIndex", "gl_HelperInvocation",
+        "gl_FragDepth", "gl_SampleMask"
+    };
+}
+
+/// GLSL built-in functions
+QStringList functionList()
+{
+    return QStringList{
+        "radians", "degrees", "sin", "cos", "tan",
+        "asin", "acos", "atan", "sinh", "cosh",
+        "tanh", "asinh", "acosh", "atanh", "pow",
+        "exp", "log", "exp2", "log2", "sqrt",
+        "inversesqrt", "abs", "sign", "floor",
+        "trunc", "round", "roundEven", "ceil",
+        "fract", "mod", "modf", "min", "max",
+        "clamp", "mix", "step", "smoothstep",
+        "isnan", "isinf", "fma", "frexp", "ldexp",
+        "length", "distance", "dot", "cross",
+        "normalize", "ftransform", "faceforward", "reflect",
+        "refract", "matrixCompMult", "outerProduct",
+        "transpose", "determinant", "inverse", "lessThan",
+        "lessThanEqual", "greaterThan", "greaterThanEqual",
+        "equal", "notEqual", "textureSize", "textureQueryLod",
+        "textureQueryLevels", "textureSamples", "texture",
+        "textureProj", "textureLod", "textureOffset",
+        "texelFetch", "texelFetchOffset", "textureProjOffset",
+        "textureLodOffset", "textureProjLod", "textureProjLodOffset",
+        "textureGrad", "textureGradOffset", "textureProjGrad",
+        "textureProjGradOffset"
+    };
+}
+
+} // namespace
 
 GLSLHighlighter::GLSLHighlighter(QTextDocument *parent) :
     QSyntaxHighlighter(parent),
-    commentStart("/\\*"),
-    commentEnd("\\*/"),
+    pendingTimer(new QTimer(this)),
+    nextPending(-1),
+    firstVisible(0),
+    lastVisible(100),
+    formatting(true),
+    forcedBlock(-1),
     keywordColor(Qt::black),
     typeColor("#0086b3"),
     variableColor(Qt::black),
@@ -29,179 +132,326 @@ GLSLHighlighter::GLSLHighlighter(QTextDocument *parent) :
     commentColor("#8a8a8a"),
     preprocessorColor("#8a8a8a")
 {
-    setupHighlightingRules();
+    pendingTimer->setSingleShot(true);
+    pendingTimer->setInterval(0);
+    connect(pendingTimer, SIGNAL(timeout()), this, SLOT(highlightPendingBlocks()));
+
+    setupFormats();
+    setupKeywords();
+    setupTypes();
+    setupVariables();
+    setupFunctions();
+}
+
+void GLSLHighlighter::setVisibleBlocks(int first, int last)
+{
+    firstVisible = first;
+    lastVisible = last;
+
+    if (nextPending >= 0) {
+        pendingTimer->start();
+    }
 }
 
 void GLSLHighlighter::highlightBlock(const QString &text)
 {
-    for (auto rule : rules) {
-        QRegularExpressionMatchIterator it = rule.pattern.globalMatch(text);
+    TRACE_SCOPE("highlightBlock", "editor");
+
+    const int length = text.length();
+    const QChar *data = text.constData();
+    const int number = currentBlock().blockNumber();
+    int i = 0;
+
+    // far away blocks still need comment state to be propagated,
+    // so they are scanned, but their formatting is deferred
+    formatting = number == forcedBlock || (number >= firstVisible - visibleMargin
+                                           && number <= lastVisible + visibleMargin);
 
-        while (it.hasNext()) {
-            QRegularExpressionMatch match = it.next();
+    setCurrentBlockState(NormalState);
 
-            setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+    if (previousBlockState() == CommentState) {
+        i = highlightMultiLineComment(text, 0, 0);
+    }
+
+    while (i < length) {
+        const QChar c = data[i];
+        const QChar next = i + 1 < length ? data[i + 1] : QChar();
+
+        if (c == '/' && next == '/') {
+            applyFormat(i, length - i, singleLineCommentFormat);
+            break;
+        }
+
+        if (c == '/' && next == '*') {
+            i = highlightMultiLineComment(text, i, i + 2);
+        }
+        else if (c == '#') {
+            i = highlightPreprocessor(text, i);
+        }
+        else if (c.isLetter() || c == '_') {
+            const int end = scanIdentifier(text, i);
+
+            if (!formatting) {
+                i = end;
+                continue;
+            }
+
+            // refer to block text without copying it
+            const QString word = QString::fromRawData(data + i, end - i);
+            const auto it = words.constFind(word);
+
+            if (it != words.cend()) {
+                setFormat(i, end - i, it.value());
+            }
+
+            i = end;
+        }
+        else if (c.isDigit() || (c == '.' && next.isDigit())) {
+            // numbers are not highlighted, but their suffixes and exponents
+            // must not be mistaken for identifiers
+            i = scanNumber(text, i);
+        }
+        else {
+            i++;
         }
     }
 
-    highlightMultiLineComments(text);
+    HighlightData *highlightData = static_cast<HighlightData*>(currentBlockUserData());
+
+    if (!highlightData) {
+        highlightData = new HighlightData();
+        setCurrentBlockUserData(highlightData);
+    }
+
+    highlightData->pending = !formatting;
+
+    if (!formatting) {
+        schedulePending(number);
+    }
 }
 
-void GLSLHighlighter::highlightMultiLineComments(const QString &text)
+void GLSLHighlighter::highlightPendingBlocks()
 {
-    setCurrentBlockState(0);
+    TRACE_SCOPE("highlightPendingBlocks", "editor");
 
-    int startIndex = 0;
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    // visible blocks go first, within the same time slice
+    QTextBlock block = document()->findBlockByNumber(qMax(0, firstVisible - visibleMargin));
+
+    for (int number = block.blockNumber();
+         block.isValid() && number <= lastVisible + visibleMargin
+         && elapsed.elapsed() < sliceMs;
+         block = block.next(), number++) {
+        if (isPending(block)) {
+            formatPendingBlock(block);
+        }
+    }
 
-    if (previousBlockState() != 1) {
-        startIndex = text.indexOf(commentStart);
+    if (elapsed.elapsed() >= sliceMs) {
+        // next slice starts with the rest of visible blocks
+        pendingTimer->start();
+        return;
     }
 
-    while (startIndex >= 0) {
-        QRegularExpressionMatch match = commentEnd.match(text, startIndex);
-        int endIndex = match.capturedStart();
-        int commentLength = 0;
+    block = document()->findBlockByNumber(qMax(nextPending, 0));
 
-        if (endIndex == -1) {
-            setCurrentBlockState(1);
-            commentLength = text.length() - startIndex;
+    while (block.isValid() && elapsed.elapsed() < sliceMs) {
+        if (isPending(block)) {
+            formatPendingBlock(block);
         }
-        else {
-            commentLength = endIndex - startIndex + match.capturedLength();
+
+        block = block.next();
+    }
+
+    // edits may have moved pending blocks above scan position,
+    // look for them once the end is reached
+    nextPending = block.isValid() ? block.blockNumber() : firstPendingBlock();
+
+    if (nextPending >= 0) {
+        pendingTimer->start();
+    }
+}
+
+void GLSLHighlighter::formatPendingBlock(const QTextBlock &block)
+{
+    // if block state changes, QSyntaxHighlighter goes on with next blocks
+    // in the same call. They are only scanned and queued by highlightBlock()
+    forcedBlock = block.blockNumber();
+    rehighlightBlock(block);
+    forcedBlock = -1;
+}
+
+int GLSLHighlighter::highlightMultiLineComment(const QString &text, int start,
+                                               int searchFrom)
+{
+    int end = text.indexOf(QLatin1String("*/"), searchFrom);
+
+    if (end == -1) {
+        setCurrentBlockState(CommentState);
+        end = text.length();
+    }
+    else {
+        end += 2;
+    }
+
+    applyFormat(start, end - start, multiLineCommentFormat);
+
+    return end;
+}
+
+int GLSLHighlighter::highlightPreprocessor(const QString &text, int start)
+{
+    int end = start + 1;
+
+    // comments inside directives are highlighted as comments
+    while (end < text.length()) {
+        if (text[end] == '/' && end + 1 < text.length()
+                && (text[end + 1] == '/' || text[end + 1] == '*')) {
+            break;
         }
 
-        setFormat(startIndex, commentLength, multiLineCommentFormat);
-        startIndex = text.indexOf(commentStart, startIndex + commentLength);
+        end++;
+    }
+
+    applyFormat(start, end - start, preprocessorFormat);
+
+    return end;
+}
+
+void GLSLHighlighter::applyFormat(int start, int count, const QTextCharFormat &format)
+{
+    if (formatting) {
+        setFormat(start, count, format);
     }
 }
 
-void GLSLHighlighter::setupHighlightingRules()
+bool GLSLHighlighter::isPending(const QTextBlock &block) const
 {
-    setupKeywordRules();
-    setupTypeRules();
-    setupVariableRules();
-    setupFunctionRules();
+    const HighlightData *data = static_cast<const HighlightData*>(block.userData());
 
-    QTextCharFormat format;
-    // add highlighting rule for preprocessor directives
-    format.setForeground(preprocessorColor);
-    format.setFontWeight(QFont::Bold);
-    addRule("#[^\n]*", format);
-    // add rule for single-line comments
-    format.setForeground(commentColor);
-    format.setFontWeight(QFont::Normal);
-    addRule("//[^\n]*", format);
+    return data && data->pending;
+}
+
+int GLSLHighlighter::firstPendingBlock() const
+{
+    int number = 0;
+
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        if (isPending(block)) {
+            return number;
+        }
+
+        number++;
+    }
+
+    return -1;
+}
+
+void GLSLHighlighter::schedulePending(int blockNumber)
+{
+    if (nextPending < 0 || blockNumber < nextPending) {
+        nextPending = blockNumber;
+    }
+
+    if (!pendingTimer->isActive()) {
+        pendingTimer->start();
+    }
+}
+
+int GLSLHighlighter::scanIdentifier(const QString &text, int start) const
+{
+    int end = start + 1;
+
+    while (end < text.length() && (text[end].isLetterOrNumber() || text[end] == '_')) {
+        end++;
+    }
+
+    return end;
+}
+
+int GLSLHighlighter::scanNumber(const QString &text, int start) const
+{
+    const bool hex = text[start] == '0' && start + 1 < text.length()
+            && (text[start + 1] == 'x' || text[start + 1] == 'X');
+    int end = start + 1;
+
+    while (end < text.length()) {
+        const QChar c = text[end];
+        const QChar previous = text[end - 1];
+        const bool exponentSign = !hex && (c == '+' || c == '-')
+                && (previous == 'e' || previous == 'E');
+
+        if (!c.isLetterOrNumber() && c != '.' && !exponentSign) {
+            break;
+        }
+
+        end++;
+    }
+
+    return end;
+}
+
+void GLSLHighlighter::setupFormats()
+{
+    preprocessorFormat.setForeground(preprocessorColor);
+    preprocessorFormat.setFontWeight(QFont::Bold);
+
+    singleLineCommentFormat.setForeground(commentColor);
+    singleLineCommentFormat.setFontWeight(QFont::Normal);
 
     multiLineCommentFormat.setForeground(commentColor);
 }
 
-void GLSLHighlighter::setupKeywordRules()
+void GLSLHighlighter::setupKeywords()
 {
     QTextCharFormat format;
 
-    format.setForeground(Qt::black);
+    format.setForeground(keywordColor);
     format.setFontWeight(QFont::Bold);
 
-    // GLSL keywords
-    QStringList keywordPatterns{
-        "\\battribute\\b", "\\bconst\\b", "\\buniform\\b", "\\bvarying\\b",
-        "\\bbuffer\\b", "\\bshared\\b", "\\bcoherent\\b", "\\bvolatile\\b",
-        "\\brestrict\\b", "\\breadonly\\b", "\\bwriteonly\\b", "\\blayout\\b",
-        "\\bcentroid\\b", "\\bflat\\b", "\\bsmooth\\b", "\\bnoperspective\\b",
-        "\\bpatch\\b", "\\bsample\\b", "\\bbreak\\b", "\\bcontinue\\b",
-        "\\bdo\\b", "\\bfor\\b", "\\bwhile\\b", "\\bswitch\\b", "\\bcase\\b",
-        "\\bdefault\\b", "\\bif\\b", "\\belse\\b", "\\bsubroutine\\b",
-        "\\bin\\b", "\\bout\\b", "\\binout\\b", "\\btrue\\b", "\\bfalse\\b",
-        "\\binvariant\\b", "\\bprecise\\b", "\\bdiscard\\b", "\\breturn\\b",
-        "\\blowp\\b", "\\bmediump\\b", "\\bhighp\\b", "\\bprecision\\b",
-        "\\bstruct\\b"
-    };
-
-    addRules(keywordPatterns, format);
+    addWords(keywordList(), format);
 }
 
-void GLSLHighlighter::setupTypeRules()
+void GLSLHighlighter::setupTypes()
 {
     QTextCharFormat format;
 
     format.setForeground(typeColor);
     format.setFontWeight(QFont::Bold);
-    // GLSL built-in types
-    QStringList typePatterns{
-        "\\bvoid\\b", "\\bbool\\b", "\\bint\\b", "\\buint\\b", "\\bfloat\\b",
-        "\\bdouble\\b", "\\bvec2\\b", "\\bvec3\\b", "\\bvec4\\b", "\\bbvec2\\b",
-        "\\bbvec3\\b", "\\bbvec4\\b", "\\bivec2\\b", "\\bivec3\\b", "\\bivec4\\b",
-        "\\buvec2\\b", "\\buvec3\\b", "\\buvec4\\b", "\\bmat2\\b", "\\bmat3\\b",
-        "\\bmat4\\b", "\\bmat2x2\\b", "\\bmat2x3\\b", "\\bmat2x4\\b",
-        "\\bmat3x2\\b", "\\bmat3x3\\b", "\\bmat3x4\\b", "\\bmat4x2\\b",
-        "\\bmat4x3\\b", "\\bmat4x4\\b", "\\bsampler1D\\b", "\\bimage1D\\b",
-        "\\bsampler2D\\b", "\\bimage2D\\b", "\\bsampler3D\\b", "\\bimage3D\\b"
-    };
 
-    addRules(typePatterns, format);
+    addWords(typeList(), format);
 }
 
-void GLSLHighlighter::setupVariableRules()
+void GLSLHighlighter::setupVariables()
 {
     QTextCharFormat format;
 
     format.setForeground(variableColor);
     format.setFontWeight(QFont::Bold);
-    // GLSL built-in special variables
-    QStringList variablePatterns{
-        "\\bgl_FragCoord\\b", "\\bgl_FrontFacing\\b", "\\bgl_ClipDistance\\b",
-        "\\bgl_CullDistance\\b", "\\bgl_PointCoord\\b", "\\bgl_PrimitiveID\\b",
-        "\\bgl_SampleID\\b", "\\bgl_SamplePosition\\b", "\\bgl_SampleMaskIn\\b",
-        "\\bgl_Layer\\b", "\\bgl_ViewportIndex\\b", "\\bgl_HelperInvocation\\b",
-        "\\bgl_FragDepth\\b", "\\bgl_SampleMask\\b"
-    };
 
-    addRules(variablePatterns, format);
+    addWords(variableList(), format);
 }
 
-void GLSLHighlighter::setupFunctionRules()
+void GLSLHighlighter::setupFunctions()
 {
     QTextCharFormat format;
 
     format.setForeground(functionColor);
     format.setFontWeight(QFont::Bold);
-    // GLSL built-in functions
-    QStringList functionPatterns{
-        "\\bradians\\b", "\\bdegrees\\b", "\\bsin\\b", "\\bcos\\b", "\\btan\\b",
-        "\\basin\\b", "\\bacos\\b", "\\batan\\b", "\\bsinh\\b", "\\bcosh\\b",
-        "\\btanh\\b", "\\basinh\\b", "\\bacosh\\b", "\\batanh\\b", "\\bpow\\b",
-        "\\bexp\\b", "\\blog\\b", "\\bexp2\\b", "\\blog2\\b", "\\bsqrt\\b",
-        "\\binversesqrt\\b", "\\babs\\b", "\\bsign\\b", "\\bfloor\\b",
-        "\\btrunc\\b", "\\bround\\b", "\\broundEven\\b", "\\bceil\\b",
-        "\\bfract\\b", "\\bmod\\b", "\\bmodf\\b", "\\bmin\\b", "\\bmax\\b",
-        "\\bclamp\\b", "\\bmix\\b", "\\bstep\\b", "\\bsmoothstep\\b",
-        "\\bisnan\\b", "\\bisinf\\b", "\\bfma\\b", "\\bfrexp\\b", "\\bldexp\\b",
-        "\\blength\\b", "\\bdistance\\b", "\\bdot\\b", "\\bcross\\b",
-        "\\bnormalize\\b", "\\bftransform\\b", "\\bfaceforward\\b", "\\breflect\\b",
-        "\\brefract\\b", "\\bmatrixCompMult\\b", "\\bouterProduct\\b",
-        "\\btranspose\\b", "\\bdeterminant\\b", "\\binverse\\b", "\\blessThan\\b",
-        "\\blessThanEqual\\b", "\\bgreaterThan\\b", "\\bgreaterThanEqual\\b",
-        "\\bequal\\b", "\\bnotEqual\\b", "\\btextureSize\\b", "\\btextureQueryLod\\b",
-        "\\btextureQueryLevels\\b", "\\btextureSamples\\b", "\\btexture\\b",
-        "\\btextureProj\\b", "\\btextureLod\\b", "\\btextureOffset\\b",
-        "\\btexelFetch\\b", "\\btexelFetchOffset\\b", "\\btextureProjOffset\\b",
-        "\\btextureLodOffset\\b", "\\btextureProjLod\\b", "\\btextureProjLodOffset\\b",
-        "\\btextureGrad\\b", "\\btextureGradOffset\\b", "\\btextureProjGrad\\b",
-        "\\btextureProjGradOffset\\b"
-    };
 
-    addRules(functionPatterns, format);
+    addWords(functionList(), format);
 }
 
-void GLSLHighlighter::addRules(const QStringList &patterns,
-                               const QTextCharFormat &format)
+void GLSLHighlighter::addWords(const QStringList &list, const QTextCharFormat &format)
 {
-    for (auto &pattern : patterns) {
-        addRule(pattern, format);
+    for (const auto &word : list) {
+        words.insert(word, format);
     }
 }
 
-void GLSLHighlighter::addRule(const QString &pattern, const QTextCharFormat &format)
+QStringList GLSLHighlighter::builtinWords()
 {
-    rules.append(HighlightingRule(QRegularExpression(pattern), format));
+    return keywordList() + typeList() + variableList() + functionList();
 }
@@ -20,10 +20,17 @@
 #define GLSLHIGHLIGHTER_H
 
 #include <QSyntaxHighlighter>
-#include <QRegularExpression>
+#include <QTextCharFormat>
 #include <QStringList>
-#include <QVector>
+#include <QHash>
 
+class QTimer;
+
+/// Highlights GLSL source in a single pass over each block.
+/// Identifiers are classified by lookup in a table of known words,
+/// comments, preprocessor directives and numbers are handled by the same scan.
+/// Only blocks near visible ones are formatted right away, others get only
+/// their multi-line comment state and are formatted in background
 class GLSLHighlighter : public QSyntaxHighlighter
 {
     Q_OBJECT
@@ -31,40 +38,72 @@ class GLSLHighlighter : public QSyntaxHighlighter
 public:
     explicit GLSLHighlighter(QTextDocument *parent = Q_NULLPTR);
 
+    /// GLSL keywords, types, built-in variables and functions
+    static QStringList builtinWords();
+
+public slots:
+    /// blocks currently shown in editor, formatted before any others
+    void setVisibleBlocks(int first, int last);
+
 protected:
     void highlightBlock(const QString &text) Q_DECL_OVERRIDE;
 
+private slots:
+    /// format deferred blocks for a limited time, then yield to event loop
+    void highlightPendingBlocks();
+
 private:
-    void highlightMultiLineComments(const QString &text);
+    /// block states
+    enum State
+    {
+        NormalState = 0,
+        /// block ends inside of multi-line comment
+        CommentState = 1
+    };
 
-    void setupHighlightingRules();
-    void setupKeywordRules();
-    void setupTypeRules();
-    void setupVariableRules();
-    void setupFunctionRules();
-    void addRules(const QStringList &patterns, const QTextCharFormat &format);
-    void addRule(const QString &pattern, const QTextCharFormat &format);
+    /// highlight multi-line comment starting at start, closing sequence
+    /// is searched from searchFrom. Returns position after comment
+    int highlightMultiLineComment(const QString &text, int start, int searchFrom);
+    /// highlight preprocessor directive up to comment or end of line.
+    /// Returns position after directive
+    int highlightPreprocessor(const QString &text, int start);
+    /// returns position after identifier starting at start
+    int scanIdentifier(const QString &text, int start) const;
+    /// returns position after numeric literal starting at start
+    int scanNumber(const QString &text, int start) const;
 
-    struct HighlightingRule
-    {
-        HighlightingRule() {}
+    /// set format if current block is formatted, not only scanned
+    void applyFormat(int start, int count, const QTextCharFormat &format);
+    bool isPending(const QTextBlock &block) const;
+    /// number of first block waiting for formatting, -1 if there are none
+    int firstPendingBlock() const;
+    void schedulePending(int blockNumber);
+    /// format pending block without formatting blocks after it
+    void formatPendingBlock(const QTextBlock &block);
 
-        HighlightingRule(const QRegularExpression &pattern,
-                         const QTextCharFormat &format) :
-            pattern(pattern),
-            format(format)
-        {
-        }
+    void setupFormats();
+    void setupKeywords();
+    void setupTypes();
+    void setupVariables();
+    void setupFunctions();
+    void addWords(const QStringList &list, const QTextCharFormat &format);
 
-        QRegularExpression pattern;
-        QTextCharFormat format;
-    };
+    /// formats of known identifiers
+    QHash<QString, QTextCharFormat> words;
 
-    QVector<HighlightingRule> rules;
-    // multi-line comment patterns
-    QRegularExpression commentStart;
-    QRegularExpression commentEnd;
+    QTimer *pendingTimer;
+    /// block number background formatting continues from, -1 if idle
+    int nextPending;
+    int firstVisible;
+    int lastVisible;
+    /// current block gets formats, not only state
+    bool formatting;
+    /// block formatted regardless of visibility, -1 if none. Blocks after it
+    /// that are scanned again because its state changed stay pending
+    int forcedBlock;
 
+    QTextCharFormat preprocessorFormat;
+    QTextCharFormat singleLineCommentFormat;
     QTextCharFormat multiLineCommentFormat;
     QColor keywordColor;
     QColor typeColor;
@@ -0,0 +1,213 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "glstatecache.h"
+#include "effect.h"
+#include "tracer.h"
+
+namespace {
+
+/// binding value meaning actual binding is not known
+const GLuint unknown = GLuint(-1);
+
+} // namespace
+
+GlStateCache::TextureUnit::TextureUnit() :
+    texture2D(unknown),
+    texture3D(unknown),
+    sampler(unknown)
+{
+}
+
+GlStateCache::GlStateCache() :
+    program(unknown),
+    framebuffer(unknown),
+    activeUnit(-1),
+    units(Effect::maxChannels),
+    issued(0),
+    skipped(0),
+    lastIssued(0),
+    lastSkipped(0)
+{
+}
+
+template<typename T>
+bool GlStateCache::changes(T &current, const T &value)
+{
+    if (current == value) {
+        skipped++;
+        return false;
+    }
+
+    current = value;
+    issued++;
+
+    return true;
+}
+
+void GlStateCache::create()
+{
+    initializeOpenGLFunctions();
+}
+
+void GlStateCache::destroy()
+{
+    for (GLuint id : samplers) {
+        glDeleteSamplers(1, &id);
+    }
+
+    samplers.clear();
+
+    for (auto &unit : units) {
+        unit.sampler = unknown;
+    }
+}
+
+void GlStateCache::beginFrame()
+{
+    issued = 0;
+    skipped = 0;
+
+    // Qt binds widget framebuffer and sets viewport before painting
+    invalidate();
+}
+
+void GlStateCache::endFrame()
+{
+    lastIssued = issued;
+    lastSkipped = skipped;
+
+    Tracer &tracer = Tracer::instance();
+
+    if (tracer.isEnabled()) {
+        const qint64 now = tracer.now();
+
+        tracer.record("glCallsIssued", "render", now, 0, issued);
+        tracer.record("glCallsSkipped", "render", now, 0, skipped);
+    }
+}
+
+void GlStateCache::invalidate()
+{
+    program = unknown;
+    framebuffer = unknown;
+    viewportSize = QSize();
+
+    invalidateTextures();
+}
+
+void GlStateCache::invalidateTextures()
+{
+    activeUnit = -1;
+
+    for (auto &unit : units) {
+        unit.texture2D = unknown;
+        unit.texture3D = unknown;
+    }
+}
+
+void GlStateCache::useProgram(GLuint id)
+{
+    if (changes(program, id)) {
+        glUseProgram(id);
+    }
+}
+
+void GlStateCache::bindFramebuffer(GLuint id)
+{
+    if (changes(framebuffer, id)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, id);
+    }
+}
+
+void GlStateCache::viewport(QSize size)
+{
+    if (changes(viewportSize, size)) {
+        glViewport(0, 0, size.width(), size.height());
+    }
+}
+
+void GlStateCache::activeTexture(int unit)
+{
+    Q_ASSERT(unit >= 0 && unit < units.size());
+
+    if (changes(activeUnit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void GlStateCache::bindTexture(int unit, GLenum target, GLuint texture)
+{
+    Q_ASSERT(target == GL_TEXTURE_2D || target == GL_TEXTURE_3D);
+    Q_ASSERT(unit >= 0 && unit < units.size());
+
+    TextureUnit &state = units[unit];
+    GLuint &current = target == GL_TEXTURE_3D ? state.texture3D : state.texture2D;
+
+    if (changes(current, texture)) {
+        activeTexture(unit);
+        glBindTexture(target, texture);
+    }
+}
+
+void GlStateCache::bindSampler(int unit, GLuint id)
+{
+    Q_ASSERT(unit >= 0 && unit < units.size());
+
+    if (changes(units[unit].sampler, id)) {
+        glBindSampler(unit, id);
+    }
+}
+
+GLuint GlStateCache::sampler(GLint minFilter, GLint wrap)
+{
+    const QPair<GLint, GLint> key(minFilter, wrap);
+    auto it = samplers.constFind(key);
+
+    if (it != samplers.constEnd()) {
+        return it.value();
+    }
+
+    Q_ASSERT(minFilter == GL_LINEAR_MIPMAP_LINEAR || minFilter == GL_LINEAR
+             || minFilter == GL_NEAREST);
+    Q_ASSERT(wrap == GL_REPEAT || wrap == GL_CLAMP_TO_EDGE);
+
+    GLuint id = 0;
+
+    glGenSamplers(1, &id);
+    glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, minFilter);
+    glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, minFilter == GL_NEAREST ? GL_NEAREST
+                                                                            : GL_LINEAR);
+    glSamplerParameteri(id, GL_TEXTURE_WRAP_S, wrap);
+    glSamplerParameteri(id, GL_TEXTURE_WRAP_T, wrap);
+    glSamplerParameteri(id, GL_TEXTURE_WRAP_R, wrap);
+
+    samplers.insert(key, id);
+
+    return id;
+}
+
+int GlStateCache::issuedCalls() const
+{
+    return lastIssued;
+}
+
+int GlStateCache::skippedCalls() const
+{
+    return lastSkipped;
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GLSTATECACHE_H
+#define GLSTATECACHE_H
+
+#include <QOpenGLExtraFunctions>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QSize>
+
+/// Tracks program, framebuffer, viewport, texture and sampler bindings
+/// made through it and skips calls that would not change them.
+/// Code binding things directly must be followed by invalidate().
+/// Also owns sampler objects used for effect input channels.
+/// OpenGL context must be current for all methods
+class GlStateCache : protected QOpenGLExtraFunctions
+{
+public:
+    GlStateCache();
+
+    void create();
+    /// delete sampler objects
+    void destroy();
+
+    /// start counting calls of new frame, forget bindings made outside of cache
+    void beginFrame();
+    /// keep counters of finished frame and record them to trace
+    void endFrame();
+
+    /// forget all bindings except samplers, only cache binds sampler objects
+    void invalidate();
+    /// forget texture bindings, after textures were bound for upload
+    void invalidateTextures();
+
+    void useProgram(GLuint program);
+    /// bind both draw and read framebuffer
+    void bindFramebuffer(GLuint framebuffer);
+    void viewport(QSize size);
+    void activeTexture(int unit);
+    /// target is GL_TEXTURE_2D or GL_TEXTURE_3D
+    void bindTexture(int unit, GLenum target, GLuint texture);
+    void bindSampler(int unit, GLuint sampler);
+
+    /// sampler object with specified settings, created on first use
+    GLuint sampler(GLint minFilter, GLint wrap);
+
+    /// calls issued and skipped as redundant in last finished frame
+    int issuedCalls() const;
+    int skippedCalls() const;
+
+private:
+    struct TextureUnit
+    {
+        TextureUnit();
+
+        GLuint texture2D;
+        GLuint texture3D;
+        GLuint sampler;
+    };
+
+    /// count call that would change value, remember new one
+    template<typename T>
+    bool changes(T &current, const T &value);
+
+    GLuint program;
+    GLuint framebuffer;
+    QSize viewportSize;
+    int activeUnit;
+    QVector<TextureUnit> units;
+    /// sampler objects by their min filter and wrap mode
+    QHash<QPair<GLint, GLint>, GLuint> samplers;
+    int issued;
+    int skipped;
+    int lastIssued;
+    int lastSkipped;
+};
+
+#endif // GLSTATECACHE_H
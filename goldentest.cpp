@@ -0,0 +1,198 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "goldentest.h"
+#include "shaderworkshop.h"
+#include "tracer.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QJsonArray>
+#include <QtMath>
+
+GoldenTest::Tolerance::Tolerance() :
+    maxError(0),
+    minPsnr(0.0),
+    minSsim(0.0)
+{
+}
+
+GoldenTest::Result::Result() :
+    time(0.0f),
+    passed(false),
+    compareTimeUs(0)
+{
+}
+
+GoldenTest::GoldenTest(ShaderWorkshop *workshop, const QString &sceneDirectory,
+                       const QString &goldenDirectory, QSize size,
+                       const Tolerance &tolerance) :
+    workshop(workshop),
+    sceneDirectory(sceneDirectory),
+    goldenDirectory(goldenDirectory),
+    size(size),
+    tolerance(tolerance)
+{
+}
+
+QStringList GoldenTest::findScenes(const QString &directory)
+{
+    QStringList files;
+    QDirIterator it(directory, QStringList() << "*.frag" << "*.swproj", QDir::Files,
+                    QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+
+    while (it.hasNext()) {
+        files.append(it.next());
+    }
+
+    // report does not depend on directory listing order
+    files.sort();
+
+    return files;
+}
+
+QVector<GoldenTest::Result> GoldenTest::run(const QString &scene,
+                                            const QVector<GLfloat> &times, bool update)
+{
+    TRACE_SCOPE("goldenTest", "test");
+
+    QVector<Result> results(times.size());
+    QVector<QImage> images;
+    QString error;
+    const bool captured = workshop->captureFrames(scene, times, size, images, error);
+
+    for (int i = 0; i < times.size(); i++) {
+        Result &result = results[i];
+
+        result.scene = sceneDirectory.relativeFilePath(scene);
+        result.time = times[i];
+        result.goldenFile = goldenFile(scene, times[i]);
+
+        if (!captured) {
+            result.error = error;
+            continue;
+        }
+
+        if (update) {
+            QDir().mkpath(QFileInfo(result.goldenFile).absolutePath());
+
+            result.passed = images[i].save(result.goldenFile, "PNG");
+
+            if (!result.passed) {
+                result.error = tr("Could not write golden image");
+            }
+            continue;
+        }
+
+        // scenes without golden images fail until they are captured
+        if (!QFileInfo::exists(result.goldenFile)) {
+            result.error = tr("No golden image, capture it with --update-golden "
+                              "on a known-good build");
+            continue;
+        }
+
+        const QImage golden(result.goldenFile);
+
+        if (golden.isNull()) {
+            result.error = tr("Could not read golden image");
+            continue;
+        }
+
+        if (golden.size() != images[i].size()) {
+            result.error = tr("Golden image is %1x%2")
+                    .arg(golden.width()).arg(golden.height());
+            continue;
+        }
+
+        QElapsedTimer timer;
+
+        timer.start();
+
+        result.difference = ImageDifference::compare(golden, images[i]);
+        result.compareTimeUs = timer.nsecsElapsed() / 1000;
+        result.passed = passes(result.difference);
+    }
+
+    return results;
+}
+
+QJsonObject GoldenTest::report(const QVector<Result> &results, qint64 elapsedMs) const
+{
+    QJsonArray captures;
+    int failed = 0;
+
+    for (const Result &result : results) {
+        QJsonObject capture;
+
+        capture["scene"] = result.scene;
+        capture["time"] = result.time;
+        capture["golden"] = result.goldenFile;
+        capture["passed"] = result.passed;
+
+        if (result.error.isEmpty()) {
+            capture["maxError"] = result.difference.maxError;
+            // identical images have infinite PSNR, JSON has no infinity
+            capture["psnr"] = qIsInf(result.difference.psnr)
+                    ? QJsonValue() : QJsonValue(result.difference.psnr);
+            capture["ssim"] = result.difference.ssim;
+            capture["compareMs"] = result.compareTimeUs / 1000.0;
+        }
+        else {
+            capture["error"] = result.error;
+        }
+
+        captures.append(capture);
+
+        if (!result.passed) {
+            failed++;
+        }
+    }
+
+    QJsonObject limits;
+
+    limits["maxError"] = tolerance.maxError;
+    limits["minPsnr"] = tolerance.minPsnr;
+    limits["minSsim"] = tolerance.minSsim;
+
+    QJsonObject report;
+
+    report["captures"] = captures;
+    report["tolerance"] = limits;
+    report["width"] = size.width();
+    report["height"] = size.height();
+    report["total"] = results.size();
+    report["failed"] = failed;
+    report["elapsedMs"] = elapsedMs;
+
+    return report;
+}
+
+QString GoldenTest::goldenFile(const QString &scene, GLfloat time) const
+{
+    return goldenDirectory.absoluteFilePath(QString("%1@%2s.png")
+                                            .arg(sceneDirectory.relativeFilePath(scene))
+                                            .arg(time));
+}
+
+bool GoldenTest::passes(const ImageDifference &difference) const
+{
+    return difference.maxError <= tolerance.maxError
+            && difference.psnr >= tolerance.minPsnr
+            && difference.ssim >= tolerance.minSsim;
+}
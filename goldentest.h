@@ -0,0 +1,93 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GOLDENTEST_H
+#define GOLDENTEST_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QSize>
+#include <QDir>
+#include <QJsonObject>
+#include <QOpenGLFunctions>
+#include "imagedifference.h"
+
+class ShaderWorkshop;
+
+/// Renders reference scenes headlessly at fixed times through the same
+/// editor and renderer code as interactive use, and compares them with
+/// golden images, so renderer changes can be checked to keep output intact
+class GoldenTest
+{
+    Q_DECLARE_TR_FUNCTIONS(GoldenTest)
+
+public:
+    /// capture passes only if all of them hold
+    struct Tolerance
+    {
+        Tolerance();
+
+        int maxError;
+        double minPsnr;
+        double minSsim;
+    };
+
+    struct Result
+    {
+        Result();
+
+        QString scene;
+        GLfloat time;
+        QString goldenFile;
+        bool passed;
+        /// scene could not be rendered or golden image could not be read
+        QString error;
+        ImageDifference difference;
+        qint64 compareTimeUs;
+    };
+
+    /// editor must have been shown and painted
+    GoldenTest(ShaderWorkshop *workshop, const QString &sceneDirectory,
+               const QString &goldenDirectory, QSize size, const Tolerance &tolerance);
+
+    /// '.frag' shaders and '.swproj' projects in directory and its
+    /// subdirectories, sorted by path
+    static QStringList findScenes(const QString &directory);
+
+    /// render scene at ascending times and compare captures with golden
+    /// images. With update set golden images are replaced by captures
+    QVector<Result> run(const QString &scene, const QVector<GLfloat> &times, bool update);
+    /// machine readable report of results
+    QJsonObject report(const QVector<Result> &results, qint64 elapsedMs) const;
+
+private:
+    /// golden image of scene at time, scene path relative to scene directory
+    /// is kept, so scenes of the same name do not clash
+    QString goldenFile(const QString &scene, GLfloat time) const;
+    bool passes(const ImageDifference &difference) const;
+
+    ShaderWorkshop *workshop;
+    QDir sceneDirectory;
+    QDir goldenDirectory;
+    QSize size;
+    Tolerance tolerance;
+};
+
+#endif // GOLDENTEST_H
@@ -0,0 +1,249 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gpumemory.h"
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+
+namespace {
+
+// GL_NVX_gpu_memory_info and GL_ATI_meminfo, values are in kilobytes
+const GLenum dedicatedVideoMemoryNvx = 0x9047;
+const GLenum currentAvailableVideoMemoryNvx = 0x9049;
+const GLenum textureFreeMemoryAti = 0x87FC;
+
+/// texel size of uncompressed internal format, unknown ones count as RGBA8
+qint64 bytesPerPixel(GLenum format)
+{
+    switch (format) {
+    case GL_R8:
+        return 1;
+    case GL_RG8:
+    case GL_R16F:
+        return 2;
+    case GL_RGB8:
+    case GL_RGBA8:
+    case GL_SRGB8_ALPHA8:
+    case GL_RGB10_A2:
+    case GL_R11F_G11F_B10F:
+    case GL_RG16F:
+    case GL_R32F:
+        return 4;
+    case GL_RGB16F:
+    case GL_RGBA16F:
+    case GL_RG32F:
+        return 8;
+    case GL_RGB32F:
+        return 12;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
+} // namespace
+
+GpuMemory::GpuMemory() :
+    total(0),
+    budgetBytes(0),
+    budgetPolicy(Warn),
+    nvxMemoryInfo(false),
+    atiMemInfo(false),
+    programBinaries(false)
+{
+}
+
+void GpuMemory::create()
+{
+    initializeOpenGLFunctions();
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+
+    nvxMemoryInfo = context->hasExtension("GL_NVX_gpu_memory_info");
+    atiMemInfo = context->hasExtension("GL_ATI_meminfo");
+
+    GLint binaryFormats = 0;
+
+    if (context->format().version() >= qMakePair(4, 1)
+            || context->hasExtension("GL_ARB_get_program_binary")) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    }
+
+    programBinaries = binaryFormats > 0;
+}
+
+void GpuMemory::setUsage(int owner, Category category, qint64 bytes)
+{
+    QVector<qint64> &usage = owners[owner];
+
+    if (usage.isEmpty()) {
+        usage.fill(0, CategoryCount);
+    }
+
+    total += bytes - usage[category];
+    usage[category] = bytes;
+}
+
+void GpuMemory::removeOwner(int owner)
+{
+    for (qint64 bytes : owners.take(owner)) {
+        total -= bytes;
+    }
+}
+
+qint64 GpuMemory::usage(int owner, Category category) const
+{
+    return owners.value(owner).value(category, 0);
+}
+
+qint64 GpuMemory::totalUsage() const
+{
+    return total;
+}
+
+void GpuMemory::setBudget(qint64 bytes, Policy policy)
+{
+    Q_ASSERT(bytes >= 0);
+
+    budgetBytes = bytes;
+    budgetPolicy = policy;
+}
+
+qint64 GpuMemory::budget() const
+{
+    return budgetBytes;
+}
+
+GpuMemory::Policy GpuMemory::policy() const
+{
+    return budgetPolicy;
+}
+
+bool GpuMemory::fits(int owner, Category category, qint64 bytes) const
+{
+    return budgetBytes == 0 || total - usage(owner, category) + bytes <= budgetBytes;
+}
+
+GpuMemoryUsage GpuMemory::snapshot()
+{
+    GpuMemoryUsage result;
+
+    result.owners = owners;
+    result.total = total;
+    result.budget = budgetBytes;
+
+    if (nvxMemoryInfo) {
+        GLint kilobytes = 0;
+
+        glGetIntegerv(dedicatedVideoMemoryNvx, &kilobytes);
+        result.driverTotal = qint64(kilobytes) * 1024;
+
+        glGetIntegerv(currentAvailableVideoMemoryNvx, &kilobytes);
+        result.driverAvailable = qint64(kilobytes) * 1024;
+    }
+    else if (atiMemInfo) {
+        // total free, largest free block, total and largest auxiliary free
+        GLint kilobytes[4] = {0, 0, 0, 0};
+
+        glGetIntegerv(textureFreeMemoryAti, kilobytes);
+        result.driverAvailable = qint64(kilobytes[0]) * 1024;
+    }
+
+    return result;
+}
+
+qint64 GpuMemory::textureBytes(QSize size, GLenum format, bool mipmaps)
+{
+    const qint64 texel = bytesPerPixel(format);
+    qint64 bytes = 0;
+    int width = size.width();
+    int height = size.height();
+
+    forever {
+        bytes += qint64(width) * height * texel;
+
+        // mip chain ends with 1x1 level
+        if (!mipmaps || (width == 1 && height == 1)) {
+            return bytes;
+        }
+
+        width = qMax(width / 2, 1);
+        height = qMax(height / 2, 1);
+    }
+}
+
+qint64 GpuMemory::framebufferBytes(const QOpenGLFramebufferObject *framebuffer, bool mipmaps)
+{
+    return textureBytes(framebuffer->size(), framebuffer->format().internalTextureFormat(),
+                        mipmaps) * framebuffer->textures().size();
+}
+
+qint64 GpuMemory::textureObjectBytes(GLenum target, GLuint texture)
+{
+    qint64 bytes = 0;
+
+    glBindTexture(target, texture);
+
+    // levels of a complete chain, or level 0 only
+    for (int level = 0; ; level++) {
+        GLint width = 0;
+        GLint height = 0;
+        GLint depth = 0;
+        GLint compressed = GL_FALSE;
+
+        glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &width);
+
+        if (width == 0) {
+            break;
+        }
+
+        glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &height);
+        glGetTexLevelParameteriv(target, level, GL_TEXTURE_DEPTH, &depth);
+        glGetTexLevelParameteriv(target, level, GL_TEXTURE_COMPRESSED, &compressed);
+
+        if (compressed == GL_TRUE) {
+            GLint size = 0;
+
+            glGetTexLevelParameteriv(target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+            bytes += size;
+        }
+        else {
+            GLint format = 0;
+
+            glGetTexLevelParameteriv(target, level, GL_TEXTURE_INTERNAL_FORMAT, &format);
+            bytes += qint64(width) * height * qMax(depth, 1) * bytesPerPixel(format);
+        }
+    }
+
+    glBindTexture(target, 0);
+
+    return bytes;
+}
+
+qint64 GpuMemory::programBytes(GLuint program)
+{
+    GLint length = 0;
+
+    // GL_PROGRAM_BINARY_LENGTH is an invalid enum without program binaries
+    if (program && programBinaries) {
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    }
+
+    return length;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GPUMEMORY_H
+#define GPUMEMORY_H
+
+#include <QOpenGLExtraFunctions>
+#include <QMap>
+#include <QVector>
+#include <QSize>
+
+class QOpenGLFramebufferObject;
+
+/// accounted GPU memory at some moment, for GUI thread
+struct GpuMemoryUsage
+{
+    GpuMemoryUsage() :
+        total(0),
+        budget(0),
+        driverTotal(-1),
+        driverAvailable(-1)
+    {
+    }
+
+    /// bytes of each GpuMemory::Category by owner
+    QMap<int, QVector<qint64>> owners;
+    qint64 total;
+    /// 0 if there is no budget
+    qint64 budget;
+    /// dedicated and currently free video memory reported by driver,
+    /// -1 if unknown
+    qint64 driverTotal;
+    qint64 driverAvailable;
+};
+
+/// Accounts GPU memory allocated by renderer by owner and checks allocations
+/// against optional budget. Effects are owners with their indices, frame
+/// history and preview output frames are renderer-wide owners. Sizes are
+/// computed from dimensions and formats, drivers may add padding.
+/// Free video memory is read from GL_NVX_gpu_memory_info or GL_ATI_meminfo
+/// where available. OpenGL context must be current for non-static methods
+/// querying OpenGL
+class GpuMemory : protected QOpenGLExtraFunctions
+{
+public:
+    enum Category
+    {
+        /// framebuffer attachments with mip chains
+        Framebuffers = 0,
+        /// channel textures loaded from files
+        Textures,
+        /// linked programs, as large as their binaries
+        Programs,
+        CategoryCount
+    };
+
+    /// what happens to buffer allocation that does not fit into budget
+    enum Policy
+    {
+        /// allocate it anyway and report it
+        Warn = 0,
+        /// keep previous allocation
+        Refuse,
+        /// halve buffer size until it fits
+        Downsize
+    };
+
+    static const int historyOwner = -1;
+    static const int outputOwner = -2;
+
+    GpuMemory();
+
+    /// detect memory info extensions and program binary support
+    void create();
+
+    void setUsage(int owner, Category category, qint64 bytes);
+    void removeOwner(int owner);
+    qint64 usage(int owner, Category category) const;
+    qint64 totalUsage() const;
+
+    /// 0 bytes for no budget
+    void setBudget(qint64 bytes, Policy policy);
+    qint64 budget() const;
+    Policy policy() const;
+    /// true if owner can use bytes in category instead of its current usage
+    /// without exceeding budget
+    bool fits(int owner, Category category, qint64 bytes) const;
+
+    /// accounting with video memory reported by driver
+    GpuMemoryUsage snapshot();
+
+    /// bytes of 2D texture level 0 and, if mipmaps is true, all other levels
+    static qint64 textureBytes(QSize size, GLenum format, bool mipmaps);
+    /// bytes of all color attachments of framebuffer
+    static qint64 framebufferBytes(const QOpenGLFramebufferObject *framebuffer,
+                                   bool mipmaps);
+    /// bytes of all levels of texture object as reported by driver,
+    /// changes texture binding of active unit
+    qint64 textureObjectBytes(GLenum target, GLuint texture);
+    /// size of program binary, 0 if driver does not support program binaries
+    /// or does not report it
+    qint64 programBytes(GLuint program);
+
+private:
+    QMap<int, QVector<qint64>> owners;
+    qint64 total;
+    qint64 budgetBytes;
+    Policy budgetPolicy;
+    bool nvxMemoryInfo;
+    bool atiMemInfo;
+    bool programBinaries;
+};
+
+#endif // GPUMEMORY_H
@@ -0,0 +1,173 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gputimer.h"
+#include "tracer.h"
+#include <QOpenGLTimerQuery>
+
+namespace {
+
+/// frames between issuing queries and reading their results
+const int framesInFlight = 3;
+/// GPU and CPU clocks drift apart slowly, calibrating them waits for GPU
+const qint64 calibrationIntervalUs = 1000000;
+
+} // namespace
+
+GpuTimer::GpuTimer() :
+    frames(framesInFlight),
+    current(0),
+    calibration(Q_NULLPTR),
+    offset(0),
+    calibratedAt(-1),
+    active(false)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    Q_ASSERT(calibration == Q_NULLPTR);
+}
+
+bool GpuTimer::create()
+{
+    calibration = new QOpenGLTimerQuery();
+
+    if (!calibration->create()) {
+        delete calibration;
+        calibration = Q_NULLPTR;
+
+        return false;
+    }
+
+    return true;
+}
+
+void GpuTimer::destroy()
+{
+    for (auto &frame : frames) {
+        qDeleteAll(frame.queries);
+        frame.queries.clear();
+        frame.ranges.clear();
+        frame.used = 0;
+    }
+
+    delete calibration;
+    calibration = Q_NULLPTR;
+}
+
+void GpuTimer::beginFrame(bool record)
+{
+    Frame &frame = frames[current];
+
+    // this frame slot was used framesInFlight frames ago
+    if (!frame.ranges.isEmpty()) {
+        collect(frame);
+    }
+
+    frame.ranges.clear();
+    frame.used = 0;
+    open.clear();
+
+    active = record && calibration;
+
+    if (!active) {
+        calibratedAt = -1;
+        return;
+    }
+
+    // synchronous timestamp query stalls pipeline, so it is done only
+    // when recording starts and once in a while afterwards
+    if (calibratedAt < 0 || Tracer::instance().now() - calibratedAt >= calibrationIntervalUs) {
+        const qint64 gpuTime = calibration->waitForTimestamp() / 1000;
+
+        calibratedAt = Tracer::instance().now();
+        offset = calibratedAt - gpuTime;
+    }
+
+    frame.offset = offset;
+}
+
+void GpuTimer::endFrame()
+{
+    current = (current + 1) % frames.size();
+}
+
+void GpuTimer::begin(const char *name, int argument)
+{
+    if (!active) {
+        return;
+    }
+
+    Frame &frame = frames[current];
+    Range range{name, argument, nextQuery(frame), -1};
+
+    frame.queries[range.first]->recordTimestamp();
+
+    open.append(frame.ranges.size());
+    frame.ranges.append(range);
+}
+
+void GpuTimer::end()
+{
+    if (!active) {
+        return;
+    }
+
+    Q_ASSERT(!open.isEmpty());
+
+    Frame &frame = frames[current];
+    Range &range = frame.ranges[open.takeLast()];
+
+    range.second = nextQuery(frame);
+    frame.queries[range.second]->recordTimestamp();
+}
+
+void GpuTimer::collect(Frame &frame)
+{
+    Tracer &tracer = Tracer::instance();
+
+    // timestamps complete in order, so last one tells about all of them.
+    // Results GPU still did not reach are dropped rather than waited for
+    if (!tracer.isEnabled() || !frame.queries[frame.used - 1]->isResultAvailable()) {
+        return;
+    }
+
+    for (const auto &range : frame.ranges) {
+        if (range.second < 0) {
+            continue;
+        }
+
+        const qint64 start = frame.queries[range.first]->waitForResult() / 1000;
+        const qint64 end = frame.queries[range.second]->waitForResult() / 1000;
+
+        tracer.recordGpu(range.name, start + frame.offset, end - start, range.argument);
+    }
+}
+
+int GpuTimer::nextQuery(Frame &frame)
+{
+    if (frame.used == frame.queries.size()) {
+        QOpenGLTimerQuery *query = new QOpenGLTimerQuery();
+
+        query->create();
+        frame.queries.append(query);
+    }
+
+    return frame.used++;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <QVector>
+
+class QOpenGLTimerQuery;
+
+/// Measures GPU time ranges with timestamp queries and passes them to Tracer.
+/// Results are read several frames later, so measuring never stalls rendering.
+/// OpenGL context must be current for all methods
+class GpuTimer
+{
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    /// returns false if timer queries are not supported
+    bool create();
+    void destroy();
+
+    /// collect finished results, start measuring new frame if record is true
+    void beginFrame(bool record);
+    void endFrame();
+
+    /// start nested time range, name must be a string literal
+    void begin(const char *name, int argument = -1);
+    void end();
+
+private:
+    struct Range
+    {
+        const char *name;
+        int argument;
+        /// indices of start and end queries
+        int first;
+        int second;
+    };
+
+    struct Frame
+    {
+        Frame() :
+            used(0),
+            offset(0)
+        {
+        }
+
+        QVector<QOpenGLTimerQuery*> queries;
+        int used;
+        QVector<Range> ranges;
+        /// CPU minus GPU time in microseconds at frame start
+        qint64 offset;
+    };
+
+    void collect(Frame &frame);
+    int nextQuery(Frame &frame);
+
+    QVector<Frame> frames;
+    int current;
+    /// ranges begun but not ended yet
+    QVector<int> open;
+    QOpenGLTimerQuery *calibration;
+    /// CPU minus GPU time in microseconds at last calibration
+    qint64 offset;
+    /// Tracer time of last calibration, -1 if not calibrated while recording
+    qint64 calibratedAt;
+    bool active;
+};
+
+#endif // GPUTIMER_H
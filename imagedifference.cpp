@@ -0,0 +1,230 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "imagedifference.h"
+#include <QImage>
+#include <QVector>
+#include <QtMath>
+#include <limits>
+
+namespace {
+
+/// SSIM windows are 2x2 blocks of 4x4 pixels, overlapping by one block,
+/// like in x264
+const int blockSize = 4;
+const int windowPixels = 4 * blockSize * blockSize;
+const float ssimC1 = 0.01f * 0.01f * 255 * 255 * windowPixels;
+const float ssimC2 = 0.03f * 0.03f * 255 * 255 * windowPixels * (windowPixels - 1);
+/// squared errors of a row are summed in 32 bits
+const int maxWidth = 16384;
+
+/// sums of pixel values of both images, their squares and products
+struct Sums
+{
+    void resize(int size)
+    {
+        a.fill(0, size);
+        b.fill(0, size);
+        squares.fill(0, size);
+        products.fill(0, size);
+    }
+
+    QVector<qint32> a;
+    QVector<qint32> b;
+    /// sum of squares of both images
+    QVector<qint32> squares;
+    QVector<qint32> products;
+};
+
+void compareRow(const uchar *a, const uchar *b, int count, int &maxError, quint64 &squares)
+{
+    int rowMax = 0;
+    quint32 rowSquares = 0;
+
+    for (int i = 0; i < count; i++) {
+        int d = int(a[i]) - int(b[i]);
+
+        d = d < 0 ? -d : d;
+        rowMax = rowMax > d ? rowMax : d;
+        rowSquares += quint32(d * d);
+    }
+
+    maxError = qMax(maxError, rowMax);
+    squares += rowSquares;
+}
+
+/// BT.601 luma of RGBX pixels
+void convertToLuma(const uchar *pixels, int width, quint8 *luma)
+{
+    for (int x = 0; x < width; x++) {
+        const uchar *pixel = pixels + 4 * x;
+
+        luma[x] = quint8((77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8);
+    }
+}
+
+/// sums of 4x4 blocks of a row of blocks, columns is scratch space.
+/// Without restrict GCC needs more run-time alias checks for the column
+/// loop than it allows and leaves it scalar
+void sumBlocks(const quint8 *__restrict a, const quint8 *__restrict b,
+               int width, int blocks, Sums &columns, Sums &row)
+{
+    const int count = blocks * blockSize;
+
+    columns.resize(count);
+
+    qint32 *ca = columns.a.data();
+    qint32 *cb = columns.b.data();
+    qint32 *cs = columns.squares.data();
+    qint32 *cp = columns.products.data();
+
+    // vertical sums first, so inner loop runs over whole row
+    for (int y = 0; y < blockSize; y++, a += width, b += width) {
+        for (int x = 0; x < count; x++) {
+            const qint32 va = a[x];
+            const qint32 vb = b[x];
+
+            ca[x] += va;
+            cb[x] += vb;
+            cs[x] += va * va + vb * vb;
+            cp[x] += va * vb;
+        }
+    }
+
+    qint32 *ra = row.a.data();
+    qint32 *rb = row.b.data();
+    qint32 *rs = row.squares.data();
+    qint32 *rp = row.products.data();
+
+    for (int k = 0; k < blocks; k++) {
+        const int x = k * blockSize;
+
+        ra[k] = ca[x] + ca[x + 1] + ca[x + 2] + ca[x + 3];
+        rb[k] = cb[x] + cb[x + 1] + cb[x + 2] + cb[x + 3];
+        rs[k] = cs[x] + cs[x + 1] + cs[x + 2] + cs[x + 3];
+        rp[k] = cp[x] + cp[x + 1] + cp[x + 2] + cp[x + 3];
+    }
+}
+
+/// SSIM of windows made of blocks of two adjacent block rows
+double sumWindowSimilarity(const Sums &top, const Sums &bottom, int windows, float *values)
+{
+    const qint32 *ta = top.a.constData();
+    const qint32 *tb = top.b.constData();
+    const qint32 *ts = top.squares.constData();
+    const qint32 *tp = top.products.constData();
+    const qint32 *ba = bottom.a.constData();
+    const qint32 *bb = bottom.b.constData();
+    const qint32 *bs = bottom.squares.constData();
+    const qint32 *bp = bottom.products.constData();
+
+    for (int k = 0; k < windows; k++) {
+        const float a = ta[k] + ta[k + 1] + ba[k] + ba[k + 1];
+        const float b = tb[k] + tb[k + 1] + bb[k] + bb[k + 1];
+        const float squares = ts[k] + ts[k + 1] + bs[k] + bs[k + 1];
+        const float products = tp[k] + tp[k + 1] + bp[k] + bp[k + 1];
+        // sums scaled by window size instead of dividing them
+        const float variance = squares * windowPixels - a * a - b * b;
+        const float covariance = products * windowPixels - a * b;
+
+        values[k] = (2.0f * a * b + ssimC1) * (2.0f * covariance + ssimC2)
+                  / ((a * a + b * b + ssimC1) * (variance + ssimC2));
+    }
+
+    // float sum would not be vectorized anyway without reassociation
+    double sum = 0.0;
+
+    for (int k = 0; k < windows; k++) {
+        sum += values[k];
+    }
+
+    return sum;
+}
+
+double structuralSimilarity(const quint8 *a, const quint8 *b, int width, int height)
+{
+    const int blocksX = width / blockSize;
+    const int blocksY = height / blockSize;
+    const int windows = blocksX - 1;
+    Sums columns;
+    Sums rows[2];
+    QVector<float> values(windows);
+    double sum = 0.0;
+
+    rows[0].resize(blocksX);
+    rows[1].resize(blocksX);
+
+    for (int y = 0; y < blocksY; y++) {
+        const int offset = y * blockSize * width;
+
+        sumBlocks(a + offset, b + offset, width, blocksX, columns, rows[y & 1]);
+
+        if (y > 0) {
+            sum += sumWindowSimilarity(rows[(y - 1) & 1], rows[y & 1], windows,
+                                       values.data());
+        }
+    }
+
+    return sum / (double(windows) * (blocksY - 1));
+}
+
+} // namespace
+
+ImageDifference::ImageDifference() :
+    maxError(0),
+    psnr(std::numeric_limits<double>::infinity()),
+    ssim(1.0)
+{
+}
+
+ImageDifference ImageDifference::compare(const QImage &expected, const QImage &actual)
+{
+    Q_ASSERT(expected.size() == actual.size());
+    Q_ASSERT(expected.width() >= 2 * blockSize && expected.height() >= 2 * blockSize);
+    Q_ASSERT(expected.width() <= maxWidth);
+
+    // bytes in R, G, B order with alpha set to 255 in both
+    const QImage a = expected.convertToFormat(QImage::Format_RGBX8888);
+    const QImage b = actual.convertToFormat(QImage::Format_RGBX8888);
+    const int width = a.width();
+    const int height = a.height();
+    QVector<quint8> lumaA(width * height);
+    QVector<quint8> lumaB(width * height);
+    ImageDifference difference;
+    quint64 squares = 0;
+
+    for (int y = 0; y < height; y++) {
+        const uchar *rowA = a.constScanLine(y);
+        const uchar *rowB = b.constScanLine(y);
+
+        compareRow(rowA, rowB, width * 4, difference.maxError, squares);
+        convertToLuma(rowA, width, lumaA.data() + y * width);
+        convertToLuma(rowB, width, lumaB.data() + y * width);
+    }
+
+    if (squares) {
+        // alpha bytes add nothing to squares, only color channels are counted
+        const double mse = double(squares) / (double(width) * height * 3);
+
+        difference.psnr = 10.0 * std::log10(255.0 * 255.0 / mse);
+        difference.ssim = structuralSimilarity(lumaA.constData(), lumaB.constData(),
+                                               width, height);
+    }
+
+    return difference;
+}
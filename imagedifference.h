@@ -0,0 +1,44 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMAGEDIFFERENCE_H
+#define IMAGEDIFFERENCE_H
+
+class QImage;
+
+/// Difference between two images of the same size, RGB channels are compared
+/// and alpha is ignored. Kernels work on whole rows of contiguous arrays
+/// without branches, so compiler vectorizes them
+struct ImageDifference
+{
+    ImageDifference();
+
+    /// largest difference of any channel of any pixel, from 0 to 255
+    int maxError;
+    /// peak signal-to-noise ratio of all channels in dB,
+    /// infinite for identical images
+    double psnr;
+    /// mean structural similarity of luma over 8x8 windows,
+    /// 1 for identical images
+    double ssim;
+
+    /// images must be the same size, from 8x8 to 16384 pixels wide
+    static ImageDifference compare(const QImage &expected, const QImage &actual);
+};
+
+#endif // IMAGEDIFFERENCE_H
@@ -0,0 +1,169 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "librarybrowser.h"
+#include <QLabel>
+#include <QLineEdit>
+#include <QListView>
+#include <QPushButton>
+#include <QBoxLayout>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
+#include <QStandardItemModel>
+#include <QSortFilterProxyModel>
+
+namespace {
+
+const int fileNameRole = Qt::UserRole;
+const int projectRole = Qt::UserRole + 1;
+/// file name and contents filter is matched against
+const int searchRole = Qt::UserRole + 2;
+const int filterDelay = 150;
+
+} // namespace
+
+LibraryBrowser::LibraryBrowser(QWidget *parent) :
+    QWidget(parent, Qt::Window),
+    library(new ShaderLibrary(this)),
+    directoryLabel(new QLabel(this)),
+    filterEdit(new QLineEdit(this)),
+    view(new QListView(this)),
+    statusLabel(new QLabel(this)),
+    model(new QStandardItemModel(this)),
+    filterModel(new QSortFilterProxyModel(this))
+{
+    setWindowTitle(tr("Shader Library"));
+    resize(800, 600);
+
+    QPushButton *directoryButton = new QPushButton(tr("Directory..."), this);
+    QHBoxLayout *directoryLayout = new QHBoxLayout();
+
+    directoryLayout->addWidget(directoryButton);
+    directoryLayout->addWidget(directoryLabel, 1);
+
+    filterEdit->setPlaceholderText(tr("Filter by name or contents"));
+    filterEdit->setClearButtonEnabled(true);
+
+    filterModel->setSourceModel(model);
+    filterModel->setFilterRole(searchRole);
+    filterModel->setFilterCaseSensitivity(Qt::CaseInsensitive);
+
+    view->setModel(filterModel);
+    view->setViewMode(QListView::IconMode);
+    view->setIconSize(QSize(160, 90));
+    view->setResizeMode(QListView::Adjust);
+    view->setMovement(QListView::Static);
+    view->setUniformItemSizes(true);
+    view->setWordWrap(true);
+    // only visible items are laid out while entries keep coming
+    view->setLayoutMode(QListView::Batched);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    layout->addLayout(directoryLayout);
+    layout->addWidget(filterEdit);
+    layout->addWidget(view, 1);
+    layout->addWidget(statusLabel);
+
+    filterTimer.setSingleShot(true);
+    filterTimer.setInterval(filterDelay);
+
+    connect(directoryButton, SIGNAL(clicked()), this, SLOT(chooseDirectory()));
+    connect(filterEdit, SIGNAL(textChanged(QString)), &filterTimer, SLOT(start()));
+    connect(&filterTimer, SIGNAL(timeout()), this, SLOT(applyFilter()));
+    connect(view, SIGNAL(activated(QModelIndex)), this, SLOT(entryActivated(QModelIndex)));
+
+    connect(library, SIGNAL(entriesFound(QVector<LibraryEntry>)),
+            this, SLOT(entriesFound(QVector<LibraryEntry>)));
+    connect(library, SIGNAL(indexingFinished(int)), this, SLOT(indexingFinished(int)));
+    connect(library, SIGNAL(thumbnailReady(QString,QImage)),
+            this, SLOT(thumbnailReady(QString,QImage)));
+}
+
+void LibraryBrowser::chooseDirectory()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Shader Library"),
+                                                          directoryLabel->text());
+
+    if (!directory.isEmpty()) {
+        setDirectory(directory);
+    }
+}
+
+void LibraryBrowser::entriesFound(const QVector<LibraryEntry> &entries)
+{
+    const QDir directory(directoryLabel->text());
+
+    for (const LibraryEntry &entry : entries) {
+        QStandardItem *item = new QStandardItem(QFileInfo(entry.fileName).completeBaseName());
+
+        item->setToolTip(directory.relativeFilePath(entry.fileName));
+        item->setEditable(false);
+        item->setData(entry.fileName, fileNameRole);
+        item->setData(entry.project, projectRole);
+        item->setData(entry.fileName + '\n' + entry.text, searchRole);
+
+        model->appendRow(item);
+        items.insert(entry.fileName, item);
+    }
+
+    statusLabel->setText(tr("Indexing, %1 files found").arg(model->rowCount()));
+}
+
+void LibraryBrowser::indexingFinished(int count)
+{
+    statusLabel->setText(tr("%1 files").arg(count));
+}
+
+void LibraryBrowser::thumbnailReady(const QString &fileName, const QImage &thumbnail)
+{
+    QStandardItem *item = items.value(fileName);
+
+    if (item) {
+        item->setIcon(QPixmap::fromImage(thumbnail));
+    }
+}
+
+void LibraryBrowser::applyFilter()
+{
+    filterModel->setFilterFixedString(filterEdit->text());
+}
+
+void LibraryBrowser::entryActivated(const QModelIndex &index)
+{
+    const QString fileName = index.data(fileNameRole).toString();
+
+    if (index.data(projectRole).toBool()) {
+        emit projectOpenRequested(fileName);
+    }
+    else {
+        emit shaderOpenRequested(fileName);
+    }
+}
+
+void LibraryBrowser::setDirectory(const QString &directory)
+{
+    model->clear();
+    items.clear();
+
+    directoryLabel->setText(directory);
+    statusLabel->setText(tr("Indexing..."));
+
+    library->setDirectory(directory);
+}
@@ -0,0 +1,72 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBRARYBROWSER_H
+#define LIBRARYBROWSER_H
+
+#include <QWidget>
+#include <QHash>
+#include <QTimer>
+#include "shaderlibrary.h"
+
+class QLabel;
+class QLineEdit;
+class QListView;
+class QModelIndex;
+class QStandardItem;
+class QStandardItemModel;
+class QSortFilterProxyModel;
+
+/// Window listing shaders and projects of a directory with their thumbnails.
+/// Filter matches file names and contents, activated entry is opened in editor
+class LibraryBrowser : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit LibraryBrowser(QWidget *parent = Q_NULLPTR);
+
+signals:
+    void shaderOpenRequested(const QString &fileName);
+    void projectOpenRequested(const QString &fileName);
+
+private slots:
+    void chooseDirectory();
+    void entriesFound(const QVector<LibraryEntry> &entries);
+    void indexingFinished(int count);
+    void thumbnailReady(const QString &fileName, const QImage &thumbnail);
+    void applyFilter();
+    void entryActivated(const QModelIndex &index);
+
+private:
+    void setDirectory(const QString &directory);
+
+    ShaderLibrary *library;
+    QLabel *directoryLabel;
+    QLineEdit *filterEdit;
+    QListView *view;
+    QLabel *statusLabel;
+    QStandardItemModel *model;
+    QSortFilterProxyModel *filterModel;
+    /// items by file name, for thumbnails
+    QHash<QString, QStandardItem*> items;
+    /// filter is applied once typing pauses
+    QTimer filterTimer;
+};
+
+#endif // LIBRARYBROWSER_H
@@ -17,8 +17,191 @@
  */
 
 #include "shaderworkshop.h"
+#include "batchvalidator.h"
+#include "goldentest.h"
 #include <QApplication>
 #include <QSurfaceFormat>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+
+namespace {
+
+bool hasArgument(int argc, char *argv[], const char *argument)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!qstrcmp(argv[i], argument)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// compile and link shaders of a directory tree without editor window,
+/// print JSON report. Returns 1 if any shader failed
+int validateShaders(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    QCommandLineParser parser;
+    QCommandLineOption validateOption("validate",
+            QCoreApplication::translate("main", "Compile and link all .frag files "
+                                        "under <directory>, print JSON report."),
+            "directory");
+    QCommandLineOption threadsOption("threads",
+            QCoreApplication::translate("main", "Number of compiler threads, "
+                                        "one per core by default."),
+            "count", "0");
+
+    parser.addHelpOption();
+    parser.addOption(validateOption);
+    parser.addOption(threadsOption);
+    parser.process(app);
+
+    const QString directory = parser.value(validateOption);
+    const QStringList files = BatchValidator::findShaders(directory);
+
+    // mistyped path must not pass as an empty library
+    if (!QFileInfo(directory).isDir() || files.isEmpty()) {
+        QTextStream(stderr) << QCoreApplication::translate("main", "No .frag files found in %1")
+                               .arg(directory)
+                            << '\n';
+        return 1;
+    }
+
+    BatchValidator validator(parser.value(threadsOption).toInt());
+    QElapsedTimer timer;
+
+    timer.start();
+
+    const QVector<BatchValidator::Result> results = validator.validate(files);
+    const QJsonObject report = validator.report(results, timer.elapsed());
+
+    QTextStream(stdout) << QJsonDocument(report).toJson();
+
+    return report["failed"].toInt() > 0 ? 1 : 0;
+}
+
+/// render scenes of a directory tree at fixed times and compare them with
+/// golden images, print JSON report. Returns 1 if any capture failed
+int runGoldenTest(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QCommandLineParser parser;
+    QCommandLineOption goldenOption("golden",
+            QCoreApplication::translate("main", "Render .frag and .swproj scenes under "
+                                        "<directory>, compare them with golden images "
+                                        "and print JSON report."),
+            "directory");
+    QCommandLineOption goldenDirectoryOption("golden-dir",
+            QCoreApplication::translate("main", "Directory of golden images, 'golden' "
+                                        "in scene directory by default."),
+            "directory");
+    QCommandLineOption updateOption("update-golden",
+            QCoreApplication::translate("main", "Replace golden images with captures."));
+    QCommandLineOption timesOption("times",
+            QCoreApplication::translate("main", "Comma separated iTime values in seconds "
+                                        "scenes are captured at."),
+            "times", "0,1,5");
+    QCommandLineOption sizeOption("size",
+            QCoreApplication::translate("main", "Capture size in pixels."),
+            "WxH", "640x360");
+    QCommandLineOption maxErrorOption("max-error",
+            QCoreApplication::translate("main", "Largest allowed difference of any "
+                                        "channel, from 0 to 255."),
+            "value", "0");
+    QCommandLineOption minPsnrOption("min-psnr",
+            QCoreApplication::translate("main", "Smallest allowed PSNR in dB."),
+            "value", "0");
+    QCommandLineOption minSsimOption("min-ssim",
+            QCoreApplication::translate("main", "Smallest allowed SSIM, up to 1."),
+            "value", "0");
+
+    parser.addHelpOption();
+    parser.addOption(goldenOption);
+    parser.addOption(goldenDirectoryOption);
+    parser.addOption(updateOption);
+    parser.addOption(timesOption);
+    parser.addOption(sizeOption);
+    parser.addOption(maxErrorOption);
+    parser.addOption(minPsnrOption);
+    parser.addOption(minSsimOption);
+    parser.process(app);
+
+    QVector<GLfloat> times;
+    bool valid = true;
+
+    for (const QString &value : parser.value(timesOption).split(',')) {
+        bool ok = false;
+
+        times.append(value.toFloat(&ok));
+        valid = valid && ok && times.last() >= 0.0f;
+    }
+
+    // playback only moves forward while capturing
+    std::sort(times.begin(), times.end());
+
+    const QStringList dimensions = parser.value(sizeOption).split('x');
+    const QSize size = dimensions.size() == 2
+            ? QSize(dimensions[0].toInt(), dimensions[1].toInt()) : QSize();
+
+    // image comparison works on 8x8 windows
+    valid = valid && size.width() >= 8 && size.height() >= 8 && size.width() <= 16384;
+
+    if (!valid) {
+        QTextStream(stderr) << QCoreApplication::translate("main", "Invalid times or size")
+                            << '\n';
+        return 1;
+    }
+
+    GoldenTest::Tolerance tolerance;
+
+    tolerance.maxError = parser.value(maxErrorOption).toInt();
+    tolerance.minPsnr = parser.value(minPsnrOption).toDouble();
+    tolerance.minSsim = parser.value(minSsimOption).toDouble();
+
+    const QString sceneDirectory = parser.value(goldenOption);
+    const QString goldenDirectory = parser.isSet(goldenDirectoryOption)
+            ? parser.value(goldenDirectoryOption)
+            : QDir(sceneDirectory).filePath("golden");
+    const QStringList scenes = GoldenTest::findScenes(sceneDirectory);
+
+    if (!QFileInfo(sceneDirectory).isDir() || scenes.isEmpty()) {
+        QTextStream(stderr) << QCoreApplication::translate("main", "No scenes found in %1")
+                               .arg(sceneDirectory)
+                            << '\n';
+        return 1;
+    }
+
+    // renderer context is created and main image effect is added when editor
+    // is shown and painted for the first time
+    ShaderWorkshop window;
+    window.show();
+    window.repaint();
+    QCoreApplication::processEvents();
+
+    GoldenTest test(&window, sceneDirectory, goldenDirectory, size, tolerance);
+    QVector<GoldenTest::Result> results;
+    QElapsedTimer timer;
+
+    timer.start();
+
+    for (const QString &scene : scenes) {
+        results += test.run(scene, times, parser.isSet(updateOption));
+    }
+
+    const QJsonObject report = test.report(results, timer.elapsed());
+
+    QTextStream(stdout) << QJsonDocument(report).toJson();
+
+    return report["failed"].toInt() > 0 ? 1 : 0;
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
@@ -31,6 +214,14 @@ int main(int argc, char *argv[])
 
     QSurfaceFormat::setDefaultFormat(format);
 
+    if (hasArgument(argc, argv, "--validate")) {
+        return validateShaders(argc, argv);
+    }
+
+    if (hasArgument(argc, argv, "--golden")) {
+        return runGoldenTest(argc, argv);
+    }
+
     QApplication a(argc, argv);
     ShaderWorkshop w;
     w.show();
@@ -0,0 +1,97 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "offscreenworker.h"
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+
+OffscreenWorker::OffscreenWorker(QOpenGLContext *shareContext) :
+    context(Q_NULLPTR),
+    surface(new QOffscreenSurface())
+{
+    context = createContext(shareContext, surface);
+}
+
+OffscreenWorker::~OffscreenWorker()
+{
+    Q_ASSERT(!thread.isRunning());
+
+    delete context;
+    delete surface;
+}
+
+QOpenGLContext* OffscreenWorker::createContext(QOpenGLContext *shareContext,
+                                               QOffscreenSurface *surface)
+{
+    QOpenGLContext *context = new QOpenGLContext();
+
+    if (shareContext) {
+        context->setFormat(shareContext->format());
+        context->setShareContext(shareContext);
+    }
+
+    context->create();
+
+    surface->setFormat(context->format());
+    surface->create();
+
+    return context;
+}
+
+void OffscreenWorker::start(const QString &threadName)
+{
+    Q_ASSERT(!thread.isRunning());
+
+    context->moveToThread(&thread);
+    moveToThread(&thread);
+
+    thread.setObjectName(threadName);
+    thread.start();
+}
+
+void OffscreenWorker::stop()
+{
+    if (!thread.isRunning()) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(this, "release", Qt::BlockingQueuedConnection);
+
+    thread.quit();
+    thread.wait();
+}
+
+bool OffscreenWorker::makeCurrent()
+{
+    return context->isValid() && context->makeCurrent(surface);
+}
+
+void OffscreenWorker::releaseResources()
+{
+}
+
+void OffscreenWorker::release()
+{
+    releaseResources();
+
+    // context must be destroyed in the thread it is current in
+    context->doneCurrent();
+
+    delete context;
+    context = Q_NULLPTR;
+}
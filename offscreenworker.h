@@ -0,0 +1,70 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OFFSCREENWORKER_H
+#define OFFSCREENWORKER_H
+
+#include <QObject>
+#include <QThread>
+
+class QOpenGLContext;
+class QOffscreenSurface;
+
+/// Base of objects doing OpenGL work on their own thread with their own
+/// offscreen context. Context and surface are created in GUI thread,
+/// as required by some platforms, and context moves to worker thread
+/// together with worker when it starts
+class OffscreenWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// must be created in GUI thread. Context shares objects with shareContext
+    /// and uses its format, without shareContext default format is used
+    explicit OffscreenWorker(QOpenGLContext *shareContext = Q_NULLPTR);
+    /// worker must be stopped
+    ~OffscreenWorker();
+
+    /// context created in GUI thread for surface, not moved to any thread
+    static QOpenGLContext* createContext(QOpenGLContext *shareContext,
+                                         QOffscreenSurface *surface);
+
+    /// move worker to new thread with specified name and start it. GUI thread only
+    void start(const QString &threadName);
+    /// release OpenGL objects and context on worker thread, wait for thread
+    /// to finish. GUI thread only
+    void stop();
+
+protected:
+    /// make context current on worker thread, false if it can not be used
+    bool makeCurrent();
+    /// delete OpenGL objects of worker before context is destroyed,
+    /// context is current if it was made current before
+    virtual void releaseResources();
+
+    QOpenGLContext *context;
+
+private slots:
+    void release();
+
+private:
+    QThread thread;
+    QOffscreenSurface *surface;
+};
+
+#endif // OFFSCREENWORKER_H
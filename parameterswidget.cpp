@@ -0,0 +1,212 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "parameterswidget.h"
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QSlider>
+#include <QLabel>
+#include <QPushButton>
+#include <QCheckBox>
+#include <QColorDialog>
+
+ParametersWidget::ParametersWidget(QWidget *parent) :
+    QWidget(parent),
+    layout(new QFormLayout(this))
+{
+    layout->setContentsMargins(0, 0, 0, 0);
+    hide();
+}
+
+void ParametersWidget::setParameters(const QList<ShaderParameter> &list)
+{
+    QList<ShaderParameter> updated = list;
+
+    for (auto &parameter : updated) {
+        for (const auto &old : params) {
+            if (old.name == parameter.name && old.type == parameter.type
+                    && old.control == parameter.control) {
+                parameter.value = old.value;
+                break;
+            }
+        }
+
+        if (parameter.control == ShaderParameter::Slider) {
+            parameter.value.setX(qBound(parameter.minimum, parameter.value.x(),
+                                        parameter.maximum));
+        }
+    }
+
+    params = updated;
+
+    createControls();
+}
+
+QList<ShaderParameter> ParametersWidget::parameters() const
+{
+    return params;
+}
+
+void ParametersWidget::setValues(const QHash<QString, QVector4D> &values)
+{
+    for (int i = 0; i < params.size(); i++) {
+        if (values.contains(params[i].name)) {
+            setValue(i, values.value(params[i].name));
+        }
+    }
+
+    createControls();
+}
+
+void ParametersWidget::createControls()
+{
+    while (layout->count() > 0) {
+        QLayoutItem *item = layout->takeAt(0);
+
+        delete item->widget();
+        delete item;
+    }
+
+    for (int i = 0; i < params.size(); i++) {
+        QWidget *control = Q_NULLPTR;
+
+        switch (params[i].control) {
+        case ShaderParameter::Slider:
+            control = createSlider(i);
+            break;
+        case ShaderParameter::Color:
+            control = createColorButton(i);
+            break;
+        case ShaderParameter::Toggle:
+            control = createToggle(i);
+            break;
+        }
+
+        layout->addRow(params[i].name, control);
+    }
+
+    setVisible(!params.isEmpty());
+}
+
+QWidget* ParametersWidget::createSlider(int index)
+{
+    const ShaderParameter &parameter = params[index];
+    const bool integer = parameter.type == GL_INT;
+
+    QWidget *widget = new QWidget(this);
+    QHBoxLayout *box = new QHBoxLayout(widget);
+    QSlider *slider = new QSlider(Qt::Horizontal, widget);
+    QLabel *label = new QLabel(formatValue(parameter), widget);
+
+    box->setContentsMargins(0, 0, 0, 0);
+    box->addWidget(slider);
+    box->addWidget(label);
+
+    const float range = parameter.maximum - parameter.minimum;
+
+    if (integer) {
+        slider->setRange(qRound(parameter.minimum), qRound(parameter.maximum));
+        slider->setValue(qRound(parameter.value.x()));
+    }
+    else {
+        slider->setRange(0, sliderSteps);
+        slider->setValue(range > 0.0f ?
+                    qRound((parameter.value.x() - parameter.minimum) / range * sliderSteps) : 0);
+    }
+
+    connect(slider, &QSlider::valueChanged, [this, index, integer, range, label](int position) {
+        const ShaderParameter &parameter = params[index];
+        float value = integer ? position
+                              : parameter.minimum + range * position / sliderSteps;
+
+        setValue(index, QVector4D(value, 0.0f, 0.0f, 0.0f));
+        label->setText(formatValue(params[index]));
+    });
+
+    return widget;
+}
+
+QWidget* ParametersWidget::createColorButton(int index)
+{
+    QPushButton *button = new QPushButton(this);
+
+    auto showColor = [button](const QColor &color) {
+        button->setStyleSheet(QString("background-color: %1").arg(color.name()));
+    };
+
+    showColor(toColor(params[index].value));
+
+    connect(button, &QPushButton::clicked, [this, index, showColor]() {
+        const ShaderParameter &parameter = params[index];
+        QColorDialog::ColorDialogOptions options;
+
+        if (parameter.type == GL_FLOAT_VEC4) {
+            options |= QColorDialog::ShowAlphaChannel;
+        }
+
+        QColor color = QColorDialog::getColor(toColor(parameter.value), this,
+                                              parameter.name, options);
+
+        if (!color.isValid()) {
+            return;
+        }
+
+        showColor(color);
+        setValue(index, QVector4D(color.redF(), color.greenF(), color.blueF(),
+                                  parameter.type == GL_FLOAT_VEC4 ? color.alphaF() : 1.0f));
+    });
+
+    return button;
+}
+
+QWidget* ParametersWidget::createToggle(int index)
+{
+    QCheckBox *box = new QCheckBox(this);
+
+    box->setChecked(params[index].value.x() != 0.0f);
+
+    connect(box, &QCheckBox::toggled, [this, index](bool checked) {
+        setValue(index, QVector4D(checked ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f));
+    });
+
+    return box;
+}
+
+void ParametersWidget::setValue(int index, const QVector4D &value)
+{
+    Q_ASSERT(index >= 0 && index < params.size());
+
+    params[index].value = value;
+
+    emit parameterChanged(params[index].name, value);
+}
+
+QString ParametersWidget::formatValue(const ShaderParameter &parameter)
+{
+    if (parameter.type == GL_INT) {
+        return QString::number(static_cast<int>(parameter.value.x()));
+    }
+
+    return QString::number(parameter.value.x(), 'f', 3);
+}
+
+QColor ParametersWidget::toColor(const QVector4D &value)
+{
+    return QColor::fromRgbF(qBound(0.0f, value.x(), 1.0f), qBound(0.0f, value.y(), 1.0f),
+                            qBound(0.0f, value.z(), 1.0f), qBound(0.0f, value.w(), 1.0f));
+}
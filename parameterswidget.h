@@ -0,0 +1,61 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARAMETERSWIDGET_H
+#define PARAMETERSWIDGET_H
+
+#include <QWidget>
+#include <QHash>
+#include "shaderparameter.h"
+
+class QFormLayout;
+
+/// Controls for annotated shader uniforms of a single page
+class ParametersWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ParametersWidget(QWidget *parent = Q_NULLPTR);
+
+    /// replace parameters, values of parameters with the same name,
+    /// type and control are kept
+    void setParameters(const QList<ShaderParameter> &list);
+    QList<ShaderParameter> parameters() const;
+    /// set values of existing parameters by name
+    void setValues(const QHash<QString, QVector4D> &values);
+
+signals:
+    void parameterChanged(const QString &name, const QVector4D &value);
+
+private:
+    void createControls();
+    QWidget* createSlider(int index);
+    QWidget* createColorButton(int index);
+    QWidget* createToggle(int index);
+    void setValue(int index, const QVector4D &value);
+    static QString formatValue(const ShaderParameter &parameter);
+    static QColor toColor(const QVector4D &value);
+
+    QFormLayout *layout;
+    QList<ShaderParameter> params;
+    /// number of steps for sliders of float parameters
+    static const int sliderSteps = 1000;
+};
+
+#endif // PARAMETERSWIDGET_H
@@ -0,0 +1,50 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "presenterwindow.h"
+#include <QKeyEvent>
+
+PresenterWindow::PresenterWindow(const QSurfaceFormat &format, QScreen *screen) :
+    QWindow(screen)
+{
+    setSurfaceType(QSurface::OpenGLSurface);
+    setFormat(format);
+    setTitle(tr("Shader Workshop"));
+}
+
+void PresenterWindow::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_Escape || event->key() == Qt::Key_F11) {
+        emit closeRequested();
+        return;
+    }
+
+    QWindow::keyPressEvent(event);
+}
+
+bool PresenterWindow::event(QEvent *event)
+{
+    if (event->type() == QEvent::Close) {
+        // owner decides when window goes away
+        event->ignore();
+        emit closeRequested();
+        return true;
+    }
+
+    return QWindow::event(event);
+}
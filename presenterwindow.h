@@ -0,0 +1,44 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRESENTERWINDOW_H
+#define PRESENTERWINDOW_H
+
+#include <QWindow>
+
+/// Native OpenGL window frames are presented to directly, without widget
+/// composition. Renderer makes its own context current on the window,
+/// so all effects are shared with preview and nothing is compiled again
+class PresenterWindow : public QWindow
+{
+    Q_OBJECT
+
+public:
+    /// format must be the one of renderer context
+    explicit PresenterWindow(const QSurfaceFormat &format, QScreen *screen = Q_NULLPTR);
+
+signals:
+    /// Escape or F11 pressed or window closed by user
+    void closeRequested();
+
+protected:
+    void keyPressEvent(QKeyEvent *event) Q_DECL_OVERRIDE;
+    bool event(QEvent *event) Q_DECL_OVERRIDE;
+};
+
+#endif // PRESENTERWINDOW_H
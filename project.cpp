@@ -0,0 +1,217 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "project.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QObject>
+
+bool Project::load(const QString &fileName, QString &error)
+{
+    QFile file(fileName);
+
+    if (!file.open(QFile::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+    if (document.isNull()) {
+        error = parseError.errorString();
+        return false;
+    }
+
+    QJsonObject root = document.object();
+
+    if (root.value("version").toInt() != version) {
+        error = QObject::tr("Unsupported project version");
+        return false;
+    }
+
+    // texture paths are stored relative to project file
+    const QDir projectDir = QFileInfo(fileName).absoluteDir();
+
+    driver = root.value("driver").toString();
+    thumbnail = QImage::fromData(QByteArray::fromBase64(
+                                     root.value("thumbnail").toString().toLatin1()), "PNG");
+    pages.clear();
+
+    for (const auto &pageValue : root.value("pages").toArray()) {
+        QJsonObject object = pageValue.toObject();
+        QJsonArray size = object.value("bufferSize").toArray();
+        ProjectPage page;
+
+        page.name = object.value("name").toString();
+        page.source = object.value("source").toString();
+        page.bufferSize = QSize(size.at(0).toInt(), size.at(1).toInt());
+        page.bufferFormat = object.value("bufferFormat").toInt();
+        page.updateMode = object.value("updateMode").toInt(page.updateMode);
+        page.updateValue = qMax(object.value("updateValue").toInt(page.updateValue), 1);
+
+        for (const auto &channelValue : object.value("channels").toArray()) {
+            QJsonObject channelObject = channelValue.toObject();
+            ProjectChannel channel;
+
+            channel.input = channelObject.value("input").toString();
+            channel.filter = channelObject.value("filter").toInt(channel.filter);
+            channel.wrap = channelObject.value("wrap").toInt(channel.wrap);
+            channel.attachment = channelObject.value("attachment").toInt(channel.attachment);
+
+            QString texture = channelObject.value("texture").toString();
+
+            if (!texture.isEmpty()) {
+                channel.textureFile = QDir::cleanPath(projectDir.absoluteFilePath(texture));
+            }
+
+            page.channels.append(channel);
+        }
+
+        QJsonObject parameters = object.value("parameters").toObject();
+
+        for (auto it = parameters.constBegin(); it != parameters.constEnd(); ++it) {
+            QJsonArray value = it.value().toArray();
+
+            page.parameters.insert(it.key(), QVector4D(value.at(0).toDouble(),
+                                                       value.at(1).toDouble(),
+                                                       value.at(2).toDouble(),
+                                                       value.at(3).toDouble()));
+        }
+
+        QJsonObject binary = object.value("programBinary").toObject();
+
+        page.binaryFormat = binary.value("format").toInt();
+        page.binary = QByteArray::fromBase64(binary.value("data").toString().toLatin1());
+        page.binarySourceHash = QByteArray::fromHex(
+                    binary.value("sourceHash").toString().toLatin1());
+
+        pages.append(page);
+    }
+
+    return true;
+}
+
+bool Project::save(const QString &fileName, QString &error) const
+{
+    const QDir projectDir = QFileInfo(fileName).absoluteDir();
+    QJsonArray pagesArray;
+
+    for (const auto &page : pages) {
+        QJsonObject object;
+        QJsonArray channelsArray;
+
+        for (const auto &channel : page.channels) {
+            QJsonObject channelObject;
+
+            if (!channel.input.isEmpty()) {
+                channelObject["input"] = channel.input;
+            }
+
+            if (!channel.textureFile.isEmpty()) {
+                channelObject["texture"] = projectDir.relativeFilePath(channel.textureFile);
+            }
+
+            channelObject["filter"] = channel.filter;
+            channelObject["wrap"] = channel.wrap;
+
+            if (channel.attachment) {
+                channelObject["attachment"] = channel.attachment;
+            }
+
+            channelsArray.append(channelObject);
+        }
+
+        object["name"] = page.name;
+        object["source"] = page.source;
+        object["bufferSize"] = QJsonArray{page.bufferSize.width(), page.bufferSize.height()};
+        object["bufferFormat"] = static_cast<int>(page.bufferFormat);
+        object["updateMode"] = page.updateMode;
+        object["updateValue"] = page.updateValue;
+        object["channels"] = channelsArray;
+
+        if (!page.parameters.isEmpty()) {
+            QJsonObject parameters;
+
+            for (auto it = page.parameters.constBegin(); it != page.parameters.constEnd(); ++it) {
+                const QVector4D &value = it.value();
+
+                parameters[it.key()] = QJsonArray{value.x(), value.y(), value.z(), value.w()};
+            }
+
+            object["parameters"] = parameters;
+        }
+
+        if (!page.binary.isEmpty()) {
+            QJsonObject binary;
+
+            binary["format"] = static_cast<int>(page.binaryFormat);
+            binary["data"] = QString::fromLatin1(page.binary.toBase64());
+            binary["sourceHash"] = QString::fromLatin1(page.binarySourceHash.toHex());
+
+            object["programBinary"] = binary;
+        }
+
+        pagesArray.append(object);
+    }
+
+    QJsonObject root;
+
+    root["version"] = version;
+    root["driver"] = driver;
+    root["pages"] = pagesArray;
+
+    if (!thumbnail.isNull()) {
+        QByteArray png;
+        QBuffer buffer(&png);
+
+        buffer.open(QBuffer::WriteOnly);
+        thumbnail.save(&buffer, "PNG");
+
+        root["thumbnail"] = QString::fromLatin1(png.toBase64());
+    }
+
+    // write to temporary file so failed save does not truncate existing project
+    QSaveFile file(fileName);
+
+    if (!file.open(QFile::WriteOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+
+    if (!file.commit()) {
+        error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+QByteArray Project::sourceHash(const QString &source)
+{
+    return QCryptographicHash::hash(source.toUtf8(), QCryptographicHash::Sha1);
+}
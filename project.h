@@ -0,0 +1,97 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROJECT_H
+#define PROJECT_H
+
+#include <QString>
+#include <QList>
+#include <QSize>
+#include <QImage>
+#include <QByteArray>
+#include <QHash>
+#include <QVector4D>
+#include <QOpenGLFunctions>
+
+struct ProjectChannel
+{
+    ProjectChannel() :
+        filter(GL_LINEAR_MIPMAP_LINEAR),
+        wrap(GL_REPEAT),
+        attachment(0)
+    {
+    }
+
+    /// name of the page used as input, empty if there is none
+    QString input;
+    /// texture file used as input, empty if there is none
+    QString textureFile;
+    GLint filter;
+    GLint wrap;
+    /// output of input page sampled by channel
+    int attachment;
+};
+
+struct ProjectPage
+{
+    ProjectPage() :
+        bufferFormat(0),
+        updateMode(0),
+        updateValue(1),
+        binaryFormat(0)
+    {
+    }
+
+    QString name;
+    QString source;
+    QSize bufferSize;
+    GLenum bufferFormat;
+    /// buffer update policy mode and its frame divisor or rate
+    int updateMode;
+    int updateValue;
+    QList<ProjectChannel> channels;
+    /// user parameter values by name
+    QHash<QString, QVector4D> parameters;
+    /// optional program binary linked from source with expanded includes
+    GLenum binaryFormat;
+    QByteArray binary;
+    QByteArray binarySourceHash;
+};
+
+/// ShaderWorkshop project: all pages with their sources and channel settings,
+/// plus optional program binaries to skip compilation on open.
+/// Stored as JSON document
+class Project
+{
+public:
+    bool load(const QString &fileName, QString &error);
+    bool save(const QString &fileName, QString &error) const;
+
+    /// hash identifying source program binary was linked from
+    static QByteArray sourceHash(const QString &source);
+
+    /// driver that produced program binaries
+    QString driver;
+    QImage thumbnail;
+    QList<ProjectPage> pages;
+
+private:
+    static const int version = 1;
+};
+
+#endif // PROJECT_H
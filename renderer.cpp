@@ -17,93 +17,473 @@
  */
 
 #include "renderer.h"
+#include "shadercompiler.h"
+#include "glshader.h"
+#include "framehistory.h"
+#include "renderthread.h"
+#include "tracer.h"
 #include <QMouseEvent>
+#include <QWindow>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace {
+
+/// baked variants kept per effect
+const int maxVariants = 16;
+/// parameters must stay unchanged for this long to be auto baked
+const int bakeDelayMs = 1500;
+/// stop waiting for frame if GPU does not finish it for this long
+const GLuint64 frameFenceTimeoutNs = 1000000000;
+/// entries of iMouseHistory uniform array
+const int mouseHistorySize = 64;
+/// events kept if no frame is rendered, for example while window is hidden
+const int maxMouseEvents = 1024;
+/// input latencies kept for percentiles
+const int maxInputLatencies = 1000;
+/// buffers are not downsized below this size to fit into memory budget
+const int minBudgetedBufferSide = 16;
+const qint64 megabyte = 1024 * 1024;
+
+/// pack position for atomic storage, x goes to high 32 bits
+quint64 packPoint(const QPoint &point)
+{
+    return (quint64(quint32(point.x())) << 32) | quint32(point.y());
+}
+
+QPoint unpackPoint(quint64 value)
+{
+    return QPoint(qint32(quint32(value >> 32)), qint32(quint32(value)));
+}
+
+/// number of outputs declared with 'layout(location = N) out'
+/// or used as 'iImageN' by compute shader
+int declaredOutputs(const QString &source)
+{
+    static const QRegularExpression output(
+                "layout\\s*\\(\\s*location\\s*=\\s*(\\d+)\\s*\\)\\s*out\\b"
+                "|\\biImage(\\d+)\\b");
+    int outputs = 1;
+
+    for (auto it = output.globalMatch(source); it.hasNext();) {
+        const QRegularExpressionMatch match = it.next();
+        const QString location = match.captured(1).isEmpty() ? match.captured(2)
+                                                               : match.captured(1);
+
+        outputs = qMax(outputs, location.toInt() + 1);
+    }
+
+    return qMin(outputs, int(Effect::maxOutputs));
+}
+
+} // namespace
 
 Renderer::Renderer(QWidget *parent) :
     QOpenGLWidget(parent),
     mainImage(Q_NULLPTR),
-    updateTimer(new QTimer(this)),
+    mainImageIndex(-1),
+    vertexShader(Q_NULLPTR),
+    history(Q_NULLPTR),
+    currentFrame(-1),
+    simulatedFrame(-1),
+    timeBase(0.0f),
+    paused(false),
+    heatmapEffect(-1),
+    heatmapSupported(false),
+    memoryUsageDirty(true),
+    reportedMemoryUsage(-1),
+    overBudget(false),
+    vao(Q_NULLPTR),
+    mouseHistoryValues(mouseHistorySize, QVector4D(0.0f, 0.0f, 0.0f, -1.0f)),
+    mouseRevision(0),
+    mouseButtonDown(false),
+    maxFramesInFlight(0),
     fboTextureSize(1024, 768),
-    fps(60)
+    presenterWindow(Q_NULLPTR),
+    presenterExposed(false),
+    targetFramebuffer(Q_NULLPTR),
+    frameTime(0.0f),
+    frameCount(0),
+    fps(60),
+    programBinarySupported(false),
+    computeSupported(false),
+    renderThread(Q_NULLPTR),
+    compiler(Q_NULLPTR),
+    bakeTimer(new QTimer(this)),
+    autoBake(false),
+    latestMouse(0),
+    playbackState{false, -1, 0.0f, 0, -1},
+    outputs(),
+    publishedOutput(-1),
+    shownOutput(-1),
+    outputReadFramebuffer(0)
 {
     timer.start();
+
+    bakeTimer->setSingleShot(true);
+    bakeTimer->setInterval(bakeDelayMs);
+    connect(bakeTimer, SIGNAL(timeout()), this, SLOT(bakeIdleEffects()));
+    connect(this, SIGNAL(frameSwapped()), this, SLOT(framePresented()));
 }
 
 Renderer::~Renderer()
 {
-    makeCurrent();
+    if (!renderThread) {
+        return;
+    }
 
-    vbo.release();
-    vao.release();
+    // queued commands may still request baked variants
+    renderThread->stop([this]() { cleanupRendering(); });
 
-    delete vertexShader;
-    qDeleteAll(effects);
+    // stop background compilation before context goes away
+    delete compiler;
 
+    makeCurrent();
+    context()->functions()->glDeleteFramebuffers(1, &outputReadFramebuffer);
     doneCurrent();
 }
 
 void Renderer::initializeGL()
+{
+    // widget context only draws frames finished by render thread,
+    // effects are rendered by context of render thread sharing its objects
+    QOpenGLContext *glContext = context();
+
+    glContext->functions()->glGenFramebuffers(1, &outputReadFramebuffer);
+
+    compiler = new ShaderCompiler(glContext, this);
+    connect(compiler, SIGNAL(compiled(QByteArray,GLuint,QString)),
+            this, SLOT(variantCompiled(QByteArray,GLuint,QString)));
+
+    // thread makes its context current when started, then runs commands
+    renderThread = new RenderThread(glContext, this);
+    renderThread->start([this]() { frameTimeout(); }, fps);
+    renderThread->post([this]() { initializeRendering(); });
+}
+
+void Renderer::initializeRendering()
 {
     initializeOpenGLFunctions();
 
     glClearColor(1.0f, 0.0f, 0.4f, 1.0f);
 
+    driver = QString("%1; %2; %3")
+            .arg(reinterpret_cast<const char*>(glGetString(GL_VENDOR)))
+            .arg(reinterpret_cast<const char*>(glGetString(GL_RENDERER)))
+            .arg(reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+    GLint binaryFormats = 0;
+    QOpenGLContext *glContext = renderThread->context();
+
+    if (glContext->format().version() >= qMakePair(4, 1)
+            || glContext->hasExtension("GL_ARB_get_program_binary")) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    }
+
+    programBinarySupported = binaryFormats > 0;
+    computeSupported = !glContext->isOpenGLES()
+            && (glContext->format().version() >= qMakePair(4, 3)
+                || glContext->hasExtension("GL_ARB_compute_shader"));
+
+    setupParallelShaderCompile();
+
     setupVertexShader();
 
     setupBuffers();
 
-    connect(updateTimer, SIGNAL(timeout()), this, SLOT(update()));
-    updateTimer->start(1000.0 / fps);
+    gpuTimer.create();
+    glState.create();
+    memory.create();
+    heatmapSupported = heatmap.create(vertexShader);
+
+    // created in render thread, its compressed frames arrive here
+    history = new FrameHistory();
+    history->create();
+}
+
+void Renderer::cleanupRendering()
+{
+    vbo.release();
+    vao->release();
+    delete vao;
+
+    for (GLsync fence : frameFences) {
+        glDeleteSync(fence);
+    }
+
+    for (auto &output : outputs) {
+        delete output.framebuffer;
+        glDeleteSync(output.rendered);
+        glDeleteSync(output.shown);
+    }
+
+    gpuTimer.destroy();
+    glState.destroy();
+    heatmap.destroy();
+    history->destroy();
+
+    delete history;
+    delete vertexShader;
+    qDeleteAll(effects);
 }
 
 void Renderer::resizeGL(int w, int h)
 {
-    viewSize = QSize(w, h);
+    const QSize size(w, h);
+
+    renderThread->post([this, size]() {
+        widgetViewSize = size;
+
+        if (!presenterWindow) {
+            viewSize = widgetViewSize;
+        }
+    });
+
     QOpenGLWidget::resizeGL(w, h);
 }
 
 void Renderer::paintGL()
 {
-    // there is no reason to render at all if we don't have main image
-    if (!mainImage) {
+    TRACE_SCOPE("paintGL", "render");
+
+    showOutput();
+}
+
+void Renderer::frameTimeout()
+{
+    if (presenterWindow) {
+        renderPresenter();
+    }
+    else {
+        renderOutput();
+    }
+}
+
+void Renderer::renderOutput()
+{
+    // nothing to render before main image exists and preview is laid out
+    if (!mainImage || viewSize.isEmpty()) {
         return;
     }
 
-    renderEffects();
+    int index = 0;
+    GLsync shown = 0;
 
-    renderMainImage();
+    {
+        QMutexLocker locker(&outputMutex);
+
+        // the one neither waiting to be shown nor shown now
+        while (index == publishedOutput || index == shownOutput) {
+            index++;
+        }
+
+        shown = outputs[index].shown;
+        outputs[index].shown = 0;
+    }
+
+    OutputFrame &output = outputs[index];
+
+    // preview may still be reading it on GPU
+    if (shown) {
+        glWaitSync(shown, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(shown);
+    }
+
+    if (!output.framebuffer || output.framebuffer->size() != viewSize) {
+        delete output.framebuffer;
+        output.framebuffer = new QOpenGLFramebufferObject(viewSize);
+    }
+
+    targetFramebuffer = output.framebuffer;
+    renderFrame();
+
+    GLsync rendered = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // other context waits for fence, it must reach GPU
+    glFlush();
+
+    {
+        QMutexLocker locker(&outputMutex);
+
+        // preview skips frame it did not show in time
+        if (publishedOutput >= 0) {
+            glDeleteSync(outputs[publishedOutput].rendered);
+            outputs[publishedOutput].rendered = 0;
+        }
+
+        output.texture = output.framebuffer->texture();
+        output.size = output.framebuffer->size();
+        output.rendered = rendered;
+        publishedOutput = index;
+    }
+
+    QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
 }
 
-void Renderer::mousePressEvent(QMouseEvent *event)
+void Renderer::showOutput()
 {
-    if (event->button() == Qt::LeftButton) {
-        QPoint pos = event->pos();
+    QOpenGLExtraFunctions *gl = context()->extraFunctions();
+    GLsync rendered = 0;
+    GLsync shown = 0;
+    GLuint texture = 0;
+    QSize frameSize;
+
+    {
+        QMutexLocker locker(&outputMutex);
+
+        if (publishedOutput >= 0) {
+            shownOutput = publishedOutput;
+            publishedOutput = -1;
+            rendered = outputs[shownOutput].rendered;
+            outputs[shownOutput].rendered = 0;
+        }
+
+        if (shownOutput >= 0) {
+            texture = outputs[shownOutput].texture;
+            frameSize = outputs[shownOutput].size;
+            shown = outputs[shownOutput].shown;
+            outputs[shownOutput].shown = 0;
+        }
+    }
 
-        convertPointToOpenGl(pos);
+    if (!texture) {
+        gl->glClearColor(1.0f, 0.0f, 0.4f, 1.0f);
+        gl->glClear(GL_COLOR_BUFFER_BIT);
+        return;
+    }
 
-        mouse = QVector4D(pos.x(), pos.y(), pos.x(), pos.y());
+    if (rendered) {
+        gl->glWaitSync(rendered, 0, GL_TIMEOUT_IGNORED);
+        gl->glDeleteSync(rendered);
     }
+
+    // frame is shown again, previous draw of it is ordered before this one
+    gl->glDeleteSync(shown);
+
+    const QSize targetSize = size() * devicePixelRatioF();
+
+    gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, outputReadFramebuffer);
+    gl->glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D, texture, 0);
+    gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, defaultFramebufferObject());
+    gl->glBlitFramebuffer(0, 0, frameSize.width(), frameSize.height(),
+                          0, 0, targetSize.width(), targetSize.height(),
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+
+    shown = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    gl->glFlush();
+
+    QMutexLocker locker(&outputMutex);
+
+    outputs[shownOutput].shown = shown;
 }
 
-void Renderer::mouseMoveEvent(QMouseEvent *event)
+void Renderer::renderFrame()
 {
-    QPoint pos = event->pos();
+    // there is no reason to render at all if we don't have main image
+    if (!mainImage) {
+        return;
+    }
 
-    convertPointToOpenGl(pos);
+    // wait before frame time is taken, so frame shows the newest state
+    waitFramesInFlight();
+    applyMouseEvents();
+
+    gpuTimer.beginFrame(Tracer::instance().isEnabled());
+    gpuTimer.begin("frame");
+    glState.beginFrame();
+
+    if (paused) {
+        presentFrame();
+    }
+    else {
+        // continue from frame playback was resumed at
+        syncSimulation(currentFrame);
+
+        const int frame = currentFrame + 1;
+
+        simulateFrame(frame, timeBase + timer.elapsed() / 1000.0f);
+        latchMouse();
+        renderMainImage();
+        history->storeFrame(frame, targetFramebuffer, viewSize);
+        glState.invalidate();
+        currentFrame = frame;
+    }
+
+    if (effects.contains(heatmapEffect)) {
+        renderHeatmap();
+    }
 
-    mouse.setX(pos.x());
-    mouse.setY(pos.y());
+    glState.endFrame();
+    gpuTimer.end();
+    gpuTimer.endFrame();
+
+    if (maxFramesInFlight > 0) {
+        frameFences.append(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+
+    updateMemoryUsage();
+
+    // frames rendered while paused can extend playback too
+    publishPlaybackState();
+
+    if (!paused) {
+        emit playbackFrameChanged(currentFrame);
+    }
 }
 
-void Renderer::mouseReleaseEvent(QMouseEvent *event)
+bool Renderer::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched != presenter) {
+        return QOpenGLWidget::eventFilter(watched, event);
+    }
+
+    QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
+
+    switch (event->type()) {
+    case QEvent::Expose:
+    case QEvent::Resize:
+        updatePresenterState();
+        break;
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+        if (mouseEvent->button() == Qt::LeftButton) {
+            queueMouseEvent(mouseEvent);
+        }
+        break;
+    case QEvent::MouseMove:
+        // windows get moves without buttons pressed, widgets do not
+        if (mouseEvent->buttons() != Qt::NoButton) {
+            queueMouseEvent(mouseEvent);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return QOpenGLWidget::eventFilter(watched, event);
+}
+
+void Renderer::mousePressEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton) {
-        QPoint pos = event->pos();
+        queueMouseEvent(event);
+    }
+}
 
-        convertPointToOpenGl(pos);
+void Renderer::mouseMoveEvent(QMouseEvent *event)
+{
+    queueMouseEvent(event);
+}
 
-        mouse.setZ(-qAbs(pos.x()));
-        mouse.setW(-qAbs(pos.y()));
+void Renderer::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        queueMouseEvent(event);
     }
 }
 
@@ -122,7 +502,7 @@ QString Renderer::defaultFragmentShader() const
         "uniform vec2 iResolution;\n"
         "// mouse pixel coords. xy: current (if LMB down), zw: click\n"
         "uniform vec4 iMouse;\n"
-        "// input channels\n"
+        "// input channels, declare as sampler3D for volume textures\n"
         "uniform sampler2D iChannel0;\n"
         "uniform sampler2D iChannel1;\n"
         "uniform sampler2D iChannel2;\n"
@@ -144,250 +524,1952 @@ QString Renderer::defaultFragmentShader() const
 
 void Renderer::createEffect(int index)
 {
-    Q_ASSERT(!effects.contains(index));
+    renderThread->post([this, index]() {
+        Q_ASSERT(!effects.contains(index));
+
+        // budget is checked before anything is allocated
+        QSize size = budgetedBufferSize(index, fboTextureSize, GL_RGBA8, 1);
 
-    Effect *effect = createEffect();
+        if (!size.isValid()) {
+            // new buffer has no previous size to keep, it starts at the smallest
+            size = QSize(minBudgetedBufferSide, minBudgetedBufferSide);
+        }
 
-    effects[index] = effect;
+        Effect *effect = createEffect(size);
 
-    // first created effect will become the main image
-    if (!mainImage) {
-        mainImage = effect;
-    }
+        effects[index] = effect;
+
+        // first created effect will become the main image
+        if (!mainImage) {
+            mainImage = effect;
+            mainImageIndex = index;
+        }
+
+        updateRenderOrder();
+
+        // keyframes have no copy of new buffer
+        history->clear();
+        memoryUsageDirty = true;
+    });
 }
 
 void Renderer::deleteEffect(int index)
 {
-    Q_ASSERT(effects.contains(index));
+    renderThread->post([this, index]() {
+        Q_ASSERT(effects.contains(index));
 
-    Effect *effect = effects.value(index);
+        Effect *effect = effects.value(index);
 
-    int removed = effects.remove(index);
+        int removed = effects.remove(index);
 
-    Q_ASSERT(removed == 1);
+        Q_ASSERT(removed == 1);
 
-    // prevent using this effect as other effects inputs before deletion
-    removeEffectFromInputs(effect);
+        updateRenderOrder();
 
-    makeCurrent();
+        // prevent using this effect as other effects inputs before deletion
+        removeEffectFromInputs(effect);
 
-    delete effect;
+        if (heatmapEffect == index) {
+            heatmapEffect = -1;
+        }
 
-    doneCurrent();
+        history->clear();
+        clearVariants(index, *effect);
+        memory.removeOwner(index);
+        // inputs may have sampled it with mipmaps
+        memoryUsageDirty = true;
+        delete effect;
+    });
 }
 
 QString Renderer::recompileEffectShader(int index, const QString &source)
 {
-    Q_ASSERT(effects.contains(index));
+    QHash<int, QString> sources;
+    sources.insert(index, source);
 
-    Effect *effect = effects.value(index);
-    QOpenGLShader *fragment = effect->fragmentShader;
-    QString log;
+    return recompileEffectShaders(sources).value(index);
+}
 
-    makeCurrent();
+QHash<int, QString> Renderer::recompileEffectShaders(const QHash<int, QString> &sources)
+{
+    // compilation logs are shown right away, wait for them
+    return renderThread->call<QHash<int, QString>>([this, &sources]() {
+        TRACE_SCOPE("recompileEffectShaders", "compile");
+
+        QHash<int, QString> logs;
+        /// compute shaders of sources with work group size, then their programs
+        QHash<int, GLuint> computeShaders;
+        QHash<int, GLuint> computePrograms;
+
+        // submit all shaders before checking any of them,
+        // so driver is free to compile them in parallel
+        for (auto it = sources.cbegin(); it != sources.cend(); ++it) {
+            Q_ASSERT(effects.contains(it.key()));
+
+            Effect *effect = effects.value(it.key());
+
+            if (GlShader::isCompute(it.value())) {
+                if (!computeSupported) {
+                    logs[it.key()] = tr("ERROR: compute shaders require OpenGL 4.3 "
+                                        "or GL_ARB_compute_shader\n");
+                }
+                else if (effect == mainImage) {
+                    logs[it.key()] = tr("ERROR: main image must be a fragment shader\n");
+                }
+                else {
+                    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+
+                    compileShaderSource(shader, it.value());
+                    computeShaders.insert(it.key(), shader);
+                }
+
+                continue;
+            }
 
-    if (!fragment->compileSourceCode(source.toLocal8Bit().data())) {
-        // failed to compile new source code, save log and fallback
-        log = fragment->log();
+            compileShaderSource(effect->fragmentShader->shaderId(), it.value());
+        }
 
-        fragment->compileSourceCode(effect->fallbackSource.toLocal8Bit().data());
-    }
-    else {
-        effect->fallbackSource = source;
-    }
+        for (auto it = sources.cbegin(); it != sources.cend(); ++it) {
+            Effect *effect = effects.value(it.key());
+            GLint status = GL_FALSE;
 
-    bool result = effect->program->link();
+            if (computeShaders.contains(it.key())) {
+                GLuint shader = computeShaders.value(it.key());
 
-    Q_ASSERT(result == true);
+                glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
 
-    // reset playback frame counter
-    effect->frame = 0;
+                if (status != GL_TRUE) {
+                    logs[it.key()] = GlShader::shaderInfoLog(this, shader);
+                }
+                else {
+                    GLuint program = glCreateProgram();
 
-    doneCurrent();
+                    glAttachShader(program, shader);
 
-    return log;
-}
+                    if (programBinarySupported) {
+                        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+                    }
 
-void Renderer::effectInputChanged(int index, int channel, int effectIndex)
-{
-    Q_ASSERT(effects.contains(index));
+                    glLinkProgram(program);
+                    computePrograms.insert(it.key(), program);
+                }
 
-    Effect *effect = effects.value(index);
-    Effect *inputEffect = effects.contains(effectIndex) ?
-                            effects.value(effectIndex) : Q_NULLPTR;
+                // shader is released together with program
+                glDeleteShader(shader);
+                continue;
+            }
 
-    Q_ASSERT(channel >= 0);
-    Q_ASSERT(effect->inputs.size() > channel);
+            // compute source that could not be compiled at all
+            if (logs.contains(it.key())) {
+                continue;
+            }
 
-    effect->inputs[channel].effect = inputEffect;
-}
+            QOpenGLShader *fragment = effect->fragmentShader;
 
-void Renderer::effectFilteringChanged(int index, int channel, GLint value)
-{
-    Q_ASSERT(effects.contains(index));
+            glGetShaderiv(fragment->shaderId(), GL_COMPILE_STATUS, &status);
 
-    Effect *effect = effects.value(index);
+            if (status != GL_TRUE) {
+                // failed to compile new source code, save log and fallback
+                logs[it.key()] = GlShader::shaderInfoLog(this, fragment->shaderId());
 
-    Q_ASSERT(channel >= 0);
-    Q_ASSERT(effect->inputs.size() > channel);
+                // running compute program is left as is
+                if (effect->computeProgram) {
+                    continue;
+                }
 
-    effect->inputs[channel].filter = value;
-}
+                // fallback source compiled before, its status is not waited for
+                compileShaderSource(fragment->shaderId(), effect->fallbackSource);
+            }
+            else {
+                logs[it.key()] = QString();
+                effect->fallbackSource = it.value();
+            }
 
-void Renderer::effectWrapChanged(int index, int channel, GLint value)
-{
-    Q_ASSERT(effects.contains(index));
+            if (programBinarySupported) {
+                glProgramParameteri(effect->program->programId(),
+                                    GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
 
-    Effect *effect = effects.value(index);
+            glLinkProgram(effect->program->programId());
+        }
 
-    Q_ASSERT(channel >= 0);
-    Q_ASSERT(effect->inputs.size() > channel);
+        for (auto it = sources.cbegin(); it != sources.cend(); ++it) {
+            Effect *effect = effects.value(it.key());
+            GLint status = GL_FALSE;
 
-    effect->inputs[channel].wrap = value;
-}
+            if (computePrograms.contains(it.key())) {
+                GLuint program = computePrograms.value(it.key());
 
-void Renderer::setupVertexShader()
-{
-    const QString vertexSource{
-        "#version 330 core\n"
-        "layout (location = 0) in vec2 pos;\n"
-        "void main() {\n"
-        "gl_Position = vec4(pos, 0.0, 1.0);\n"
-        "}\n"
-    };
+                glGetProgramiv(program, GL_LINK_STATUS, &status);
 
-    vertexShader = new QOpenGLShader(QOpenGLShader::ShaderTypeBit::Vertex, this);
+                if (status != GL_TRUE) {
+                    logs[it.key()] = GlShader::programInfoLog(this, program);
+                    glDeleteProgram(program);
+                    continue;
+                }
 
-    bool result = vertexShader->compileSourceCode(vertexSource);
+                glDeleteProgram(effect->computeProgram);
+                effect->computeProgram = program;
+                effect->fallbackSource = it.value();
+                logs[it.key()] = QString();
 
-    Q_ASSERT(result == true);
-}
+                GLint size[3] = {1, 1, 1};
 
-void Renderer::setupBuffers()
-{
-    bool result = vao.create();
+                glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, size);
+                effect->workGroupSize = QSize(size[0], size[1]);
+            }
+            else if (GlShader::isCompute(it.value())) {
+                // compute shader is not supported or failed to compile
+                continue;
+            }
+            else if (effect->computeProgram && !logs.value(it.key()).isEmpty()) {
+                // running compute program is left as is
+                continue;
+            }
+            else {
+                glGetProgramiv(effect->program->programId(), GL_LINK_STATUS, &status);
 
-    Q_ASSERT(result == true);
+                Q_ASSERT(status == GL_TRUE);
 
-    vao.bind();
+                // fragment shader replaces compute one
+                glDeleteProgram(effect->computeProgram);
+                effect->computeProgram = 0;
+            }
 
-    result = vbo.create();
+            updateUniformLocations(*effect);
+            updateEffectOutputs(*effect);
+            clearVariants(it.key(), *effect);
 
-    Q_ASSERT(result == true);
+            if (it.key() == heatmapEffect) {
+                heatmap.reset();
+            }
 
-    result = vbo.bind();
+            // reset playback frame counter
+            effect->frame = 0;
+            effectChanged(*effect);
+        }
 
-    Q_ASSERT(result == true);
+        return logs;
+    });
+}
 
-    const GLfloat vertices[] = {
-        -1.0, 1.0,
-        -1.0, -1.0,
-        1.0, -1.0,
+QString Renderer::setEffectChannelTexture(int index, int channel, const QString &fileName)
+{
+    return renderThread->call<QString>([this, index, channel, &fileName]() {
+        Q_ASSERT(effects.contains(index));
 
-        -1.0, 1.0,
-        1.0, -1.0,
-        1.0, 1.0
-    };
+        Effect *effect = effects.value(index);
 
-    vbo.setUsagePattern(QOpenGLBuffer::UsagePattern::StaticDraw);
-    vbo.allocate(vertices, sizeof(vertices));
+        Q_ASSERT(channel >= 0);
+        Q_ASSERT(effect->inputs.size() > channel);
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), Q_NULLPTR);
+        EffectChannelSettings &settings = effect->inputs[channel];
+        QString error;
+
+        deleteChannelTexture(settings);
+
+        if (!fileName.isEmpty()) {
+            settings.texture = ChannelTexture::load(fileName, error);
+            settings.effect = Q_NULLPTR;
+            memoryUsageDirty = true;
+        }
+
+        effectChanged(*effect);
+
+        return error;
+    });
 }
 
-Effect* Renderer::createEffect()
+void Renderer::setEffectParameters(int index, const QList<ShaderParameter> &parameters)
 {
-    makeCurrent();
+    const bool bake = autoBake;
 
-    QOpenGLShader *fragment = new QOpenGLShader(QOpenGLShader::ShaderTypeBit::Fragment, this);
-    QString source = defaultFragmentShader();
+    renderThread->post([this, index, parameters, bake]() {
+        Q_ASSERT(effects.contains(index));
 
-    bool result = fragment->compileSourceCode(source);
+        Effect *effect = effects.value(index);
 
-    Q_ASSERT(result == true);
+        effect->parameters.clear();
 
-    QOpenGLShaderProgram *program = new QOpenGLShaderProgram(this);
+        for (const auto &parameter : parameters) {
+            EffectParameter item;
 
-    result = program->addShader(vertexShader);
+            item.name = parameter.name.toLatin1();
+            item.type = parameter.type;
+            item.value = parameter.value;
 
-    Q_ASSERT(result == true);
+            effect->parameters.append(item);
+        }
 
-    result = program->addShader(fragment);
+        updateUniformLocations(*effect);
 
-    Q_ASSERT(result == true);
+        effectChanged(*effect);
 
-    result = program->link();
+        if (bake) {
+            idleEffects.insert(index);
+        }
+    });
 
-    Q_ASSERT(result == true);
+    if (autoBake) {
+        bakeTimer->start();
+    }
+}
 
-    QOpenGLFramebufferObject *fbo = new QOpenGLFramebufferObject(fboTextureSize);
+QSize Renderer::effectBufferSize(int index) const
+{
+    return renderThread->call<QSize>([this, index]() {
+        Q_ASSERT(effects.contains(index));
 
-    doneCurrent();
+        return effects.value(index)->framebuffer->size();
+    });
+}
+
+GLenum Renderer::effectBufferFormat(int index) const
+{
+    return renderThread->call<GLenum>([this, index]() {
+        Q_ASSERT(effects.contains(index));
 
-    return new Effect(program, fragment, fbo, source);
+        return effects.value(index)->framebuffer->format().internalTextureFormat();
+    });
 }
 
-void Renderer::renderEffects()
+void Renderer::setEffectBuffer(int index, QSize size, GLenum format)
 {
-    glViewport(0, 0, fboTextureSize.width(), fboTextureSize.height());
+    renderThread->post([this, index, size, format]() {
+        Q_ASSERT(effects.contains(index));
 
-    for (auto &effect : effects) {
-        Q_ASSERT(effect != Q_NULLPTR);
+        Effect *effect = effects.value(index);
+        const QSize budgeted = budgetedBufferSize(index, size, format,
+                                                  effect->textures.size());
 
-        // skip main image rendering
-        if (effect == mainImage) {
-            continue;
+        if (!budgeted.isValid()) {
+            return;
         }
 
-        bool result = effect->framebuffer->bind();
-        Q_ASSERT(result == true);
+        setEffectFramebuffer(*effect, budgeted, format, effect->textures.size());
+        effect->frame = 0;
+        history->clear();
+        effectChanged(*effect);
+    });
+}
 
-        renderEffect(*effect, fboTextureSize);
-        effect->frame++;
-    }
+QString Renderer::driverId() const
+{
+    return renderThread->call<QString>([this]() {
+        return driver;
+    });
 }
 
-void Renderer::renderMainImage()
+bool Renderer::effectProgramBinary(int index, const QString &source,
+                                   GLenum &format, QByteArray &binary)
 {
-    Q_ASSERT(mainImage != Q_NULLPTR);
+    return renderThread->call<bool>([this, index, &source, &format, &binary]() {
+        Q_ASSERT(effects.contains(index));
 
-    // render main image using default fbo
-    bool result = QOpenGLFramebufferObject::bindDefault();
+        const Effect *effect = effects.value(index);
 
-    Q_ASSERT(result == true);
+        // compute programs are always compiled from source
+        if (!programBinarySupported || effect->fallbackSource != source
+                || effect->computeProgram) {
+            return false;
+        }
+
+        GLuint id = effect->program->programId();
+        GLint length = 0;
+
+        glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+        binary.resize(length);
+        glGetProgramBinary(id, length, &length, &format, binary.data());
+        binary.resize(length);
+
+        return length > 0;
+    });
+}
+
+bool Renderer::loadEffectProgramBinary(int index, const QString &source,
+                                       GLenum format, const QByteArray &binary)
+{
+    return renderThread->call<bool>([this, index, &source, format, &binary]() {
+        Q_ASSERT(effects.contains(index));
+
+        if (!programBinarySupported || binary.isEmpty()) {
+            return false;
+        }
+
+        Effect *effect = effects.value(index);
+        GLuint id = effect->program->programId();
+        GLint status = GL_FALSE;
+
+        glProgramBinary(id, format, binary.constData(), binary.size());
+        glGetProgramiv(id, GL_LINK_STATUS, &status);
+
+        if (status == GL_TRUE) {
+            // attached fragment shader still holds previous source,
+            // it is only used for relinking after failed compilation
+            effect->fallbackSource = source;
+            effect->frame = 0;
+            effectChanged(*effect);
+            glDeleteProgram(effect->computeProgram);
+            effect->computeProgram = 0;
+            updateUniformLocations(*effect);
+            updateEffectOutputs(*effect);
+            clearVariants(index, *effect);
+        }
+        else {
+            // failed binary load leaves program unlinked, restore it
+            linkEffectProgram(*effect);
+        }
+
+        return status == GL_TRUE;
+    });
+}
+
+void Renderer::bakeEffectParameters(int index)
+{
+    renderThread->post([this, index]() { bakeEffect(index); });
+}
+
+void Renderer::bakeEffect(int index)
+{
+    Q_ASSERT(effects.contains(index));
+
+    Effect *effect = effects.value(index);
+
+    // baked variants are fragment programs
+    if (effect->parameters.isEmpty() || !compiler || effect->computeProgram) {
+        return;
+    }
+
+    const QString source = bakedSource(*effect);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    hash.addData(QByteArray::number(index));
+    hash.addData(source.toUtf8());
+
+    const QByteArray key = hash.result();
+
+    if (effect->variants.contains(key)) {
+        // same values were baked before
+        effect->activeVariant = key;
+        effect->requestedVariant.clear();
+        return;
+    }
+
+    if (failedVariants.contains(key)) {
+        // reported when compiled first
+        effect->requestedVariant.clear();
+        return;
+    }
+
+    effect->requestedVariant = key;
+
+    if (!pendingVariants.contains(key)) {
+        pendingVariants.insert(key, index);
+        compiler->compile(key, GlShader::vertexSource, source);
+    }
+}
+
+bool Renderer::setHeatmapEffect(int index)
+{
+    return renderThread->call<bool>([this, index]() {
+        // hiding heatmap always succeeds
+        if (!heatmapSupported && index >= 0) {
+            return false;
+        }
+
+        heatmapEffect = index;
+
+        heatmap.reset();
+
+        return true;
+    });
+}
+
+EffectUpdatePolicy Renderer::effectUpdatePolicy(int index) const
+{
+    return renderThread->call<EffectUpdatePolicy>([this, index]() {
+        Q_ASSERT(effects.contains(index));
+
+        return effects.value(index)->updatePolicy;
+    });
+}
+
+void Renderer::setEffectUpdatePolicy(int index, const EffectUpdatePolicy &policy)
+{
+    renderThread->post([this, index, policy]() {
+        Q_ASSERT(effects.contains(index));
+        Q_ASSERT(policy.value > 0);
+
+        Effect *effect = effects.value(index);
+
+        effect->updatePolicy = policy;
+        effect->nextRenderTime = frameTime;
+        // show result of new policy right away
+        effectChanged(*effect);
+    });
+}
+
+bool Renderer::isPaused() const
+{
+    QMutexLocker locker(&playbackMutex);
+
+    return playbackState.paused;
+}
+
+int Renderer::playbackFrame() const
+{
+    QMutexLocker locker(&playbackMutex);
+
+    return playbackState.frame;
+}
+
+GLfloat Renderer::playbackTime() const
+{
+    QMutexLocker locker(&playbackMutex);
+
+    return playbackState.time;
+}
+
+int Renderer::firstSeekableFrame() const
+{
+    QMutexLocker locker(&playbackMutex);
+
+    return playbackState.firstSeekableFrame;
+}
+
+int Renderer::lastFrame() const
+{
+    QMutexLocker locker(&playbackMutex);
+
+    return playbackState.lastFrame;
+}
+
+int Renderer::oldestSeekableFrame() const
+{
+    int first = currentFrame;
+    const int stored = history->firstFrame();
+    const int keyframe = history->firstKeyframe();
+
+    if (stored >= 0) {
+        first = qMin(first, stored);
+    }
+
+    if (keyframe >= 0) {
+        first = qMin(first, keyframe);
+    }
+
+    return qMax(first, 0);
+}
+
+int Renderer::newestFrame() const
+{
+    return frameTimes.size() - 1;
+}
+
+int Renderer::inputLatencySamples() const
+{
+    return renderThread->call<int>([this]() {
+        return inputLatencies.size();
+    });
+}
+
+QVector<qint64> Renderer::inputLatencyPercentiles(const QVector<int> &percentiles) const
+{
+    return renderThread->call<QVector<qint64>>([this, &percentiles]() {
+        QVector<qint64> result;
+
+        if (inputLatencies.isEmpty()) {
+            return result;
+        }
+
+        QVector<qint64> sorted = inputLatencies;
+        const int count = sorted.size();
+
+        std::sort(sorted.begin(), sorted.end());
+
+        for (int percentile : percentiles) {
+            Q_ASSERT(percentile >= 0 && percentile <= 100);
+
+            // nearest rank
+            const int rank = (percentile * count + 99) / 100;
+
+            result.append(sorted[qBound(0, rank - 1, count - 1)]);
+        }
+
+        return result;
+    });
+}
+
+QVector<QImage> Renderer::captureFrames(const QVector<GLfloat> &times, QSize size)
+{
+    return renderThread->call<QVector<QImage>>([this, &times, size]() {
+        return renderCapture(times, size);
+    });
+}
+
+void Renderer::effectInputChanged(int index, int channel, int effectIndex)
+{
+    renderThread->post([this, index, channel, effectIndex]() {
+        Q_ASSERT(effects.contains(index));
+
+        Effect *effect = effects.value(index);
+        Effect *inputEffect = effects.contains(effectIndex) ?
+                                effects.value(effectIndex) : Q_NULLPTR;
+
+        Q_ASSERT(channel >= 0);
+        Q_ASSERT(effect->inputs.size() > channel);
+
+        EffectChannelSettings &settings = effect->inputs[channel];
+
+        // channel uses either other effect or static texture
+        if (settings.texture) {
+            deleteChannelTexture(settings);
+        }
+
+        settings.effect = inputEffect;
+        // mip chain of input is allocated if it is sampled with mipmaps
+        memoryUsageDirty = true;
+        effectChanged(*effect);
+    });
+}
+
+void Renderer::effectFilteringChanged(int index, int channel, GLint value)
+{
+    renderThread->post([this, index, channel, value]() {
+        Q_ASSERT(effects.contains(index));
+
+        Effect *effect = effects.value(index);
+
+        Q_ASSERT(channel >= 0);
+        Q_ASSERT(effect->inputs.size() > channel);
+
+        effect->inputs[channel].filter = value;
+        memoryUsageDirty = true;
+        effectChanged(*effect);
+    });
+}
+
+void Renderer::effectWrapChanged(int index, int channel, GLint value)
+{
+    renderThread->post([this, index, channel, value]() {
+        Q_ASSERT(effects.contains(index));
+
+        Effect *effect = effects.value(index);
+
+        Q_ASSERT(channel >= 0);
+        Q_ASSERT(effect->inputs.size() > channel);
+
+        effect->inputs[channel].wrap = value;
+        effectChanged(*effect);
+    });
+}
+
+void Renderer::effectAttachmentChanged(int index, int channel, int attachment)
+{
+    renderThread->post([this, index, channel, attachment]() {
+        Q_ASSERT(effects.contains(index));
+
+        Effect *effect = effects.value(index);
+
+        Q_ASSERT(channel >= 0);
+        Q_ASSERT(effect->inputs.size() > channel);
+        Q_ASSERT(attachment >= 0 && attachment < Effect::maxOutputs);
+
+        effect->inputs[channel].attachment = attachment;
+        effectChanged(*effect);
+    });
+}
+
+void Renderer::effectChannelCountChanged(int index, int count)
+{
+    renderThread->post([this, index, count]() {
+        Q_ASSERT(effects.contains(index));
+        Q_ASSERT(count >= 0 && count <= Effect::maxChannels);
+
+        Effect *effect = effects.value(index);
+
+        if (count == effect->inputs.size()) {
+            return;
+        }
+
+        for (int i = count; i < effect->inputs.size(); i++) {
+            deleteChannelTexture(effect->inputs[i]);
+        }
+
+        effect->inputs.resize(count);
+        memoryUsageDirty = true;
+
+        // added channels may already be declared in source
+        updateUniformLocations(*effect);
+
+        for (auto &variant : effect->variants) {
+            queryUniformLocations(variant.program, count, variant.uniforms);
+        }
+
+        effectChanged(*effect);
+    });
+}
+
+void Renderer::effectParameterChanged(int index, const QString &name,
+                                      const QVector4D &value)
+{
+    const bool bake = autoBake;
+
+    renderThread->post([this, index, name, value, bake]() {
+        Q_ASSERT(effects.contains(index));
+
+        Effect *effect = effects.value(index);
+        const QByteArray parameterName = name.toLatin1();
+
+        for (auto &parameter : effect->parameters) {
+            if (parameter.name == parameterName) {
+                parameter.value = value;
+                break;
+            }
+        }
+
+        // baked values are outdated, go back to uniforms
+        effect->activeVariant.clear();
+        effect->requestedVariant.clear();
+        effectChanged(*effect);
+
+        if (bake) {
+            idleEffects.insert(index);
+        }
+    });
+
+    if (autoBake) {
+        bakeTimer->start();
+    }
+}
+
+void Renderer::effectUpdatePolicyChanged(int index, int mode, int value)
+{
+    EffectUpdatePolicy policy;
+
+    policy.mode = static_cast<EffectUpdatePolicy::Mode>(mode);
+    policy.value = value;
+
+    setEffectUpdatePolicy(index, policy);
+}
+
+void Renderer::setAutoBake(bool enabled)
+{
+    autoBake = enabled;
+
+    renderThread->post([this, enabled]() {
+        if (!enabled) {
+            idleEffects.clear();
+            return;
+        }
+
+        for (auto it = effects.cbegin(); it != effects.cend(); ++it) {
+            if (it.value()->activeVariant.isEmpty()) {
+                idleEffects.insert(it.key());
+            }
+        }
+    });
+
+    if (autoBake) {
+        bakeTimer->start();
+    }
+    else {
+        bakeTimer->stop();
+    }
+}
+
+void Renderer::setPaused(bool paused)
+{
+    renderThread->post([this, paused]() { setPlaybackPaused(paused); });
+}
+
+void Renderer::stepFrame(int delta)
+{
+    renderThread->post([this, delta]() { setPlaybackFrame(currentFrame + delta); });
+}
+
+void Renderer::seekFrame(int frame)
+{
+    renderThread->post([this, frame]() { setPlaybackFrame(frame); });
+}
+
+void Renderer::setPlaybackPaused(bool paused)
+{
+    if (this->paused == paused) {
+        return;
+    }
+
+    this->paused = paused;
+
+    if (!paused) {
+        // frames after shown one are recorded again with new times
+        currentFrame = qMin(currentFrame, newestFrame());
+        frameTimes.resize(currentFrame + 1);
+
+        history->truncate(currentFrame);
+
+        timeBase = frameTimes.value(currentFrame, 0.0f);
+        timer.restart();
+    }
+
+    publishPlaybackState();
+    emit playbackFrameChanged(currentFrame);
+}
+
+void Renderer::setPlaybackFrame(int frame)
+{
+    setPlaybackPaused(true);
+
+    frame = qBound(oldestSeekableFrame(), frame, newestFrame() + 1);
+
+    if (frame == currentFrame) {
+        return;
+    }
+
+    currentFrame = frame;
+
+    publishPlaybackState();
+    emit playbackFrameChanged(currentFrame);
+}
+
+QVector<QImage> Renderer::renderCapture(const QVector<GLfloat> &times, QSize size)
+{
+    TRACE_SCOPE("captureFrames", "render");
+
+    QVector<QImage> images;
+
+    if (!mainImage) {
+        return images;
+    }
+
+    // playback stays paused at last captured frame
+    setPlaybackPaused(true);
+    restartSimulation();
+
+    QOpenGLFramebufferObject framebuffer(size);
+    QOpenGLFramebufferObject *previousTarget = targetFramebuffer;
+    const QSize previousViewSize = viewSize;
+
+    targetFramebuffer = &framebuffer;
+    viewSize = size;
+
+    for (GLfloat time : times) {
+        const int frame = qMax(qRound(time * fps), 0);
+
+        Q_ASSERT(frame >= simulatedFrame);
+
+        for (int i = simulatedFrame + 1; i <= frame; i++) {
+            simulateFrame(i, GLfloat(i) / fps);
+        }
+
+        frameTime = frameTimes.at(frame);
+        frameCount = frame;
+        // main image is rendered every frame in playback, skipped ones count
+        mainImage->frame = frame;
+
+        renderMainImage();
+
+        QImage image(size, QImage::Format_RGBA8888);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.handle());
+        glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE,
+                     image.bits());
+        glState.invalidate();
+
+        // alpha is ignored, like in preview
+        images.append(image.mirrored().convertToFormat(QImage::Format_RGBX8888));
+        currentFrame = frame;
+    }
+
+    targetFramebuffer = previousTarget;
+    viewSize = previousViewSize;
+
+    publishPlaybackState();
+    emit playbackFrameChanged(currentFrame);
+
+    return images;
+}
+
+void Renderer::restartSimulation()
+{
+    history->clear();
+    frameTimes.clear();
+    currentFrame = -1;
+    simulatedFrame = -1;
+
+    mouse = QVector4D();
+    mouseEvents.clear();
+    mouseHistory.clear();
+    mouseHistoryValues.fill(QVector4D(0.0f, 0.0f, 0.0f, -1.0f));
+    mouseButtonDown = false;
+
+    const GLfloat black[] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    for (Effect *effect : effects) {
+        effect->frame = 0;
+        effect->dirty = true;
+        effect->renderCount = 0;
+        effect->lastRenderFrame = 0;
+        effect->nextRenderTime = 0.0f;
+
+        if (effect == mainImage) {
+            continue;
+        }
+
+        // feedback buffers start from the same contents each time
+        glState.bindFramebuffer(effect->framebuffer->handle());
+
+        for (int i = 0; i < effect->textures.size(); i++) {
+            glClearBufferfv(GL_COLOR, i, black);
+        }
+    }
+
+    // feedback consumers render before their inputs, drop stale mip levels
+    updateMipmapOutputs();
+
+    for (Effect *effect : effects) {
+        if (effect != mainImage) {
+            generateMipmaps(*effect);
+        }
+    }
+
+    glState.invalidate();
+}
+
+GpuMemoryUsage Renderer::memoryUsage()
+{
+    return renderThread->call<GpuMemoryUsage>([this]() {
+        updateMemoryUsage();
+
+        return memory.snapshot();
+    });
+}
+
+void Renderer::setMemoryBudget(qint64 bytes, int policy)
+{
+    renderThread->post([this, bytes, policy]() {
+        memory.setBudget(bytes, GpuMemory::Policy(policy));
+
+        // report new budget and a crossing of it
+        reportedMemoryUsage = -1;
+        overBudget = false;
+        updateMemoryUsage();
+    });
+}
+
+void Renderer::setHistorySpill(bool enabled)
+{
+    renderThread->post([this, enabled]() {
+        history->setSpillEnabled(enabled);
+    });
+}
+
+void Renderer::setMaxFramesInFlight(int frames)
+{
+    renderThread->post([this, frames]() {
+        Q_ASSERT(frames >= 0);
+
+        maxFramesInFlight = frames;
+        // latencies measured with previous limit would skew percentiles
+        inputLatencies.clear();
+    });
+}
+
+void Renderer::resetInputLatency()
+{
+    renderThread->post([this]() {
+        inputLatencies.clear();
+    });
+}
+
+void Renderer::setPresenter(QWindow *window)
+{
+    if (presenter) {
+        presenter->removeEventFilter(this);
+    }
+
+    presenter = window;
+
+    const QSize size = window ? window->size() * window->devicePixelRatio() : QSize();
+    const bool exposed = window && window->isExposed();
+
+    // window may be deleted once this returns, render thread must forget it
+    renderThread->call([this, window, size, exposed]() {
+        presenterWindow = window;
+        presenterSize = size;
+        presenterExposed = exposed;
+
+        // events were converted for other surface
+        mouseEvents.clear();
+
+        if (!presenterWindow) {
+            viewSize = widgetViewSize;
+        }
+    });
+
+    if (presenter) {
+        presenter->installEventFilter(this);
+    }
+}
+
+void Renderer::updatePresenterState()
+{
+    const QSize size = presenter->size() * presenter->devicePixelRatio();
+    const bool exposed = presenter->isExposed();
+
+    renderThread->post([this, size, exposed]() {
+        presenterSize = size;
+        presenterExposed = exposed;
+    });
+}
+
+void Renderer::framePresented()
+{
+    renderThread->post([this]() { measureInputLatency(); });
+}
+
+void Renderer::measureInputLatency()
+{
+    Tracer &tracer = Tracer::instance();
+    const qint64 now = tracer.now();
+
+    for (qint64 time : unpresentedInputs) {
+        inputLatencies.append(now - time);
+
+        if (tracer.isEnabled()) {
+            tracer.record("inputToPresent", "input", time, now - time);
+        }
+    }
+
+    unpresentedInputs.clear();
+
+    if (inputLatencies.size() > maxInputLatencies) {
+        inputLatencies.remove(0, inputLatencies.size() - maxInputLatencies);
+    }
+}
+
+void Renderer::variantCompiled(const QByteArray &key, GLuint program, const QString &log)
+{
+    renderThread->post([this, key, program, log]() { addVariant(key, program, log); });
+}
+
+void Renderer::addVariant(const QByteArray &key, GLuint program, const QString &log)
+{
+    const bool wanted = pendingVariants.contains(key);
+    const int index = pendingVariants.take(key);
+
+    if (!program) {
+        // constant folding should not break valid source, keep using uniforms
+        // and do not request the same values again
+        if (wanted && effects.contains(index)) {
+            Effect *effect = effects.value(index);
+
+            if (effect->requestedVariant == key) {
+                effect->requestedVariant.clear();
+            }
+
+            failedVariants.insert(key, index);
+            emit bakeFailed(index, log);
+        }
+
+        return;
+    }
+
+    if (!wanted || !effects.contains(index)) {
+        // effect was recompiled or deleted meanwhile
+        glDeleteProgram(program);
+        return;
+    }
+
+    Effect *effect = effects.value(index);
+
+    if (effect->variants.size() >= maxVariants) {
+        // keep cache bounded, only active variant survives
+        for (auto it = effect->variants.begin(); it != effect->variants.end();) {
+            if (it.key() == effect->activeVariant) {
+                ++it;
+                continue;
+            }
+
+            glDeleteProgram(it.value().program);
+            it = effect->variants.erase(it);
+        }
+    }
+
+    EffectVariant &variant = effect->variants[key];
+
+    variant.program = program;
+    memoryUsageDirty = true;
+    queryUniformLocations(program, effect->inputs.size(), variant.uniforms);
+
+    if (effect->requestedVariant == key) {
+        effect->activeVariant = key;
+        effect->requestedVariant.clear();
+    }
+}
+
+void Renderer::bakeIdleEffects()
+{
+    renderThread->post([this]() {
+        for (int index : idleEffects) {
+            if (effects.contains(index)) {
+                bakeEffect(index);
+            }
+        }
+
+        idleEffects.clear();
+    });
+}
+
+void Renderer::setupVertexShader()
+{
+    vertexShader = new QOpenGLShader(QOpenGLShader::ShaderTypeBit::Vertex);
+
+    bool result = vertexShader->compileSourceCode(GlShader::vertexSource);
+
+    Q_ASSERT(result == true);
+}
+
+void Renderer::setupParallelShaderCompile()
+{
+    typedef void (QOPENGLF_APIENTRYP MaxShaderCompilerThreads)(GLuint count);
+
+    QOpenGLContext *glContext = renderThread->context();
+    QByteArray function;
+
+    if (glContext->hasExtension("GL_KHR_parallel_shader_compile")) {
+        function = "glMaxShaderCompilerThreadsKHR";
+    }
+    else if (glContext->hasExtension("GL_ARB_parallel_shader_compile")) {
+        function = "glMaxShaderCompilerThreadsARB";
+    }
+    else {
+        return;
+    }
+
+    auto maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(
+                glContext->getProcAddress(function));
+
+    if (maxThreads) {
+        // let driver decide how many threads to use
+        maxThreads(0xFFFFFFFF);
+    }
+}
+
+void Renderer::compileShaderSource(GLuint shader, const QString &source)
+{
+    const QByteArray code = source.toLocal8Bit();
+    const char *data = code.constData();
+
+    glShaderSource(shader, 1, &data, Q_NULLPTR);
+    glCompileShader(shader);
+}
+
+void Renderer::setupBuffers()
+{
+    // vertex array objects are not shared, it belongs to render thread context
+    vao = new QOpenGLVertexArrayObject();
+
+    bool result = vao->create();
+
+    Q_ASSERT(result == true);
+
+    vao->bind();
+
+    result = vbo.create();
+
+    Q_ASSERT(result == true);
+
+    result = vbo.bind();
+
+    Q_ASSERT(result == true);
+
+    const GLfloat vertices[] = {
+        -1.0, 1.0,
+        -1.0, -1.0,
+        1.0, -1.0,
+
+        -1.0, 1.0,
+        1.0, -1.0,
+        1.0, 1.0
+    };
+
+    vbo.setUsagePattern(QOpenGLBuffer::UsagePattern::StaticDraw);
+    vbo.allocate(vertices, sizeof(vertices));
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), Q_NULLPTR);
+}
+
+Effect* Renderer::createEffect(QSize size)
+{
+    // objects of render thread have no parent in GUI thread
+    QOpenGLShader *fragment = new QOpenGLShader(QOpenGLShader::ShaderTypeBit::Fragment);
+    QString source = defaultFragmentShader();
+    GLint status = GL_FALSE;
+
+    compileShaderSource(fragment->shaderId(), source);
+    glGetShaderiv(fragment->shaderId(), GL_COMPILE_STATUS, &status);
+
+    Q_ASSERT(status == GL_TRUE);
+
+    QOpenGLShaderProgram *program = new QOpenGLShaderProgram();
+
+    bool result = program->addShader(vertexShader);
+
+    Q_ASSERT(result == true);
+
+    result = program->addShader(fragment);
+
+    Q_ASSERT(result == true);
+
+    QOpenGLFramebufferObject *fbo = new QOpenGLFramebufferObject(size);
+    Effect *effect = new Effect(program, fragment, fbo, source);
+
+    result = linkEffectProgram(*effect);
+
+    Q_ASSERT(result == true);
+
+    return effect;
+}
+
+void Renderer::simulateFrame(int frame, GLfloat time)
+{
+    TRACE_SCOPE("simulateFrame", "render", frame);
+
+    Q_ASSERT(frame <= frameTimes.size());
+
+    if (frame == frameTimes.size()) {
+        frameTimes.append(time);
+    }
+
+    frameTime = time;
+    frameCount = frame;
+
+    renderEffects();
+    simulatedFrame = frame;
+
+    if (history->needsKeyframe(frame)) {
+        history->storeKeyframe(frame, bufferEffects());
+        glState.invalidate();
+    }
+}
+
+bool Renderer::syncSimulation(int frame)
+{
+    if (frame < 0 || frame == simulatedFrame) {
+        return frame == simulatedFrame;
+    }
+
+    Q_ASSERT(frame < frameTimes.size());
+
+    const int keyframe = history->keyframeBefore(frame);
+
+    // going back needs a keyframe, going forward uses one to skip frames
+    if (frame < simulatedFrame || simulatedFrame < 0 || keyframe > simulatedFrame) {
+        if (keyframe < 0) {
+            return false;
+        }
+
+        history->restoreKeyframe(keyframe, bufferEffects());
+        glState.invalidate();
+        simulatedFrame = keyframe;
+    }
+
+    for (int i = simulatedFrame + 1; i <= frame; i++) {
+        simulateFrame(i, frameTimes.at(i));
+    }
+
+    return true;
+}
+
+void Renderer::renderPresenter()
+{
+    TRACE_SCOPE("renderPresenter", "render");
+
+    if (!presenterExposed || !mainImage) {
+        return;
+    }
+
+    QOpenGLContext *glContext = renderThread->context();
+
+    // the same context renders preview, so all objects are available
+    if (!glContext->makeCurrent(presenterWindow)) {
+        return;
+    }
+
+    viewSize = presenterSize;
+    targetFramebuffer = Q_NULLPTR;
+
+    renderFrame();
+
+    glContext->swapBuffers(presenterWindow);
+    // commands between frames expect context current as usual
+    glContext->makeCurrent(renderThread->surface());
+
+    // frameSwapped is emitted for preview only
+    measureInputLatency();
+}
+
+void Renderer::presentFrame()
+{
+    TRACE_SCOPE("presentFrame", "render", currentFrame);
+
+    // paused before anything was rendered
+    currentFrame = qMax(currentFrame, 0);
+
+    if (currentFrame > newestFrame()) {
+        // stepping past last frame renders a new one
+        const GLfloat time = frameTimes.isEmpty() ? 0.0f : frameTimes.last() + 1.0f / fps;
+
+        syncSimulation(newestFrame());
+        simulateFrame(currentFrame, time);
+    }
+    else if (history->showFrame(currentFrame, targetFramebuffer, viewSize)) {
+        glState.invalidate();
+        frameTime = frameTimes.at(currentFrame);
+        return;
+    }
+
+    // buffers may be out of sync if there is no keyframe, show them as is
+    syncSimulation(currentFrame);
+
+    frameTime = frameTimes.at(currentFrame);
+    frameCount = currentFrame;
+
+    renderMainImage();
+    history->storeFrame(currentFrame, targetFramebuffer, viewSize);
+    glState.invalidate();
+}
+
+void Renderer::waitFramesInFlight()
+{
+    while (!frameFences.isEmpty()
+           && (maxFramesInFlight == 0 || frameFences.size() >= maxFramesInFlight)) {
+        GLsync fence = frameFences.takeFirst();
+
+        // fences left from before limit was removed are just dropped
+        if (maxFramesInFlight > 0) {
+            TRACE_SCOPE("waitFramesInFlight", "render");
+
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, frameFenceTimeoutNs);
+        }
+
+        glDeleteSync(fence);
+    }
+}
+
+void Renderer::queueMouseEvent(QMouseEvent *event)
+{
+    QPoint pos = event->pos();
+
+    convertPointToOpenGl(pos);
+    latestMouse.storeRelease(packPoint(pos));
+
+    const MouseEvent mouseEvent{event->type(), pos, Tracer::instance().now(), false};
+
+    renderThread->post([this, mouseEvent]() {
+        mouseEvents.append(mouseEvent);
+
+        if (mouseEvents.size() > maxMouseEvents) {
+            mouseEvents.remove(0, mouseEvents.size() - maxMouseEvents);
+        }
+    });
+}
+
+void Renderer::applyMouseEvents()
+{
+    const qint64 now = Tracer::instance().now();
+
+    if (!mouseEvents.isEmpty()) {
+        for (MouseEvent event : mouseEvents) {
+            const QPoint &pos = event.pos;
+
+            switch (event.type) {
+            case QEvent::MouseButtonPress:
+                mouse = QVector4D(pos.x(), pos.y(), pos.x(), pos.y());
+                mouseButtonDown = true;
+                break;
+            case QEvent::MouseMove:
+                mouse.setX(pos.x());
+                mouse.setY(pos.y());
+                break;
+            case QEvent::MouseButtonRelease:
+                mouse.setZ(-qAbs(pos.x()));
+                mouse.setW(-qAbs(pos.y()));
+                mouseButtonDown = false;
+                break;
+            default:
+                Q_ASSERT(false);
+            }
+
+            event.buttonDown = mouseButtonDown;
+            mouseHistory.prepend(event);
+            unpresentedInputs.append(event.time);
+        }
+
+        if (mouseHistory.size() > mouseHistorySize) {
+            mouseHistory.resize(mouseHistorySize);
+        }
+
+        mouseEvents.clear();
+        // all events of frame are a single change for update policies
+        mouseRevision++;
+    }
+
+    // event ages grow even without new events
+    for (int i = 0; i < mouseHistory.size(); i++) {
+        const MouseEvent &event = mouseHistory[i];
+
+        mouseHistoryValues[i] = QVector4D(event.pos.x(), event.pos.y(),
+                                          (now - event.time) / 1000000.0f,
+                                          event.buttonDown ? 1.0f : 0.0f);
+    }
+}
+
+void Renderer::latchMouse()
+{
+    // cursor moves without button pressed are ignored, like in mouseMoveEvent
+    if (!mouseButtonDown) {
+        return;
+    }
+
+    // GUI thread keeps receiving events while frame is rendered,
+    // the newest one may not have reached the command queue yet
+    const QPoint pos = unpackPoint(latestMouse.loadAcquire());
+
+    if (pos.x() != mouse.x() || pos.y() != mouse.y()) {
+        mouse.setX(pos.x());
+        mouse.setY(pos.y());
+        mouseRevision++;
+    }
+}
+
+QHash<int, Effect*> Renderer::bufferEffects() const
+{
+    QHash<int, Effect*> buffers;
+
+    for (const auto &item : renderOrder) {
+        buffers[item.first] = item.second;
+    }
+
+    return buffers;
+}
+
+void Renderer::updateRenderOrder()
+{
+    renderOrder.clear();
+
+    for (auto it = effects.cbegin(); it != effects.cend(); ++it) {
+        if (it.value() != mainImage) {
+            renderOrder.append(qMakePair(it.key(), it.value()));
+        }
+    }
+
+    // buffers are rendered in order of their pages, like in ShaderToy
+    std::sort(renderOrder.begin(), renderOrder.end(),
+              [](const QPair<int, Effect*> &a, const QPair<int, Effect*> &b) {
+        return a.first < b.first;
+    });
+}
+
+void Renderer::effectChanged(Effect &effect)
+{
+    effect.dirty = true;
+    history->clearFrames();
 
-    glViewport(0, 0, viewSize.width(), viewSize.height());
+    if (paused && &effect != mainImage) {
+        // simulate shown frame again from keyframe with changes applied
+        simulatedFrame = -1;
+    }
+}
+
+void Renderer::setEffectFramebuffer(Effect &effect, QSize size, GLenum format, int outputs)
+{
+    static const GLenum attachments[Effect::maxOutputs] = {
+        GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1,
+        GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3
+    };
+
+    Q_ASSERT(outputs > 0 && outputs <= Effect::maxOutputs);
+
+    QOpenGLFramebufferObject *framebuffer = new QOpenGLFramebufferObject(size,
+                                QOpenGLFramebufferObject::NoAttachment,
+                                GL_TEXTURE_2D, format);
+
+    for (int i = 1; i < outputs; i++) {
+        framebuffer->addColorAttachment(size, format);
+    }
+
+    // draw buffers are framebuffer state, set them once
+    framebuffer->bind();
+    glDrawBuffers(outputs, attachments);
+    framebuffer->release();
+
+    delete effect.framebuffer;
+    effect.framebuffer = framebuffer;
+    effect.textures = framebuffer->textures();
+    memoryUsageDirty = true;
+}
+
+void Renderer::updateEffectOutputs(Effect &effect)
+{
+    const int outputs = declaredOutputs(effect.fallbackSource);
+
+    // main image is rendered to default framebuffer
+    if (&effect == mainImage || outputs == effect.textures.size()) {
+        return;
+    }
+
+    const GLenum format = effect.framebuffer->format().internalTextureFormat();
+    const QSize size = budgetedBufferSize(effects.key(&effect), effect.framebuffer->size(),
+                                          format, outputs);
+
+    // outputs without attachments are discarded
+    if (!size.isValid()) {
+        return;
+    }
+
+    setEffectFramebuffer(effect, size, format, outputs);
+
+    // keyframes have other number of attachments
+    history->clear();
+}
+
+QSize Renderer::budgetedBufferSize(int index, QSize size, GLenum format, int outputs)
+{
+    if (memory.budget() == 0) {
+        return size;
+    }
+
+    // usage of effect being resized must be current, it is replaced
+    updateMemoryUsage();
+
+    // effect being created is not sampled by anything yet
+    const Effect *effect = effects.value(index);
+    const bool mipmaps = effect && sampledWithMipmaps(*effect);
+    auto bytes = [format, outputs, mipmaps](QSize bufferSize) {
+        return GpuMemory::textureBytes(bufferSize, format, mipmaps) * outputs;
+    };
+
+    if (memory.fits(index, GpuMemory::Framebuffers, bytes(size))) {
+        return size;
+    }
+
+    const QString needed = tr("%1x%2 buffer with %3 outputs needs %4 MB, "
+                              "GPU memory budget is %5 MB.")
+            .arg(size.width()).arg(size.height()).arg(outputs)
+            .arg(bytes(size) / megabyte).arg(memory.budget() / megabyte);
+
+    switch (memory.policy()) {
+    case GpuMemory::Refuse:
+        emit memoryBudgetExceeded(index, tr("%1 Allocation is refused.").arg(needed));
+        return QSize();
+    case GpuMemory::Downsize: {
+        QSize downsized = size;
+
+        while (!memory.fits(index, GpuMemory::Framebuffers, bytes(downsized))
+               && qMin(downsized.width(), downsized.height()) >= minBudgetedBufferSide * 2) {
+            downsized /= 2;
+        }
+
+        emit memoryBudgetExceeded(index, tr("%1 Buffer is downsized to %2x%3.").arg(needed)
+                                  .arg(downsized.width()).arg(downsized.height()));
+        return downsized;
+    }
+    default:
+        // reported once, not again as a budget crossing
+        overBudget = true;
+        emit memoryBudgetExceeded(index, needed);
+        return size;
+    }
+}
+
+bool Renderer::sampledWithMipmaps(const Effect &effect) const
+{
+    for (const Effect *item : effects) {
+        for (const auto &input : item->inputs) {
+            if (input.effect == &effect && input.filter == GL_LINEAR_MIPMAP_LINEAR) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void Renderer::updateMipmapOutputs()
+{
+    for (Effect *item : effects) {
+        item->mipmapOutputs = 0;
+    }
+
+    for (const Effect *item : effects) {
+        const QVector<GLint> &samplers = item->uniforms.channels;
+
+        for (int i = 0; i < item->inputs.size(); i++) {
+            const EffectChannelSettings &input = item->inputs[i];
+
+            // channels shader does not declare are not bound
+            if (!input.effect || input.filter != GL_LINEAR_MIPMAP_LINEAR
+                    || samplers.value(i, -1) < 0) {
+                continue;
+            }
+
+            // missing attachment falls back to the first output when bound
+            const int output = input.attachment < input.effect->textures.size()
+                    ? input.attachment : 0;
+
+            input.effect->mipmapOutputs |= 1 << output;
+        }
+    }
+}
+
+void Renderer::generateMipmaps(const Effect &effect)
+{
+    for (int i = 0; i < effect.textures.size(); i++) {
+        if (!(effect.mipmapOutputs & (1 << i))) {
+            continue;
+        }
+
+        TRACE_SCOPE("generateMipmap", "render");
+
+        glState.bindTexture(0, GL_TEXTURE_2D, effect.textures[i]);
+        glState.activeTexture(0);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+void Renderer::accountEffect(int index, const Effect &effect)
+{
+    memory.setUsage(index, GpuMemory::Framebuffers,
+                    GpuMemory::framebufferBytes(effect.framebuffer,
+                                                sampledWithMipmaps(effect)));
+
+    qint64 textures = 0;
+
+    for (const auto &input : effect.inputs) {
+        if (input.texture) {
+            textures += memory.textureObjectBytes(input.texture->target, input.texture->id);
+            glState.invalidateTextures();
+        }
+    }
+
+    memory.setUsage(index, GpuMemory::Textures, textures);
+
+    qint64 programs = memory.programBytes(effect.program->programId())
+                    + memory.programBytes(effect.computeProgram);
+
+    for (const auto &variant : effect.variants) {
+        programs += memory.programBytes(variant.program);
+    }
+
+    memory.setUsage(index, GpuMemory::Programs, programs);
+}
+
+void Renderer::updateMemoryUsage()
+{
+    if (memoryUsageDirty) {
+        TRACE_SCOPE("accountMemory", "render");
+
+        for (auto it = effects.cbegin(); it != effects.cend(); ++it) {
+            accountEffect(it.key(), *it.value());
+        }
+
+        memoryUsageDirty = false;
+    }
+
+    qint64 outputBytes = 0;
+
+    for (const auto &output : outputs) {
+        if (output.framebuffer) {
+            outputBytes += GpuMemory::framebufferBytes(output.framebuffer, false);
+        }
+    }
+
+    memory.setUsage(GpuMemory::outputOwner, GpuMemory::Framebuffers, outputBytes);
+    memory.setUsage(GpuMemory::historyOwner, GpuMemory::Framebuffers, history->gpuBytes());
+
+    const qint64 budget = memory.budget();
+    const qint64 total = memory.totalUsage();
+
+    // history gets what effects and output frames leave
+    if (budget > 0) {
+        const qint64 others = total - memory.usage(GpuMemory::historyOwner,
+                                                   GpuMemory::Framebuffers);
+
+        history->setMemoryLimit(qMax(budget - others, qint64(1)));
+    }
+    else {
+        history->setMemoryLimit(0);
+    }
+
+    if (total != reportedMemoryUsage) {
+        reportedMemoryUsage = total;
+        emit memoryUsageChanged(total, budget);
+    }
+
+    const bool exceeded = budget > 0 && total > budget;
+
+    if (exceeded && !overBudget) {
+        emit memoryBudgetExceeded(-1, tr("Renderer uses %1 MB, GPU memory budget is %2 MB.")
+                                  .arg(total / megabyte).arg(budget / megabyte));
+    }
+
+    overBudget = exceeded;
+}
+
+void Renderer::renderEffects()
+{
+    TRACE_SCOPE("renderEffects", "render");
+
+    // a few flags per input, cheaper than keeping them in sync with every change
+    updateMipmapOutputs();
+
+    for (const auto &item : renderOrder) {
+        const int index = item.first;
+        Effect *effect = item.second;
+
+        Q_ASSERT(effect != Q_NULLPTR);
+
+        // dynamic textures keep up with playback even if effect is skipped
+        updateChannelTextures(*effect);
+
+        // consumers sample texture rendered last time
+        if (!needsUpdate(*effect)) {
+            continue;
+        }
+
+        Q_ASSERT(effect->framebuffer->isValid());
+
+        const QSize size = effect->framebuffer->size();
+
+        glState.bindFramebuffer(effect->framebuffer->handle());
+        glState.viewport(size);
+
+        TRACE_SCOPE("renderEffect", "render", index);
+        gpuTimer.begin("renderEffect", index);
+
+        renderEffect(*effect, size);
+        // consumers sample the same mip chain until effect is rendered again
+        generateMipmaps(*effect);
+        effect->frame++;
+        effectRendered(*effect);
+
+        gpuTimer.end();
+    }
+}
+
+bool Renderer::needsUpdate(const Effect &effect) const
+{
+    if (effect.dirty) {
+        return true;
+    }
+
+    const EffectUpdatePolicy &policy = effect.updatePolicy;
+
+    switch (policy.mode) {
+    case EffectUpdatePolicy::EveryFrame:
+        return true;
+    case EffectUpdatePolicy::EveryNthFrame:
+        // playback could go back to frame before last render
+        return frameCount < effect.lastRenderFrame
+                || frameCount - effect.lastRenderFrame >= quint64(policy.value);
+    case EffectUpdatePolicy::FixedRate:
+        // half a frame of tolerance, so rates dividing frame rate are exact
+        return frameTime + 0.5f / fps >= effect.nextRenderTime;
+    case EffectUpdatePolicy::InputsChanged:
+        for (int i = 0; i < effect.inputs.size(); i++) {
+            const EffectChannelSettings &input = effect.inputs[i];
+
+            // feedback from previous frame is not an input change
+            if (input.effect != &effect
+                    && inputRevision(input) != effect.inputRevisions[i]) {
+                return true;
+            }
+        }
+        return false;
+    case EffectUpdatePolicy::MouseInteraction:
+        return mouseRevision != effect.mouseRevision;
+    }
+
+    return true;
+}
+
+void Renderer::effectRendered(Effect &effect)
+{
+    effect.dirty = false;
+    effect.renderCount++;
+    effect.lastRenderFrame = frameCount;
+    effect.mouseRevision = mouseRevision;
+    effect.inputRevisions.resize(effect.inputs.size());
+
+    for (int i = 0; i < effect.inputs.size(); i++) {
+        effect.inputRevisions[i] = inputRevision(effect.inputs[i]);
+    }
+
+    if (effect.updatePolicy.mode == EffectUpdatePolicy::FixedRate) {
+        const float period = 1.0f / effect.updatePolicy.value;
+
+        effect.nextRenderTime += period;
+
+        // do not catch up on frames missed while effect was skipped
+        if (effect.nextRenderTime < frameTime) {
+            effect.nextRenderTime = frameTime + period;
+        }
+    }
+}
+
+quint64 Renderer::inputRevision(const EffectChannelSettings &settings) const
+{
+    if (settings.effect) {
+        return settings.effect->renderCount;
+    }
+
+    return settings.texture ? settings.texture->revision : 0;
+}
+
+void Renderer::updateChannelTextures(const Effect &effect)
+{
+    for (const auto &input : effect.inputs) {
+        if (!input.texture) {
+            continue;
+        }
+
+        const quint64 revision = input.texture->revision;
+
+        input.texture->update(frameTime);
+
+        // texture was bound to active unit for upload
+        if (input.texture->revision != revision) {
+            glState.invalidateTextures();
+        }
+    }
+}
+
+void Renderer::renderMainImage()
+{
+    Q_ASSERT(mainImage != Q_NULLPTR);
 
+    // render main image to output or presenter window
+    glState.bindFramebuffer(targetFramebufferId());
+    glState.viewport(viewSize);
+
+    TRACE_SCOPE("renderEffect", "render", mainImageIndex);
+    gpuTimer.begin("renderEffect", mainImageIndex);
+
+    updateChannelTextures(*mainImage);
     renderEffect(*mainImage, viewSize);
     mainImage->frame++;
+
+    gpuTimer.end();
 }
 
 void Renderer::renderEffect(Effect &effect, QSize textureSize)
 {
-    Q_UNUSED(textureSize);
-
     bindEffectTextures(effect);
 
-    auto program = effect.program;
+    if (effect.computeProgram) {
+        dispatchEffect(effect, textureSize);
+    }
+    else {
+        drawEffect(effect, textureSize);
+    }
+}
+
+void Renderer::dispatchEffect(Effect &effect, QSize textureSize)
+{
+    const GLenum format = effect.framebuffer->format().internalTextureFormat();
+    const QSize groups((textureSize.width() + effect.workGroupSize.width() - 1)
+                       / effect.workGroupSize.width(),
+                       (textureSize.height() + effect.workGroupSize.height() - 1)
+                       / effect.workGroupSize.height());
 
-    Q_ASSERT(program != Q_NULLPTR);
+    glState.useProgram(effect.computeProgram);
 
-    bool result = program->bind();
+    setUniforms(effect, effect.uniforms, textureSize);
+    setParameterUniforms(effect);
 
-    Q_ASSERT(result == true);
+    // outputs are bound to image units with the same numbers as iImageN
+    for (int i = 0; i < effect.textures.size(); i++) {
+        glBindImageTexture(i, effect.textures[i], 0, GL_FALSE, 0, GL_READ_WRITE, format);
+    }
+
+    glDispatchCompute(groups.width(), groups.height(), 1);
+
+    // image stores are not coherent with passes sampling or copying outputs
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+                    | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+}
+
+void Renderer::drawEffect(Effect &effect, QSize textureSize)
+{
+    Q_ASSERT(effect.program != Q_NULLPTR);
+
+    GLuint program = effect.program->programId();
+    const EffectUniforms *uniforms = &effect.uniforms;
+    const bool baked = !effect.activeVariant.isEmpty();
+
+    if (baked) {
+        const EffectVariant &variant = effect.variants[effect.activeVariant];
+
+        program = variant.program;
+        uniforms = &variant.uniforms;
+    }
+
+    // program may be loaded from binary or compiled in background,
+    // QOpenGLShaderProgram does not know about it, so bind it directly
+    glState.useProgram(program);
 
-    setUniforms(effect, textureSize);
+    setUniforms(effect, *uniforms, textureSize);
+
+    if (!baked) {
+        setParameterUniforms(effect);
+    }
 
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
+void Renderer::renderHeatmap()
+{
+    TRACE_SCOPE("renderHeatmap", "render");
+
+    Effect *effect = effects.value(heatmapEffect);
+
+    // compute passes can not be drawn tile by tile
+    if (effect->computeProgram) {
+        return;
+    }
+
+    const bool main = effect == mainImage;
+    const QSize size = main ? viewSize : effect->framebuffer->size();
+    const GLenum format = main ? GL_RGBA8
+                               : effect->framebuffer->format().internalTextureFormat();
+
+    bindEffectTextures(*effect);
+
+    heatmap.measure(size, format, [this, effect, size]() {
+        drawEffect(*effect, size);
+    });
+
+    glState.invalidate();
+    glState.bindFramebuffer(targetFramebufferId());
+    glState.viewport(viewSize);
+    // overlay texture is sampled with its own parameters
+    glState.bindSampler(0, 0);
+
+    heatmap.drawOverlay(viewSize);
+    glState.invalidate();
+}
+
 void Renderer::removeEffectFromInputs(const Effect *effect)
 {
     for (auto &item : effects) {
         for (auto &input : item->inputs) {
             if (input.effect == effect) {
                 input.effect = Q_NULLPTR;
+                effectChanged(*item);
             }
         }
     }
@@ -395,76 +2477,215 @@ void Renderer::removeEffectFromInputs(const Effect *effect)
 
 void Renderer::bindEffectTextures(const Effect &effect)
 {
-    int textureUnit = 0;
+    TRACE_SCOPE("bindEffectTextures", "render");
+
+    const QVector<GLint> &samplers = effect.uniforms.channels;
+
+    for (int i = 0; i < effect.inputs.size(); i++) {
+        // skip channels shader does not declare, binding them is wasted work
+        if (samplers.value(i, -1) < 0) {
+            continue;
+        }
 
-    for (auto &input : effect.inputs) {
-        glActiveTexture(GL_TEXTURE0 + textureUnit);
-        textureUnit++;
+        const EffectChannelSettings &input = effect.inputs[i];
 
         auto otherEffect = input.effect;
-        // if there is no input effect used, unbind texture
-        GLuint id = otherEffect ? otherEffect->framebuffer->texture() : 0;
+        auto texture = input.texture;
+        // if there is no input used, unbind textures
+        GLuint id2D = otherEffect ? otherEffect->textures.value(input.attachment,
+                                                                otherEffect->textures.first())
+                                  : 0;
+        GLuint id3D = 0;
+
+        if (texture) {
+            GLuint &id = texture->target == GL_TEXTURE_3D ? id3D : id2D;
+            id = texture->id;
+        }
+
+        glState.bindTexture(i, GL_TEXTURE_2D, id2D);
+        glState.bindTexture(i, GL_TEXTURE_3D, id3D);
+
+        // static textures build their mip chain once at load time,
+        // compressed ones may have no mip chain at all
+        const bool mipmaps = texture ? texture->mipmaps : true;
+        const GLint minFilter = input.filter == GL_LINEAR_MIPMAP_LINEAR && !mipmaps
+                ? GL_LINEAR : input.filter;
+
+        glState.bindSampler(i, glState.sampler(minFilter, input.wrap));
+    }
+}
+
+void Renderer::deleteChannelTexture(EffectChannelSettings &settings)
+{
+    delete settings.texture;
+    settings.texture = Q_NULLPTR;
+    memoryUsageDirty = true;
+}
+
+void Renderer::setUniforms(const Effect &effect, const EffectUniforms &uniforms,
+                           QSize textureSize)
+{
+    TRACE_SCOPE("setUniforms", "render");
+
+    glUniform1f(uniforms.time, frameTime);
+    glUniform1i(uniforms.frame, effect.frame);
+    glUniform2f(uniforms.resolution, textureSize.width(), textureSize.height());
+    glUniform4f(uniforms.mouse, mouse.x(), mouse.y(), mouse.z(), mouse.w());
 
-        glBindTexture(GL_TEXTURE_2D, id);
+    if (uniforms.mouseHistory >= 0) {
+        glUniform4fv(uniforms.mouseHistory, mouseHistoryValues.size(),
+                     reinterpret_cast<const GLfloat*>(mouseHistoryValues.constData()));
+    }
+}
 
-        if (id) {
-            setSamplingParameters(input);
+void Renderer::setParameterUniforms(const Effect &effect)
+{
+    for (const auto &parameter : effect.parameters) {
+        const QVector4D &value = parameter.value;
+
+        switch (parameter.type) {
+        case GL_FLOAT:
+            glUniform1f(parameter.location, value.x());
+            break;
+        case GL_INT:
+        case GL_BOOL:
+            glUniform1i(parameter.location, static_cast<GLint>(value.x()));
+            break;
+        case GL_FLOAT_VEC3:
+            glUniform3f(parameter.location, value.x(), value.y(), value.z());
+            break;
+        case GL_FLOAT_VEC4:
+            glUniform4f(parameter.location, value.x(), value.y(), value.z(), value.w());
+            break;
+        default:
+            Q_ASSERT(false);
         }
     }
 }
 
-void Renderer::setSamplingParameters(const EffectChannelSettings &settings)
+bool Renderer::linkEffectProgram(Effect &effect)
 {
-    switch (settings.filter) {
-    case GL_LINEAR_MIPMAP_LINEAR:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        break;
-    case GL_LINEAR:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        break;
-    case GL_NEAREST:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        break;
-    default:
-        Q_ASSERT(false);
+    if (programBinarySupported) {
+        glProgramParameteri(effect.program->programId(),
+                            GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     }
 
-    switch (settings.wrap) {
-    case GL_REPEAT:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        break;
-    case GL_CLAMP_TO_EDGE:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        break;
+    bool result = effect.program->link();
 
-    default:
-        Q_ASSERT(false);
+    updateUniformLocations(effect);
+
+    return result;
+}
+
+void Renderer::updateUniformLocations(Effect &effect)
+{
+    GLuint id = effect.computeProgram ? effect.computeProgram : effect.program->programId();
+
+    queryUniformLocations(id, effect.inputs.size(), effect.uniforms);
+
+    for (auto &parameter : effect.parameters) {
+        parameter.location = glGetUniformLocation(id, parameter.name.constData());
+    }
+}
+
+void Renderer::queryUniformLocations(GLuint id, int channels, EffectUniforms &uniforms)
+{
+    uniforms.time = glGetUniformLocation(id, "iTime");
+    uniforms.frame = glGetUniformLocation(id, "iFrame");
+    uniforms.resolution = glGetUniformLocation(id, "iResolution");
+    uniforms.mouse = glGetUniformLocation(id, "iMouse");
+    uniforms.mouseHistory = glGetUniformLocation(id, "iMouseHistory");
+    uniforms.channels.resize(channels);
+
+    for (int i = 0; i < uniforms.channels.size(); i++) {
+        QByteArray name = QString("iChannel%1").arg(i).toLatin1();
+        const GLint location = glGetUniformLocation(id, name.constData());
+
+        uniforms.channels[i] = location;
+
+        // channel samples texture unit with its number, sampler uniforms
+        // keep values until program is linked again, so set them only once
+        if (location >= 0) {
+            // through cache, so next pass using another program binds it again
+            glState.useProgram(id);
+            glUniform1i(location, i);
+        }
+    }
+}
+
+QString Renderer::bakedSource(const Effect &effect) const
+{
+    QString source = effect.fallbackSource;
+
+    for (const auto &parameter : effect.parameters) {
+        const QString type = ShaderParameter::typeName(parameter.type);
+        const QString name = QString::fromLatin1(parameter.name);
+        const QRegularExpression declaration(
+                    QString("^(\\s*)uniform\\s+%1\\s+%2\\s*;").arg(type, name),
+                    QRegularExpression::MultilineOption);
+
+        // annotation comment after declaration is kept as is
+        source.replace(declaration, QString("\\1const %1 %2 = %3;")
+                       .arg(type, name, ShaderParameter::literal(parameter.type,
+                                                                 parameter.value)));
+    }
+
+    return source;
+}
+
+void Renderer::clearVariants(int index, Effect &effect)
+{
+    for (const auto &variant : effect.variants) {
+        glDeleteProgram(variant.program);
+    }
+
+    effect.variants.clear();
+    effect.activeVariant.clear();
+    effect.requestedVariant.clear();
+    memoryUsageDirty = true;
+
+    for (auto it = pendingVariants.begin(); it != pendingVariants.end();) {
+        if (it.value() == index) {
+            it = pendingVariants.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // recompiled source may bake fine
+    for (auto it = failedVariants.begin(); it != failedVariants.end();) {
+        if (it.value() == index) {
+            it = failedVariants.erase(it);
+        }
+        else {
+            ++it;
+        }
     }
 }
 
-void Renderer::setUniforms(const Effect &effect, QSize textureSize)
+GLuint Renderer::targetFramebufferId() const
 {
-    QOpenGLShaderProgram *program = effect.program;
-    GLfloat currentTime = timer.elapsed() / 1000.0f;
+    return targetFramebuffer ? targetFramebuffer->handle()
+                             : QOpenGLContext::currentContext()->defaultFramebufferObject();
+}
+
+void Renderer::publishPlaybackState()
+{
+    QMutexLocker locker(&playbackMutex);
 
-    program->setUniformValue("iTime", currentTime);
-    program->setUniformValue("iFrame", effect.frame);
-    program->setUniformValue("iResolution", textureSize);
-    program->setUniformValue("iMouse", mouse);
-    program->setUniformValue("iChannel0", 0);
-    program->setUniformValue("iChannel1", 1);
-    program->setUniformValue("iChannel2", 2);
-    program->setUniformValue("iChannel3", 3);
+    playbackState.paused = paused;
+    playbackState.frame = currentFrame;
+    playbackState.time = frameTimes.value(currentFrame, frameTime);
+    playbackState.firstSeekableFrame = oldestSeekableFrame();
+    playbackState.lastFrame = newestFrame();
 }
 
 void Renderer::convertPointToOpenGl(QPoint &point) const
 {
+    const int height = presenter ? qRound(presenter->height() * presenter->devicePixelRatio())
+                                 : this->height();
+
     // convert Y coordinate to OpenGL: (0, 0) is bottom-left corner
-    point.setY(viewSize.height() - point.y());
+    point.setY(height - point.y());
 }
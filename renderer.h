@@ -20,16 +20,36 @@
 #define RENDERER_H
 
 #include <QOpenGLWidget>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLShader>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLBuffer>
 #include <QHash>
+#include <QVector>
+#include <QPair>
 #include <QElapsedTimer>
 #include <QTimer>
+#include <QSet>
+#include <QEvent>
+#include <QPointer>
+#include <QMutex>
+#include <QAtomicInteger>
 #include "effect.h"
+#include "shaderparameter.h"
+#include "gputimer.h"
+#include "costheatmap.h"
+#include "glstatecache.h"
+#include "gpumemory.h"
 
-class Renderer : public QOpenGLWidget, protected QOpenGLFunctions
+class ShaderCompiler;
+class FrameHistory;
+class RenderThread;
+class QWindow;
+
+/// Preview widget. Effects are rendered by render thread, methods called
+/// from GUI thread queue their work for it, or wait for it if they return
+/// a result. Preview shows the newest frame render thread has finished
+class Renderer : public QOpenGLWidget, protected QOpenGLExtraFunctions
 {
     Q_OBJECT
 
@@ -45,11 +65,116 @@ public:
     void deleteEffect(int index);
     /// recompile fragment shader for effect
     QString recompileEffectShader(int index, const QString &source);
+    /// recompile fragment shaders for several effects at once,
+    /// returns compilation log for each effect index
+    QHash<int, QString> recompileEffectShaders(const QHash<int, QString> &sources);
+    /// load texture file as effect input channel, empty file name removes it.
+    /// Returns error description on failure
+    QString setEffectChannelTexture(int index, int channel, const QString &fileName);
+
+    /// replace user parameters of effect
+    void setEffectParameters(int index, const QList<ShaderParameter> &parameters);
+
+    QSize effectBufferSize(int index) const;
+    GLenum effectBufferFormat(int index) const;
+    /// recreate effect framebuffer with specified size and texture format
+    void setEffectBuffer(int index, QSize size, GLenum format);
+
+    /// identifies OpenGL driver that produced program binaries
+    QString driverId() const;
+    /// get program binary of effect linked from specified source.
+    /// Returns false if binaries are not supported or source is not the one
+    /// effect was successfully compiled with
+    bool effectProgramBinary(int index, const QString &source,
+                             GLenum &format, QByteArray &binary);
+    /// load effect program from binary instead of compiling source.
+    /// Returns false if driver rejects binary, effect is left unchanged then
+    bool loadEffectProgramBinary(int index, const QString &source,
+                                 GLenum format, const QByteArray &binary);
+
+    /// render effect with program where current parameter values are compiled
+    /// in as constants. Program is compiled in background and used
+    /// until any parameter is changed
+    void bakeEffectParameters(int index);
+
+    /// show rendering cost of effect screen tiles over preview,
+    /// -1 hides heatmap. Returns false if timer queries are not supported
+    /// and heatmap is shown
+    bool setHeatmapEffect(int index);
+
+    EffectUpdatePolicy effectUpdatePolicy(int index) const;
+    /// set how often effect is rendered, consumers sample its last
+    /// rendered texture in between
+    void setEffectUpdatePolicy(int index, const EffectUpdatePolicy &policy);
+
+    bool isPaused() const;
+    /// frame shown now, frames are numbered from 0 since start
+    int playbackFrame() const;
+    /// iTime of frame shown now
+    GLfloat playbackTime() const;
+    /// earliest frame that can be shown again
+    int firstSeekableFrame() const;
+    /// last frame rendered so far
+    int lastFrame() const;
+
+    /// number of measured mouse events, only recent ones are kept
+    int inputLatencySamples() const;
+    /// time in microseconds from receiving mouse event to presenting frame
+    /// that used it, at each percentile from 0 to 100
+    QVector<qint64> inputLatencyPercentiles(const QVector<int> &percentiles) const;
+
+    /// pause playback, restart simulation from cleared buffers and capture
+    /// main image of size at each of times. Frames advance by fixed step of
+    /// 1 / fps, so captures do not depend on frame rate. Times must be
+    /// ascending. Used for golden image tests
+    QVector<QImage> captureFrames(const QVector<GLfloat> &times, QSize size);
+
+    /// GPU memory used by effects, frame history and preview frames
+    GpuMemoryUsage memoryUsage();
 
 public slots:
     void effectInputChanged(int index, int channel, int effectIndex);
     void effectFilteringChanged(int index, int channel, GLint value);
     void effectWrapChanged(int index, int channel, GLint value);
+    /// sample specified output of input effect
+    void effectAttachmentChanged(int index, int channel, int attachment);
+    /// add or remove input channels at the end, up to Effect::maxChannels
+    void effectChannelCountChanged(int index, int count);
+    void effectParameterChanged(int index, const QString &name, const QVector4D &value);
+    /// mode is one of EffectUpdatePolicy::Mode values
+    void effectUpdatePolicyChanged(int index, int mode, int value);
+    /// bake parameters automatically when they are not changed for a while
+    void setAutoBake(bool enabled);
+    /// stop advancing iTime and iFrame, playback resumes from frame shown
+    void setPaused(bool paused);
+    /// pause and show frame delta frames away from current one
+    void stepFrame(int delta);
+    /// pause and show frame, one frame after last is rendered on demand
+    void seekFrame(int frame);
+    /// keep frames evicted from GPU history compressed in memory
+    void setHistorySpill(bool enabled);
+    /// wait for GPU before rendering more than frames ahead of it,
+    /// 0 leaves frame queuing to driver
+    void setMaxFramesInFlight(int frames);
+    /// forget measured input latencies
+    void resetInputLatency();
+    /// render frames to OpenGL window instead of preview, Q_NULLPTR switches
+    /// back. Window must have renderer format, its mouse input is used.
+    /// Window can be deleted once switched back
+    void setPresenter(QWindow *window);
+    /// limit GPU memory accounted by renderer, 0 bytes removes limit.
+    /// Policy is one of GpuMemory::Policy values, it applies to buffers
+    /// allocated later, frame history shrinks to fit right away
+    void setMemoryBudget(qint64 bytes, int policy);
+
+signals:
+    void playbackFrameChanged(int frame);
+    /// baking parameters of effect failed, it keeps using uniforms
+    void bakeFailed(int index, const QString &log);
+    void memoryUsageChanged(qint64 total, qint64 budget);
+    /// buffer of effect with index did not fit into memory budget,
+    /// index is -1 if budget was exceeded by other allocations
+    void memoryBudgetExceeded(int index, const QString &message);
 
 protected:
     void initializeGL() Q_DECL_OVERRIDE;
@@ -60,36 +185,289 @@ protected:
     void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
     void mouseReleaseEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
 
+    /// takes mouse events of presenter window
+    bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
+
+private slots:
+    /// measure latency of mouse events used by composed preview frame
+    void framePresented();
+    void variantCompiled(const QByteArray &key, GLuint program, const QString &log);
+    void bakeIdleEffects();
+
 private:
+    /// OpenGL setup of render thread context
+    void initializeRendering();
+    /// release objects of render thread context
+    void cleanupRendering();
+    /// render next frame for preview or presenter window, called by render
+    /// thread timer
+    void frameTimeout();
+    /// render frame to free output and hand it over to preview
+    void renderOutput();
+    /// draw newest output frame finished by render thread
+    void showOutput();
+    /// latency of mouse events used by frame presented just now
+    void measureInputLatency();
+    /// copy playback state for GUI thread getters
+    void publishPlaybackState();
+    /// tell render thread about presenter window size and visibility
+    void updatePresenterState();
+    /// render thread parts of public methods with the same meaning
+    void bakeEffect(int index);
+    void setPlaybackPaused(bool paused);
+    void setPlaybackFrame(int frame);
+    /// use program compiled in background as baked variant
+    void addVariant(const QByteArray &key, GLuint program, const QString &log);
+    QVector<QImage> renderCapture(const QVector<GLfloat> &times, QSize size);
+    /// forget all frames and mouse input, clear buffers and update policy
+    /// state, next frame is simulated as the first one
+    void restartSimulation();
+    /// render thread counterparts of firstSeekableFrame() and lastFrame()
+    int oldestSeekableFrame() const;
+    int newestFrame() const;
+    /// framebuffer frame is rendered to, default one of current surface
+    /// if no output is used
+    GLuint targetFramebufferId() const;
     void setupVertexShader();
     void setupBuffers();
+    /// allow driver to compile shaders on multiple threads, if supported
+    void setupParallelShaderCompile();
+    /// submit source for compilation without waiting for its status,
+    /// used for every effect shader so all of them compile the same way
+    void compileShaderSource(GLuint shader, const QString &source);
 
-    Effect* createEffect();
+    /// effect with default shader and framebuffer of specified size
+    Effect* createEffect(QSize size);
+    /// recreate effect framebuffer with color attachment for each output
+    void setEffectFramebuffer(Effect &effect, QSize size, GLenum format, int outputs);
+    /// match framebuffer attachments to outputs declared by effect source
+    void updateEffectOutputs(Effect &effect);
+    /// size effect framebuffer can be allocated with according to memory
+    /// budget policy, empty if allocation is refused
+    QSize budgetedBufferSize(int index, QSize size, GLenum format, int outputs);
+    /// true if any effect samples effect outputs with mipmaps
+    bool sampledWithMipmaps(const Effect &effect) const;
+    /// find outputs of all effects that inputs sample with mipmaps
+    void updateMipmapOutputs();
+    /// generate mip chains of effect outputs sampled with mipmaps
+    void generateMipmaps(const Effect &effect);
+    /// account framebuffer, textures and programs of effect
+    void accountEffect(int index, const Effect &effect);
+    /// account changed effects, history and output frames,
+    /// pass memory left by budget to history and report changes
+    void updateMemoryUsage();
+    /// render buffers for frame at time, take keyframe if it is due
+    void simulateFrame(int frame, GLfloat time);
+    /// bring buffers to their state after frame, re-simulating frames
+    /// after nearest keyframe. Returns false if frame can not be reached
+    bool syncSimulation(int frame);
+    /// render frame to framebuffer of current surface
+    void renderFrame();
+    /// render frame to presenter window and swap its buffers
+    void renderPresenter();
+    /// show current frame from history or render it while paused
+    void presentFrame();
+    /// wait until GPU is less than maximum number of frames behind
+    void waitFramesInFlight();
+    /// remember event with its receive time, events are applied once per frame
+    void queueMouseEvent(QMouseEvent *event);
+    /// apply mouse events received since last frame at once
+    void applyMouseEvents();
+    /// sample cursor position right before main image is drawn,
+    /// instead of using last mouse move event
+    void latchMouse();
+    /// effects rendering to their own framebuffers
+    QHash<int, Effect*> bufferEffects() const;
+    /// sort buffer effects by index after effect is created or deleted
+    void updateRenderOrder();
+    /// render effect again regardless of its policy and drop stored frames
+    void effectChanged(Effect &effect);
     void renderEffects();
+    /// check update policy of effect against current frame
+    bool needsUpdate(const Effect &effect) const;
+    /// remember state effect was rendered with for its update policy
+    void effectRendered(Effect &effect);
+    /// render count of input effect or revision of input texture
+    quint64 inputRevision(const EffectChannelSettings &settings) const;
+    /// update dynamic textures of effect input channels
+    void updateChannelTextures(const Effect &effect);
     void renderMainImage();
     void renderEffect(Effect &effect, QSize textureSize);
+    /// draw effect with its textures already bound
+    void drawEffect(Effect &effect, QSize textureSize);
+    /// run compute effect over its outputs with its textures already bound
+    void dispatchEffect(Effect &effect, QSize textureSize);
+    /// time tiles of heatmap effect and draw overlay
+    void renderHeatmap();
     void removeEffectFromInputs(const Effect *effect);
     /// bind textures according to this effect input channels settings,
     /// set sampler settings
     void bindEffectTextures(const Effect &effect);
-    void setSamplingParameters(const EffectChannelSettings &settings);
-    void setUniforms(const Effect &effect, QSize textureSize);
+    /// delete static texture used by effect input channel, if any
+    void deleteChannelTexture(EffectChannelSettings &settings);
+    void setUniforms(const Effect &effect, const EffectUniforms &uniforms,
+                     QSize textureSize);
+    void setParameterUniforms(const Effect &effect);
+    /// link effect program and update its uniform locations
+    bool linkEffectProgram(Effect &effect);
+    void updateUniformLocations(Effect &effect);
+    void queryUniformLocations(GLuint program, int channels, EffectUniforms &uniforms);
+    /// effect source with parameter uniforms replaced by constants
+    QString bakedSource(const Effect &effect) const;
+    /// delete baked programs of effect, cancel pending ones.
+    /// OpenGL context must be current
+    void clearVariants(int index, Effect &effect);
+    /// GUI thread only, converts to surface frames are rendered to
     void convertPointToOpenGl(QPoint &point) const;
 
+    /// Members up to renderThread are used by render thread only,
+    /// outside of initializeRendering() and cleanupRendering()
     QHash<int, Effect*> effects;
+    /// OpenGL vendor, renderer and version
+    QString driver;
     Effect *mainImage;
+    int mainImageIndex;
+    /// buffer effects with their indices in rendering order,
+    /// so frames do not walk effects hash
+    QVector<QPair<int, Effect*>> renderOrder;
     /// vertex shader used for all effects
     QOpenGLShader *vertexShader;
-    QTimer *updateTimer;
+    /// GPU time of effects for trace recording
+    GpuTimer gpuTimer;
+    /// skips redundant binds between passes
+    GlStateCache glState;
+    CostHeatmap heatmap;
+    /// stored frames and keyframes for pausing and scrubbing
+    FrameHistory *history;
+    /// iTime of each frame rendered since start
+    QVector<GLfloat> frameTimes;
+    /// frame shown in preview
+    int currentFrame;
+    /// frame buffers contents correspond to, -1 if unknown
+    int simulatedFrame;
+    /// playback time when timer was started
+    GLfloat timeBase;
+    bool paused;
+    /// effect index heatmap is shown for, -1 if none
+    int heatmapEffect;
+    bool heatmapSupported;
+    /// effects with parameters changed since last auto bake
+    QSet<int> idleEffects;
+    /// variants being compiled and their effect indices
+    QHash<QByteArray, int> pendingVariants;
+    /// variants that failed to compile and their effect indices,
+    /// so the same values are not baked again
+    QHash<QByteArray, int> failedVariants;
+    GpuMemory memory;
+    /// effects need to be accounted again
+    bool memoryUsageDirty;
+    /// total last reported by memoryUsageChanged(), -1 to report again
+    qint64 reportedMemoryUsage;
+    bool overBudget;
 
-    QOpenGLVertexArrayObject vao;
+    /// created in render thread context
+    QOpenGLVertexArrayObject *vao;
     QOpenGLBuffer vbo;
     QElapsedTimer timer;
+    struct MouseEvent
+    {
+        QEvent::Type type;
+        /// position in OpenGL coordinates
+        QPoint pos;
+        /// Tracer time in microseconds event was received at
+        qint64 time;
+        /// left button state after event, known once event is applied
+        bool buttonDown;
+    };
+
     /// mouse pixel coordinates, xy: current if left button down, zw: click
     QVector4D mouse;
+    /// events received since last frame
+    QVector<MouseEvent> mouseEvents;
+    /// recent events applied to mouse, newest first
+    QVector<MouseEvent> mouseHistory;
+    /// iMouseHistory uniform values for current frame
+    QVector<QVector4D> mouseHistoryValues;
+    /// receive times of events used by frame not presented yet
+    QVector<qint64> unpresentedInputs;
+    /// recent input to present latencies in microseconds, oldest first
+    QVector<qint64> inputLatencies;
+    /// incremented on each mouse press, move and release
+    quint64 mouseRevision;
+    bool mouseButtonDown;
+    /// 0 if not limited
+    int maxFramesInFlight;
+    /// fences after each frame GPU may not have finished yet, oldest first
+    QVector<GLsync> frameFences;
     QSize fboTextureSize;
+    /// size of surface frame is rendered to
     QSize viewSize;
+    QSize widgetViewSize;
+    /// window frames are presented to instead of preview, if any
+    QWindow *presenterWindow;
+    /// presenter window size in pixels
+    QSize presenterSize;
+    bool presenterExposed;
+    /// output frame is rendered to, Q_NULLPTR for presenter window
+    QOpenGLFramebufferObject *targetFramebuffer;
+    /// time in seconds shared by all effects rendered in current frame
+    GLfloat frameTime;
+    /// playback frame being rendered
+    quint64 frameCount;
     int fps;
+    bool programBinarySupported;
+    /// compute shaders need OpenGL 4.3 or GL_ARB_compute_shader
+    bool computeSupported;
+
+    /// owns context effects are rendered with
+    RenderThread *renderThread;
+    /// compiles baked variants in background
+    ShaderCompiler *compiler;
+    /// waits for parameters to stop changing before auto baking
+    QTimer *bakeTimer;
+    bool autoBake;
+    /// GUI thread copy of presenter
+    QPointer<QWindow> presenter;
+    /// newest mouse position received by GUI thread, for late latching,
+    /// x in high and y in low 32 bits
+    QAtomicInteger<quint64> latestMouse;
+
+    struct PlaybackState
+    {
+        bool paused;
+        int frame;
+        GLfloat time;
+        int firstSeekableFrame;
+        int lastFrame;
+    };
+
+    /// playback state for GUI thread, guarded by playbackMutex
+    PlaybackState playbackState;
+    mutable QMutex playbackMutex;
+
+    /// frame rendered by render thread for preview
+    struct OutputFrame
+    {
+        /// render thread only
+        QOpenGLFramebufferObject *framebuffer;
+        GLuint texture;
+        QSize size;
+        /// signaled when frame is rendered, waited for before showing it
+        GLsync rendered;
+        /// signaled when preview has drawn frame, waited for before reuse
+        GLsync shown;
+    };
+
+    /// one frame is shown, one is ready to be shown, one is being rendered,
+    /// guarded by outputMutex with indices below
+    OutputFrame outputs[3];
+    QMutex outputMutex;
+    /// frame ready to be shown, -1 if none
+    int publishedOutput;
+    /// frame preview shows, -1 if none
+    int shownOutput;
+    /// reads output textures in preview context
+    GLuint outputReadFramebuffer;
 };
 
 #endif // RENDERER_H
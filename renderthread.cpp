@@ -0,0 +1,255 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "renderthread.h"
+#include "offscreenworker.h"
+#include "tracer.h"
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QSemaphore>
+#include <QTimer>
+
+namespace {
+
+/// commands GUI thread can queue before waiting for render thread
+const int queueCapacity = 4096;
+
+/// Makes render context current on GUI thread for a while and restores
+/// context of preview afterwards. Does nothing on render thread,
+/// its context stays current
+class ContextScope
+{
+public:
+    ContextScope(QOpenGLContext *context, QSurface *surface, bool needed) :
+        context(needed ? context : Q_NULLPTR),
+        previous(needed ? QOpenGLContext::currentContext() : Q_NULLPTR),
+        previousSurface(previous ? previous->surface() : Q_NULLPTR)
+    {
+        if (this->context) {
+            this->context->makeCurrent(surface);
+        }
+    }
+
+    ~ContextScope()
+    {
+        if (previous) {
+            previous->makeCurrent(previousSurface);
+        }
+        else if (context) {
+            context->doneCurrent();
+        }
+    }
+
+private:
+    QOpenGLContext *context;
+    QOpenGLContext *previous;
+    QSurface *previousSurface;
+};
+
+} // namespace
+
+RenderThread::RenderThread(QOpenGLContext *shareContext, QObject *parent) :
+    QObject(parent),
+    threaded(QOpenGLContext::supportsThreadedOpenGL()),
+    offscreenSurface(new QOffscreenSurface()),
+    queue(queueCapacity)
+{
+    // moved to render thread only if it is used there
+    QOpenGLContext *context = OffscreenWorker::createContext(shareContext, offscreenSurface);
+
+    worker = new RenderThreadWorker(context, offscreenSurface, &queue, threaded);
+
+    if (threaded) {
+        context->moveToThread(&thread);
+        worker->moveToThread(&thread);
+    }
+    else {
+        qWarning("OpenGL can not be used from other threads on this platform, "
+                 "effects are rendered on GUI thread");
+    }
+
+    thread.setObjectName("Renderer");
+}
+
+RenderThread::~RenderThread()
+{
+    if (thread.isRunning()) {
+        QMetaObject::invokeMethod(worker, "release", Qt::BlockingQueuedConnection);
+
+        thread.quit();
+        thread.wait();
+    }
+
+    delete worker->context;
+    delete worker;
+    delete offscreenSurface;
+}
+
+QOpenGLContext* RenderThread::context() const
+{
+    return worker->context;
+}
+
+bool RenderThread::isThreaded() const
+{
+    return threaded;
+}
+
+QOffscreenSurface* RenderThread::surface() const
+{
+    return offscreenSurface;
+}
+
+void RenderThread::start(const std::function<void()> &frame, int fps)
+{
+    Q_ASSERT(!thread.isRunning());
+
+    worker->frame = frame;
+
+    if (threaded) {
+        thread.start();
+    }
+    QMetaObject::invokeMethod(worker, "start", Qt::QueuedConnection,
+                              Q_ARG(int, 1000 / fps));
+}
+
+void RenderThread::stop(const std::function<void()> &cleanup)
+{
+    Q_ASSERT(!threaded || thread.isRunning());
+
+    call(cleanup);
+
+    if (!threaded) {
+        worker->release();
+        return;
+    }
+
+    QMetaObject::invokeMethod(worker, "release", Qt::BlockingQueuedConnection);
+
+    thread.quit();
+    thread.wait();
+}
+
+void RenderThread::post(const std::function<void()> &command)
+{
+    if (threaded) {
+        queue.push(command);
+    } else {
+        // nobody else drains the queue, make room on this thread
+        while (!queue.tryPush(command)) {
+            worker->runCommands();
+        }
+    }
+
+    // commands also run between frames, so blocking calls return soon.
+    // A single wakeup is enough for all commands queued until it is handled
+    if (worker->wakeupPending.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(worker, "runCommands", Qt::QueuedConnection);
+    }
+}
+
+void RenderThread::call(const std::function<void()> &command)
+{
+    TRACE_SCOPE("waitRenderThread", "render");
+
+    if (!threaded) {
+        // waiting for GUI thread on GUI thread would never end,
+        // run command with everything queued before it right away
+        post(command);
+        worker->runCommands();
+        return;
+    }
+
+    QSemaphore done;
+
+    post([&command, &done]() {
+        command();
+        done.release();
+    });
+
+    done.acquire();
+}
+
+RenderThreadWorker::RenderThreadWorker(QOpenGLContext *context,
+                                       QOffscreenSurface *surface,
+                                       CommandQueue *queue, bool threaded) :
+    wakeupPending(0),
+    context(context),
+    surface(surface),
+    queue(queue),
+    timer(Q_NULLPTR),
+    threaded(threaded)
+{
+}
+
+void RenderThreadWorker::start(int interval)
+{
+    // context stays current between frames, commands use it as well.
+    // On GUI thread it is made current for each of them instead
+    if (threaded) {
+        context->makeCurrent(surface);
+    }
+
+    timer = new QTimer(this);
+    timer->setTimerType(Qt::PreciseTimer);
+
+    connect(timer, SIGNAL(timeout()), this, SLOT(timeout()));
+    timer->start(interval);
+}
+
+void RenderThreadWorker::runCommands()
+{
+    ContextScope scope(context, surface, !threaded);
+
+    runQueuedCommands();
+}
+
+void RenderThreadWorker::release()
+{
+    delete timer;
+    timer = Q_NULLPTR;
+
+    if (threaded) {
+        context->doneCurrent();
+    }
+
+    delete context;
+    context = Q_NULLPTR;
+}
+
+void RenderThreadWorker::timeout()
+{
+    TRACE_SCOPE("renderThreadFrame", "render");
+
+    ContextScope scope(context, surface, !threaded);
+
+    runQueuedCommands();
+    frame();
+}
+
+void RenderThreadWorker::runQueuedCommands()
+{
+    // commands queued after this are announced by another wakeup
+    wakeupPending.storeRelease(0);
+
+    std::function<void()> command;
+
+    while (queue->pop(command)) {
+        command();
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <QObject>
+#include <QThread>
+#include <QAtomicInt>
+#include "commandqueue.h"
+
+class QOpenGLContext;
+class QOffscreenSurface;
+class QTimer;
+class RenderThreadWorker;
+
+/// Runs rendering on its own thread with OpenGL context shared with preview,
+/// so editing in GUI thread and rendering do not wait for each other.
+/// GUI thread passes commands through lock-free queue, render thread runs
+/// them in order before next frame. Where platform does not support OpenGL
+/// on other threads, commands and frames run on GUI thread instead, with
+/// render context made current for each of them
+class RenderThread : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// must be created in GUI thread
+    explicit RenderThread(QOpenGLContext *shareContext, QObject *parent = Q_NULLPTR);
+    ~RenderThread();
+
+    QOpenGLContext* context() const;
+    /// false if rendering shares GUI thread
+    bool isThreaded() const;
+    /// surface context is current with outside of window rendering
+    QOffscreenSurface* surface() const;
+
+    /// start thread calling frame about fps times per second
+    void start(const std::function<void()> &frame, int fps);
+    /// run queued commands and cleanup with context current, then stop thread
+    void stop(const std::function<void()> &cleanup);
+
+    /// queue command to run on render thread. GUI thread only
+    void post(const std::function<void()> &command);
+    /// run command on render thread and wait for it. GUI thread only
+    void call(const std::function<void()> &command);
+    /// run command on render thread and return its result. GUI thread only
+    template<typename T>
+    T call(const std::function<T()> &command)
+    {
+        T result;
+
+        call([&command, &result]() {
+            result = command();
+        });
+
+        return result;
+    }
+
+private:
+    QThread thread;
+    const bool threaded;
+    QOffscreenSurface *offscreenSurface;
+    CommandQueue queue;
+    RenderThreadWorker *worker;
+};
+
+class RenderThreadWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    RenderThreadWorker(QOpenGLContext *context, QOffscreenSurface *surface,
+                       CommandQueue *queue, bool threaded);
+
+    /// set before thread starts
+    std::function<void()> frame;
+    /// set while queued commands are waiting for runCommands()
+    QAtomicInt wakeupPending;
+    QOpenGLContext *context;
+
+public slots:
+    void start(int interval);
+    void runCommands();
+    /// stop frames and destroy context on render thread
+    void release();
+
+private slots:
+    void timeout();
+
+private:
+    /// run queued commands, context is current
+    void runQueuedCommands();
+
+    QOffscreenSurface *surface;
+    CommandQueue *queue;
+    QTimer *timer;
+    /// false if worker lives in GUI thread
+    bool threaded;
+};
+
+#endif // RENDERTHREAD_H
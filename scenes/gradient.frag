@@ -0,0 +1,15 @@
+#version 330 core
+
+out vec4 fragColor;
+
+uniform float iTime;
+uniform vec2 iResolution;
+
+// channels are multiples of 1/255, stored without rounding
+void main(void)
+{
+    ivec2 p = ivec2(gl_FragCoord.xy) * 255 / (ivec2(iResolution) - 1);
+    int blue = int(iTime * 100.0) & 255;
+
+    fragColor = vec4(vec3(p, blue) / 255.0, 1.0);
+}
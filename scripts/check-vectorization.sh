@@ -0,0 +1,32 @@
+#!/bin/sh
+# Compile image comparison kernels with release flags and check that GCC
+# vectorized a loop in each of them. Kernels are not inlined, so every loop
+# is reported in its own function.
+#
+# Usage: scripts/check-vectorization.sh
+# CXX and QT_CFLAGS override compiler and Qt include flags.
+
+cd "$(dirname "$0")/.." || exit 1
+
+CXX=${CXX:-g++}
+QT_CFLAGS=${QT_CFLAGS:-$(pkg-config --cflags Qt5Core Qt5Gui)}
+dump=$(mktemp)
+
+trap 'rm -f "$dump"' EXIT
+
+$CXX -std=c++11 -fPIC -O2 -ftree-vectorize -fno-inline $QT_CFLAGS \
+    -fdump-tree-vect-details="$dump" -c imagedifference.cpp -o /dev/null || exit 1
+
+failed=0
+
+for kernel in compareRow convertToLuma sumBlocks sumWindowSimilarity; do
+    if ! awk -v kernel="$kernel" '
+            /^;; Function / { inside = index($0, "::" kernel " ") || index($0, "::" kernel ".") }
+            inside && /optimized: loop vectorized/ { found = 1 }
+            END { exit !found }' "$dump"; then
+        echo "$kernel: loop is not vectorized"
+        failed=1
+    fi
+done
+
+exit $failed
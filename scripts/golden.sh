@@ -0,0 +1,20 @@
+#!/bin/sh
+# Render reference scenes and compare them with their golden images. Run it
+# before and after renderer changes, state caching, sampler objects and
+# render order must not change any capture.
+#
+# Usage: scripts/golden.sh [ShaderWorkshop binary] [extra --golden options]
+# Golden images are captured with: scripts/golden.sh <binary> --update-golden
+# on a build whose output is known to be right, then reviewed and committed.
+# Without display run it with QT_QPA_PLATFORM=offscreen or under xvfb-run.
+
+scenes=$(dirname "$0")/../scenes
+binary=${1:-./ShaderWorkshop}
+
+if [ $# -gt 0 ]; then
+    shift
+fi
+
+# goldens are 64x64 captures at 0 and 1 second, drivers may round
+# halfway values of linear filtering either way
+exec "$binary" --golden "$scenes" --times 0,1 --size 64x64 --max-error 1 "$@"
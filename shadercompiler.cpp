@@ -0,0 +1,82 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shadercompiler.h"
+#include "glshader.h"
+#include "tracer.h"
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+
+ShaderCompiler::ShaderCompiler(QOpenGLContext *shareContext, QObject *parent) :
+    QObject(parent),
+    worker(new ShaderCompilerWorker(shareContext))
+{
+    // compiled() is delivered across threads
+    qRegisterMetaType<GLuint>("GLuint");
+
+    connect(worker, &ShaderCompilerWorker::compiled, this, &ShaderCompiler::compiled);
+
+    worker->start("Shader compiler");
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+    worker->stop();
+
+    delete worker;
+}
+
+void ShaderCompiler::compile(const QByteArray &key, const QString &vertexSource,
+                             const QString &fragmentSource)
+{
+    QMetaObject::invokeMethod(worker, "compile", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, key),
+                              Q_ARG(QString, vertexSource),
+                              Q_ARG(QString, fragmentSource));
+}
+
+ShaderCompilerWorker::ShaderCompilerWorker(QOpenGLContext *shareContext) :
+    OffscreenWorker(shareContext)
+{
+}
+
+void ShaderCompilerWorker::compile(const QByteArray &key, const QString &vertexSource,
+                                   const QString &fragmentSource)
+{
+    TRACE_SCOPE("compileVariant", "compile");
+
+    if (!makeCurrent()) {
+        emit compiled(key, 0, tr("Could not create shared OpenGL context"));
+        return;
+    }
+
+    QOpenGLExtraFunctions *gl = context->extraFunctions();
+    QString log;
+    GLuint vertex = GlShader::compile(gl, GL_VERTEX_SHADER, vertexSource, log);
+    GLuint fragment = GlShader::compile(gl, GL_FRAGMENT_SHADER, fragmentSource, log);
+    GLuint program = vertex && fragment ? GlShader::link(gl, vertex, fragment, log) : 0;
+
+    // shaders are released together with program
+    gl->glDeleteShader(vertex);
+    gl->glDeleteShader(fragment);
+
+    // program must be complete before renderer context uses it
+    gl->glFinish();
+
+    emit compiled(key, program, log);
+}
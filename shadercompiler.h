@@ -0,0 +1,66 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHADERCOMPILER_H
+#define SHADERCOMPILER_H
+
+#include "offscreenworker.h"
+#include <QOpenGLFunctions>
+
+class ShaderCompilerWorker;
+
+/// Compiles and links shader programs on a worker thread using OpenGL
+/// context shared with renderer, so compilation does not block rendering.
+/// Resulting program objects belong to renderer's share group
+class ShaderCompiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// must be created in GUI thread
+    explicit ShaderCompiler(QOpenGLContext *shareContext, QObject *parent = Q_NULLPTR);
+    ~ShaderCompiler();
+
+    /// queue program compilation, result is reported by compiled() signal
+    void compile(const QByteArray &key, const QString &vertexSource,
+                 const QString &fragmentSource);
+
+signals:
+    /// program is 0 if compilation or linking failed
+    void compiled(const QByteArray &key, GLuint program, const QString &log);
+
+private:
+    ShaderCompilerWorker *worker;
+};
+
+class ShaderCompilerWorker : public OffscreenWorker
+{
+    Q_OBJECT
+
+public:
+    explicit ShaderCompilerWorker(QOpenGLContext *shareContext);
+
+public slots:
+    void compile(const QByteArray &key, const QString &vertexSource,
+                 const QString &fragmentSource);
+
+signals:
+    void compiled(const QByteArray &key, GLuint program, const QString &log);
+};
+
+#endif // SHADERCOMPILER_H
@@ -0,0 +1,530 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shaderlibrary.h"
+#include "shaderpreprocessor.h"
+#include "glshader.h"
+#include "project.h"
+#include "tracer.h"
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDirIterator>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+
+namespace {
+
+const quint32 indexMagic = 0x53574c49; // 'SWLI'
+const quint32 indexVersion = 1;
+/// thumbnails rendered before are kept, bump to render all of them again
+const int thumbnailVersion = 2;
+const int thumbnailWidth = 160;
+const int thumbnailHeight = 90;
+/// iTime effects are captured at, most start from black at zero
+const float thumbnailTime = 2.0f;
+/// entries reported at once while directory is indexed
+const int batchSize = 64;
+
+QDataStream& operator<<(QDataStream &stream, const LibraryEntry &entry)
+{
+    return stream << entry.fileName << entry.project << entry.modified << entry.size
+                  << entry.hash << entry.text;
+}
+
+QDataStream& operator>>(QDataStream &stream, LibraryEntry &entry)
+{
+    return stream >> entry.fileName >> entry.project >> entry.modified >> entry.size
+                  >> entry.hash >> entry.text;
+}
+
+} // namespace
+
+ShaderLibrary::ShaderLibrary(QObject *parent) :
+    QObject(parent),
+    worker(new ShaderLibraryWorker()),
+    generation(0)
+{
+    qRegisterMetaType<QVector<LibraryEntry>>("QVector<LibraryEntry>");
+
+    connect(worker, SIGNAL(entriesFound(int,QVector<LibraryEntry>)),
+            this, SLOT(workerEntriesFound(int,QVector<LibraryEntry>)));
+    connect(worker, SIGNAL(indexingFinished(int,int)),
+            this, SLOT(workerIndexingFinished(int,int)));
+    connect(worker, SIGNAL(thumbnailReady(int,QString,QImage)),
+            this, SLOT(workerThumbnailReady(int,QString,QImage)));
+
+    worker->start("Shader library");
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+    // stop rendering thumbnails of current directory
+    worker->latestGeneration.fetchAndAddOrdered(1);
+    worker->stop();
+
+    delete worker;
+}
+
+void ShaderLibrary::setDirectory(const QString &directory)
+{
+    generation = worker->latestGeneration.fetchAndAddOrdered(1) + 1;
+
+    QMetaObject::invokeMethod(worker, "index", Qt::QueuedConnection,
+                              Q_ARG(QString, directory), Q_ARG(int, generation));
+}
+
+void ShaderLibrary::workerEntriesFound(int generation, const QVector<LibraryEntry> &entries)
+{
+    if (generation == this->generation) {
+        emit entriesFound(entries);
+    }
+}
+
+void ShaderLibrary::workerIndexingFinished(int generation, int count)
+{
+    if (generation == this->generation) {
+        emit indexingFinished(count);
+    }
+}
+
+void ShaderLibrary::workerThumbnailReady(int generation, const QString &fileName,
+                                         const QImage &thumbnail)
+{
+    if (generation == this->generation) {
+        emit thumbnailReady(fileName, thumbnail);
+    }
+}
+
+ShaderLibraryWorker::ShaderLibraryWorker() :
+    framebuffer(Q_NULLPTR),
+    vertexShader(0),
+    vertexArray(0),
+    vertexBuffer(0),
+    renderingInitialized(false),
+    cacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                   + "/library")
+{
+}
+
+void ShaderLibraryWorker::index(const QString &directory, int generation)
+{
+    if (outdated(generation)) {
+        return;
+    }
+
+    TRACE_SCOPE("indexLibrary", "library");
+
+    QDir().mkpath(cacheDirectory + "/thumbnails");
+
+    // one index per directory, named by its path
+    const QString path = QFileInfo(directory).absoluteFilePath();
+    const QString indexFile = cacheDirectory + '/'
+            + QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex()
+            + ".index";
+
+    const QHash<QString, LibraryEntry> stored = loadIndex(indexFile);
+    QStringList files;
+    QDirIterator it(path, QStringList() << "*.frag" << "*.swproj", QDir::Files,
+                    QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+
+    while (it.hasNext()) {
+        files.append(it.next());
+    }
+
+    files.sort();
+
+    QVector<LibraryEntry> entries;
+    QVector<LibraryEntry> batch;
+
+    for (const QString &fileName : files) {
+        if (outdated(generation)) {
+            return;
+        }
+
+        const QFileInfo info(fileName);
+        LibraryEntry entry = stored.value(fileName);
+
+        // unchanged files are not read again
+        if (entry.fileName.isEmpty() || entry.modified != info.lastModified()
+                || entry.size != info.size()) {
+            if (!readEntry(fileName, entry)) {
+                continue;
+            }
+        }
+
+        entries.append(entry);
+        batch.append(entry);
+
+        if (batch.size() == batchSize) {
+            emit entriesFound(generation, batch);
+            batch.clear();
+        }
+    }
+
+    if (!batch.isEmpty()) {
+        emit entriesFound(generation, batch);
+    }
+
+    saveIndex(indexFile, entries);
+
+    emit indexingFinished(generation, entries.size());
+
+    for (const LibraryEntry &entry : entries) {
+        if (outdated(generation)) {
+            return;
+        }
+
+        const QImage image = thumbnail(entry);
+
+        if (!image.isNull()) {
+            emit thumbnailReady(generation, entry.fileName, image);
+        }
+    }
+}
+
+void ShaderLibraryWorker::releaseResources()
+{
+    if (framebuffer) {
+        QOpenGLExtraFunctions *gl = context->extraFunctions();
+
+        delete framebuffer;
+        gl->glDeleteShader(vertexShader);
+        gl->glDeleteVertexArrays(1, &vertexArray);
+        gl->glDeleteBuffers(1, &vertexBuffer);
+    }
+}
+
+bool ShaderLibraryWorker::outdated(int generation) const
+{
+    return latestGeneration.loadAcquire() != generation;
+}
+
+QHash<QString, LibraryEntry> ShaderLibraryWorker::loadIndex(const QString &fileName) const
+{
+    QHash<QString, LibraryEntry> entries;
+    QFile file(fileName);
+
+    if (!file.open(QFile::ReadOnly)) {
+        return entries;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+
+    stream.setVersion(QDataStream::Qt_5_7);
+    stream >> magic >> version >> count;
+
+    if (magic != indexMagic || version != indexVersion) {
+        return entries;
+    }
+
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        LibraryEntry entry;
+
+        stream >> entry;
+        entries.insert(entry.fileName, entry);
+    }
+
+    // truncated index is read again from files
+    if (stream.status() != QDataStream::Ok) {
+        entries.clear();
+    }
+
+    return entries;
+}
+
+void ShaderLibraryWorker::saveIndex(const QString &fileName,
+                                    const QVector<LibraryEntry> &entries) const
+{
+    QSaveFile file(fileName);
+
+    if (!file.open(QFile::WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+
+    stream.setVersion(QDataStream::Qt_5_7);
+    stream << indexMagic << indexVersion << qint32(entries.size());
+
+    for (const LibraryEntry &entry : entries) {
+        stream << entry;
+    }
+
+    file.commit();
+}
+
+bool ShaderLibraryWorker::readEntry(const QString &fileName, LibraryEntry &entry) const
+{
+    TRACE_SCOPE("indexLibraryFile", "library");
+
+    QFile file(fileName);
+
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    const QFileInfo info(file);
+    const QByteArray contents = file.readAll();
+
+    entry = LibraryEntry();
+    entry.fileName = fileName;
+    entry.project = info.suffix() == "swproj";
+    entry.modified = info.lastModified();
+    entry.size = info.size();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    hash.addData(contents);
+    hash.addData(QByteArray::number(thumbnailVersion));
+    entry.hash = hash.result();
+
+    if (!entry.project) {
+        entry.text = QString::fromUtf8(contents);
+        return true;
+    }
+
+    Project project;
+    QString error;
+
+    if (!project.load(fileName, error)) {
+        return false;
+    }
+
+    for (const ProjectPage &page : project.pages) {
+        entry.text += page.source;
+        entry.text += '\n';
+    }
+
+    return true;
+}
+
+QImage ShaderLibraryWorker::thumbnail(const LibraryEntry &entry)
+{
+    QString source;
+    QHash<QString, QString> pages;
+
+    if (entry.project) {
+        // thumbnail saved in project depends only on project file
+        const QString fileName = thumbnailFile(entry.hash);
+
+        if (QFileInfo::exists(fileName)) {
+            return QImage(fileName, "PNG");
+        }
+
+        Project project;
+        QString error;
+
+        if (!project.load(entry.fileName, error)) {
+            return QImage();
+        }
+
+        // projects saved by editor already have one
+        if (!project.thumbnail.isNull()) {
+            const QImage image = project.thumbnail.scaled(thumbnailWidth, thumbnailHeight,
+                                                          Qt::KeepAspectRatio,
+                                                          Qt::SmoothTransformation);
+
+            image.save(fileName, "PNG");
+            return image;
+        }
+
+        for (const ProjectPage &page : project.pages) {
+            pages.insert(page.name, page.source);
+        }
+
+        // buffers are not rendered, only main image
+        if (!pages.contains("Image")) {
+            return QImage();
+        }
+
+        source = pages.value("Image");
+    }
+    else {
+        source = entry.text;
+    }
+
+    // includes are project pages or files next to effect, like in editor
+    const QDir directory = QFileInfo(entry.fileName).absoluteDir();
+    ShaderPreprocessor preprocessor([&pages, &directory](const QString &name,
+                                                         QString &contents) {
+        if (pages.contains(name)) {
+            contents = pages.value(name);
+            return true;
+        }
+
+        QFile include(directory.absoluteFilePath(name));
+
+        if (!include.open(QFile::ReadOnly | QFile::Text)) {
+            return false;
+        }
+
+        contents = QString::fromUtf8(include.readAll());
+        return true;
+    });
+
+    QString output;
+    QStringList includes;
+    QList<QByteArray> includeHashes;
+    QString error;
+
+    // missing include may appear later, effect is tried again then
+    if (!preprocessor.process(source, output, includes, includeHashes, error)
+            || GlShader::isCompute(output)) {
+        return QImage();
+    }
+
+    // rendered thumbnail changes with any of the includes as well
+    QCryptographicHash key(QCryptographicHash::Sha1);
+
+    key.addData(entry.hash);
+    key.addData("includes");
+
+    for (const QByteArray &includeHash : includeHashes) {
+        key.addData(includeHash);
+    }
+
+    const QString fileName = thumbnailFile(key.result());
+
+    // empty file marks effects that failed to compile or link
+    if (QFileInfo::exists(fileName)) {
+        return QFileInfo(fileName).size() ? QImage(fileName, "PNG") : QImage();
+    }
+
+    TRACE_SCOPE("renderLibraryThumbnail", "library");
+
+    bool failed = false;
+    const QImage image = renderThumbnail(output, failed);
+
+    if (!image.isNull()) {
+        image.save(fileName, "PNG");
+    }
+    else if (failed) {
+        QFile marker(fileName);
+
+        marker.open(QFile::WriteOnly);
+    }
+
+    return image;
+}
+
+QString ShaderLibraryWorker::thumbnailFile(const QByteArray &key) const
+{
+    return cacheDirectory + "/thumbnails/" + key.toHex() + ".png";
+}
+
+QImage ShaderLibraryWorker::renderThumbnail(const QString &source, bool &failed)
+{
+    // without context nothing is known about effect, it is tried again later
+    if (!initializeRendering()) {
+        return QImage();
+    }
+
+    QOpenGLExtraFunctions *gl = context->extraFunctions();
+    // thumbnails only tell whether effect works, logs are not shown
+    QString log;
+    GLuint fragmentShader = GlShader::compile(gl, GL_FRAGMENT_SHADER, source, log);
+
+    if (!fragmentShader) {
+        failed = true;
+        return QImage();
+    }
+
+    GLuint program = GlShader::link(gl, vertexShader, fragmentShader, log);
+    QImage image;
+
+    gl->glDeleteShader(fragmentShader);
+
+    if (program) {
+        gl->glUseProgram(program);
+        gl->glUniform1f(gl->glGetUniformLocation(program, "iTime"), thumbnailTime);
+        gl->glUniform1i(gl->glGetUniformLocation(program, "iFrame"), 0);
+        gl->glUniform2f(gl->glGetUniformLocation(program, "iResolution"),
+                        thumbnailWidth, thumbnailHeight);
+        gl->glUniform4f(gl->glGetUniformLocation(program, "iMouse"), 0.0f, 0.0f, 0.0f, 0.0f);
+
+        framebuffer->bind();
+        gl->glViewport(0, 0, thumbnailWidth, thumbnailHeight);
+        gl->glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        gl->glClear(GL_COLOR_BUFFER_BIT);
+        gl->glBindVertexArray(vertexArray);
+        gl->glDrawArrays(GL_TRIANGLES, 0, 6);
+        gl->glBindVertexArray(0);
+        gl->glUseProgram(0);
+
+        // preview ignores alpha as well
+        image = framebuffer->toImage().convertToFormat(QImage::Format_RGB32);
+        framebuffer->release();
+    }
+
+    gl->glDeleteProgram(program);
+    failed = !program;
+
+    return image;
+}
+
+bool ShaderLibraryWorker::initializeRendering()
+{
+    if (renderingInitialized) {
+        return framebuffer != Q_NULLPTR;
+    }
+
+    renderingInitialized = true;
+
+    if (!makeCurrent()) {
+        return false;
+    }
+
+    QOpenGLExtraFunctions *gl = context->extraFunctions();
+    QString log;
+
+    vertexShader = GlShader::compile(gl, GL_VERTEX_SHADER, GlShader::vertexSource, log);
+
+    Q_ASSERT(vertexShader != 0);
+
+    const GLfloat vertices[] = {
+        -1.0, 1.0,
+        -1.0, -1.0,
+        1.0, -1.0,
+
+        -1.0, 1.0,
+        1.0, -1.0,
+        1.0, 1.0
+    };
+
+    gl->glGenVertexArrays(1, &vertexArray);
+    gl->glBindVertexArray(vertexArray);
+    gl->glGenBuffers(1, &vertexBuffer);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    gl->glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    gl->glEnableVertexAttribArray(0);
+    gl->glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), Q_NULLPTR);
+    gl->glBindVertexArray(0);
+
+    framebuffer = new QOpenGLFramebufferObject(thumbnailWidth, thumbnailHeight);
+
+    return true;
+}
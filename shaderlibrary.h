@@ -0,0 +1,140 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHADERLIBRARY_H
+#define SHADERLIBRARY_H
+
+#include "offscreenworker.h"
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+#include <QImage>
+#include <QMetaType>
+#include <QOpenGLFunctions>
+
+class QOpenGLFramebufferObject;
+class ShaderLibraryWorker;
+
+/// shader or project file found in library directory
+struct LibraryEntry
+{
+    LibraryEntry() :
+        project(false),
+        size(0)
+    {
+    }
+
+    QString fileName;
+    /// '.swproj' project, otherwise fragment shader
+    bool project;
+    /// file modification time and size entry was read with
+    QDateTime modified;
+    qint64 size;
+    /// SHA-1 of file contents and thumbnail version, names cached thumbnail
+    /// together with hashes of includes
+    QByteArray hash;
+    /// shader source or sources of all project pages, for content filtering
+    QString text;
+};
+
+Q_DECLARE_METATYPE(LibraryEntry)
+
+/// Index of shaders and projects in a directory. Directory is indexed on
+/// a worker thread, file contents are read only for new or changed files,
+/// the rest comes from index stored in cache directory. Worker then renders
+/// thumbnails at fixed iTime with its own offscreen OpenGL context and keeps
+/// them in cache directory by content hash, so they are rendered only once
+class ShaderLibrary : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// must be created in GUI thread
+    explicit ShaderLibrary(QObject *parent = Q_NULLPTR);
+    ~ShaderLibrary();
+
+    /// index directory and its subdirectories in background.
+    /// Results of previous directory are not reported anymore
+    void setDirectory(const QString &directory);
+
+signals:
+    /// entries are reported in batches, sorted by path
+    void entriesFound(const QVector<LibraryEntry> &entries);
+    /// all entries are reported, thumbnails follow
+    void indexingFinished(int count);
+    void thumbnailReady(const QString &fileName, const QImage &thumbnail);
+
+private slots:
+    void workerEntriesFound(int generation, const QVector<LibraryEntry> &entries);
+    void workerIndexingFinished(int generation, int count);
+    void workerThumbnailReady(int generation, const QString &fileName,
+                              const QImage &thumbnail);
+
+private:
+    ShaderLibraryWorker *worker;
+    /// generation of last setDirectory() call
+    int generation;
+};
+
+class ShaderLibraryWorker : public OffscreenWorker
+{
+    Q_OBJECT
+
+public:
+    ShaderLibraryWorker();
+
+    /// incremented by GUI thread for each directory, older indexing stops
+    QAtomicInt latestGeneration;
+
+public slots:
+    void index(const QString &directory, int generation);
+
+signals:
+    void entriesFound(int generation, const QVector<LibraryEntry> &entries);
+    void indexingFinished(int generation, int count);
+    void thumbnailReady(int generation, const QString &fileName, const QImage &thumbnail);
+
+protected:
+    void releaseResources() Q_DECL_OVERRIDE;
+
+private:
+    bool outdated(int generation) const;
+    QHash<QString, LibraryEntry> loadIndex(const QString &fileName) const;
+    void saveIndex(const QString &fileName, const QVector<LibraryEntry> &entries) const;
+    bool readEntry(const QString &fileName, LibraryEntry &entry) const;
+    /// cached thumbnail or a new one, null image if effect could not be rendered.
+    /// Rendered thumbnails are cached by hashes of entry and of its includes
+    QImage thumbnail(const LibraryEntry &entry);
+    QString thumbnailFile(const QByteArray &key) const;
+    /// render preprocessed source, null image if effect could not be rendered.
+    /// failed is set only if it does not compile or link, so retrying would not help
+    QImage renderThumbnail(const QString &source, bool &failed);
+    bool initializeRendering();
+
+    QOpenGLFramebufferObject *framebuffer;
+    GLuint vertexShader;
+    GLuint vertexArray;
+    GLuint vertexBuffer;
+    /// rendering objects are created when first thumbnail is missing
+    bool renderingInitialized;
+    /// index files and thumbnails are stored here
+    const QString cacheDirectory;
+};
+
+#endif // SHADERLIBRARY_H
@@ -0,0 +1,46 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shaderlog.h"
+#include <QRegularExpression>
+
+ShaderLogMessage::ShaderLogMessage() :
+    source(-1),
+    line(-1)
+{
+}
+
+bool ShaderLogMessage::parse(const QString &message, ShaderLogMessage &result)
+{
+    // typical OpenGL shader compilation error message:
+    // "ERROR: <source>:<line>: <description>"
+    static const QRegularExpression re("(\\w+): (\\d+):(\\d+): ([^\n]*)");
+
+    auto match = re.match(message);
+
+    if (!match.hasMatch()) {
+        return false;
+    }
+
+    result.severity = match.captured(1);
+    result.source = match.captured(2).toInt();
+    result.line = match.captured(3).toInt();
+    result.description = match.captured(4);
+
+    return true;
+}
@@ -0,0 +1,41 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHADERLOG_H
+#define SHADERLOG_H
+
+#include <QString>
+
+/// Message of OpenGL shader compilation log, typically
+/// "ERROR: <source>:<line>: <description>"
+struct ShaderLogMessage
+{
+    ShaderLogMessage();
+
+    /// parse single log line, returns false if it has no known format
+    static bool parse(const QString &message, ShaderLogMessage &result);
+
+    /// ERROR, WARNING or whatever word driver uses
+    QString severity;
+    /// 0 for shader itself, included sources have other numbers
+    int source;
+    int line;
+    QString description;
+};
+
+#endif // SHADERLOG_H
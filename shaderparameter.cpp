@@ -0,0 +1,172 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shaderparameter.h"
+#include <QRegularExpression>
+#include <QStringList>
+#include <QtNumeric>
+#include <cstring>
+
+namespace {
+
+GLenum parameterType(const QString &name)
+{
+    if (name == "float") {
+        return GL_FLOAT;
+    }
+
+    if (name == "int") {
+        return GL_INT;
+    }
+
+    if (name == "bool") {
+        return GL_BOOL;
+    }
+
+    return name == "vec3" ? GL_FLOAT_VEC3 : GL_FLOAT_VEC4;
+}
+
+float argument(const QStringList &arguments, int index, float defaultValue)
+{
+    bool ok = false;
+    float value = arguments.value(index).toFloat(&ok);
+
+    return ok ? value : defaultValue;
+}
+
+QString floatLiteral(float value)
+{
+    // GLSL has no literals for infinity and NaN, construct them from bits
+    if (!qIsFinite(value)) {
+        quint32 bits;
+
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        return QString("uintBitsToFloat(0x%1u)").arg(bits, 8, 16, QChar('0'));
+    }
+
+    QString text = QString::number(value, 'g', 9);
+
+    // GLSL needs decimal point to treat number as float
+    if (!text.contains('.') && !text.contains('e')) {
+        text += ".0";
+    }
+
+    return text;
+}
+
+} // namespace
+
+QList<ShaderParameter> ShaderParameter::parse(const QString &source)
+{
+    static const QRegularExpression re(
+                "^\\s*uniform\\s+(float|int|bool|vec3|vec4)\\s+(\\w+)\\s*;"
+                "\\s*//\\s*@(slider|color|toggle)\\b([^\\n]*)$",
+                QRegularExpression::MultilineOption);
+
+    QList<ShaderParameter> parameters;
+    auto it = re.globalMatch(source);
+
+    while (it.hasNext()) {
+        auto match = it.next();
+        const QString annotation = match.captured(3);
+        QStringList arguments = match.captured(4).split(' ');
+
+        // several spaces between arguments leave empty parts
+        arguments.removeAll(QString());
+        ShaderParameter parameter;
+
+        parameter.name = match.captured(2);
+        parameter.type = parameterType(match.captured(1));
+
+        const bool scalar = parameter.type == GL_FLOAT || parameter.type == GL_INT;
+        const bool vector = parameter.type == GL_FLOAT_VEC3 || parameter.type == GL_FLOAT_VEC4;
+
+        if (annotation == "slider" && scalar) {
+            parameter.control = Slider;
+            parameter.minimum = argument(arguments, 0, 0.0f);
+            parameter.maximum = argument(arguments, 1, 1.0f);
+            parameter.value.setX(argument(arguments, 2, parameter.minimum));
+        }
+        else if (annotation == "color" && vector) {
+            parameter.control = Color;
+            parameter.value = QVector4D(argument(arguments, 0, 1.0f),
+                                        argument(arguments, 1, 1.0f),
+                                        argument(arguments, 2, 1.0f),
+                                        argument(arguments, 3, 1.0f));
+        }
+        else if (annotation == "toggle" && (parameter.type == GL_BOOL
+                                            || parameter.type == GL_INT)) {
+            const QString state = arguments.value(0);
+
+            parameter.control = Toggle;
+            parameter.value.setX(state == "on" || state == "true" || state == "1");
+        }
+        else {
+            // annotation does not fit uniform type
+            continue;
+        }
+
+        parameters.append(parameter);
+    }
+
+    return parameters;
+}
+
+QString ShaderParameter::typeName(GLenum type)
+{
+    switch (type) {
+    case GL_FLOAT:
+        return "float";
+    case GL_INT:
+        return "int";
+    case GL_BOOL:
+        return "bool";
+    case GL_FLOAT_VEC3:
+        return "vec3";
+    case GL_FLOAT_VEC4:
+        return "vec4";
+    default:
+        Q_ASSERT(false);
+    }
+
+    return QString();
+}
+
+QString ShaderParameter::literal(GLenum type, const QVector4D &value)
+{
+    switch (type) {
+    case GL_FLOAT:
+        return floatLiteral(value.x());
+    case GL_INT:
+        return QString::number(qRound(value.x()));
+    case GL_BOOL:
+        return value.x() != 0.0f ? "true" : "false";
+    case GL_FLOAT_VEC3:
+        return QString("vec3(%1, %2, %3)").arg(floatLiteral(value.x()))
+                .arg(floatLiteral(value.y())).arg(floatLiteral(value.z()));
+    case GL_FLOAT_VEC4:
+        return QString("vec4(%1, %2, %3, %4)").arg(floatLiteral(value.x()))
+                .arg(floatLiteral(value.y())).arg(floatLiteral(value.z()))
+                .arg(floatLiteral(value.w()));
+    default:
+        Q_ASSERT(false);
+    }
+
+    return QString();
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHADERPARAMETER_H
+#define SHADERPARAMETER_H
+
+#include <QString>
+#include <QList>
+#include <QVector4D>
+#include <QOpenGLFunctions>
+
+/// User-tweakable uniform declared in shader source with annotation comment:
+///   uniform float roughness; // @slider 0 1 [default]
+///   uniform int steps; // @slider 1 128 [default]
+///   uniform vec3 tint; // @color [r g b]
+///   uniform vec4 fog; // @color [r g b a]
+///   uniform bool shadows; // @toggle [on]
+struct ShaderParameter
+{
+    enum Control
+    {
+        Slider,
+        Color,
+        Toggle
+    };
+
+    ShaderParameter() :
+        type(GL_FLOAT),
+        control(Slider),
+        minimum(0.0f),
+        maximum(1.0f)
+    {
+    }
+
+    /// find all annotated uniforms in source
+    static QList<ShaderParameter> parse(const QString &source);
+    /// GLSL name of parameter type
+    static QString typeName(GLenum type);
+    /// GLSL constant expression for parameter value
+    static QString literal(GLenum type, const QVector4D &value);
+
+    QString name;
+    /// GL_FLOAT, GL_INT, GL_BOOL, GL_FLOAT_VEC3 or GL_FLOAT_VEC4
+    GLenum type;
+    Control control;
+    /// slider range
+    float minimum;
+    float maximum;
+    /// current value, unused components are zero
+    QVector4D value;
+};
+
+#endif // SHADERPARAMETER_H
@@ -0,0 +1,139 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shaderpreprocessor.h"
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QObject>
+
+ShaderPreprocessor::ShaderPreprocessor(const IncludeResolver &resolver) :
+    resolver(resolver)
+{
+}
+
+bool ShaderPreprocessor::process(const QString &source, QString &output,
+                                 QStringList &includes, QString &error)
+{
+    QList<QByteArray> includeHashes;
+
+    return process(source, output, includes, includeHashes, error);
+}
+
+bool ShaderPreprocessor::process(const QString &source, QString &output,
+                                 QStringList &includes, QList<QByteArray> &includeHashes,
+                                 QString &error)
+{
+    const QByteArray key = hash(source);
+    auto it = cache.constFind(key);
+
+    if (it != cache.constEnd() && isValid(it.value())) {
+        output = it.value().output;
+        includes = it.value().includes;
+        includeHashes = it.value().includeHashes;
+        return true;
+    }
+
+    CacheEntry entry;
+
+    if (!expand(source, 0, 0, entry, error)) {
+        return false;
+    }
+
+    if (cache.size() >= maxCacheEntries) {
+        cache.clear();
+    }
+
+    cache.insert(key, entry);
+
+    output = entry.output;
+    includes = entry.includes;
+    includeHashes = entry.includeHashes;
+
+    return true;
+}
+
+bool ShaderPreprocessor::expand(const QString &text, int sourceNumber, int depth,
+                                CacheEntry &entry, QString &error)
+{
+    static const QRegularExpression includeDirective(
+                "^\\s*#\\s*include\\s+[\"<]([^\">]+)[\">]");
+
+    if (depth > maxIncludeDepth) {
+        error = QObject::tr("Includes are nested too deeply");
+        return false;
+    }
+
+    const QStringList lines = text.split('\n');
+
+    for (int i = 0; i < lines.size(); i++) {
+        const QString &line = lines[i];
+        auto match = includeDirective.match(line);
+
+        if (!match.hasMatch()) {
+            entry.output += line;
+            entry.output += '\n';
+            continue;
+        }
+
+        const QString name = match.captured(1);
+
+        // each include is inserted only once, this also breaks include cycles
+        if (!entry.includes.contains(name)) {
+            QString contents;
+
+            if (!resolver(name, contents)) {
+                error = QObject::tr("ERROR: %1:%2: could not include '%3'")
+                        .arg(sourceNumber).arg(i + 1).arg(name);
+                return false;
+            }
+
+            entry.includes.append(name);
+            entry.includeHashes.append(hash(contents));
+
+            // include gets its own source string number in error messages
+            entry.output += QString("#line 1 %1\n").arg(entry.includes.size());
+
+            if (!expand(contents, entry.includes.size(), depth + 1, entry, error)) {
+                return false;
+            }
+        }
+
+        entry.output += QString("#line %1 %2\n").arg(i + 2).arg(sourceNumber);
+    }
+
+    return true;
+}
+
+bool ShaderPreprocessor::isValid(const CacheEntry &entry)
+{
+    for (int i = 0; i < entry.includes.size(); i++) {
+        QString contents;
+
+        if (!resolver(entry.includes[i], contents)
+                || hash(contents) != entry.includeHashes[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QByteArray ShaderPreprocessor::hash(const QString &text)
+{
+    return QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Md5);
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHADERPREPROCESSOR_H
+#define SHADERPREPROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+#include <functional>
+
+/// Expands '#include "name"' directives in shader sources.
+/// Each include is inserted once, '#line' directives keep line numbers
+/// of compilation errors in the including source correct.
+/// Expanded sources are cached and reused while none of their includes change
+class ShaderPreprocessor
+{
+public:
+    /// returns contents of include with specified name, false if not found
+    using IncludeResolver = std::function<bool(const QString &name, QString &contents)>;
+
+    explicit ShaderPreprocessor(const IncludeResolver &resolver);
+
+    /// expand includes of source, names of all used includes go to includes.
+    /// '#line' directives of output number source itself 0 and include at
+    /// index i of includes i + 1. Returns false and fills error if include
+    /// could not be resolved
+    bool process(const QString &source, QString &output,
+                 QStringList &includes, QString &error);
+    /// same, hashes of contents of includes go to includeHashes in order
+    /// of includes, they change whenever any include changes
+    bool process(const QString &source, QString &output, QStringList &includes,
+                 QList<QByteArray> &includeHashes, QString &error);
+
+private:
+    struct CacheEntry
+    {
+        QString output;
+        QStringList includes;
+        QList<QByteArray> includeHashes;
+    };
+
+    bool expand(const QString &text, int sourceNumber, int depth, CacheEntry &entry,
+                QString &error);
+    bool isValid(const CacheEntry &entry);
+    static QByteArray hash(const QString &text);
+
+    IncludeResolver resolver;
+    QHash<QByteArray, CacheEntry> cache;
+    static const int maxIncludeDepth = 32;
+    static const int maxCacheEntries = 64;
+};
+
+#endif // SHADERPREPROCESSOR_H
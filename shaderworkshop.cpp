@@ -18,23 +18,51 @@
 
 #include "shaderworkshop.h"
 #include "renderer.h"
+#include "channelsettings.h"
+#include "project.h"
+#include "tracer.h"
+#include "presenterwindow.h"
+#include "librarybrowser.h"
 #include "ui_shaderworkshop.h"
 #include <QMenuBar>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
 #include <QMessageBox>
+#include <QMenu>
+#include <QActionGroup>
+#include <QCursor>
+#include <QSlider>
+#include <QGuiApplication>
+#include <QScreen>
 
 ShaderWorkshop::ShaderWorkshop(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::ShaderWorkshop),
+    presenterWindow(Q_NULLPTR),
+    libraryBrowser(Q_NULLPTR),
+    memoryBudgetGroup(Q_NULLPTR),
+    memoryPolicyGroup(Q_NULLPTR),
     imagePage(Q_NULLPTR),
+    commonPage(Q_NULLPTR),
+    preprocessor([this](const QString &name, QString &contents) {
+        return resolveInclude(name, contents);
+    }),
+    includeDirectory(QDir::currentPath()),
     defaultItemName("Add buffer"),
-    maxBufferPages(5),
+    commonPageName("Common"),
+    maxBufferPages(33),
     imagePageIndex(0),
+    commonPageIndex(maxBufferPages),
     imageEffectCreated(false)
 {
     ui->setupUi(this);
 
     renderer = ui->openGLWidget;
+    symbolIndex = new SymbolIndex(this);
+
+    connect(symbolIndex, SIGNAL(usagesFound(QString,QVector<Symbol>)),
+            this, SLOT(symbolUsagesFound(QString,QVector<Symbol>)));
 
     setupWidgets();
     createMenus();
@@ -42,10 +70,64 @@ ShaderWorkshop::ShaderWorkshop(QWidget *parent) :
 
 ShaderWorkshop::~ShaderWorkshop()
 {
+    if (presenterWindow) {
+        // render thread must stop using window first
+        renderer->setPresenter(Q_NULLPTR);
+    }
+
+    delete presenterWindow;
     qDeleteAll(pages);
     delete ui;
 }
 
+bool ShaderWorkshop::captureFrames(const QString &fileName, const QVector<GLfloat> &times,
+                                   QSize size, QVector<QImage> &images, QString &error)
+{
+    Q_ASSERT(imageEffectCreated);
+
+    Project project;
+
+    if (QFileInfo(fileName).suffix() == "swproj") {
+        if (!project.load(fileName, error)) {
+            return false;
+        }
+    }
+    else {
+        QFile file(fileName);
+
+        if (!file.open(QFile::ReadOnly | QFile::Text)) {
+            error = file.errorString();
+            return false;
+        }
+
+        // single shader is the main image of a project without buffers
+        ProjectPage page;
+
+        page.name = "Image";
+        page.source = QString::fromUtf8(file.readAll());
+        project.pages.append(page);
+    }
+
+    includeDirectory = QFileInfo(fileName).absolutePath();
+
+    const QString log = applyProject(project);
+
+    // fallback source would be captured instead of the scene
+    if (!log.isEmpty()) {
+        error = log;
+        return false;
+    }
+
+    images = renderer->captureFrames(times, size);
+
+    if (images.size() != times.size()) {
+        error = tr("Main image effect is not created");
+        return false;
+    }
+
+    return true;
+}
+
 void ShaderWorkshop::paintEvent(QPaintEvent *event)
 {
     if (!imageEffectCreated) {
@@ -71,7 +153,6 @@ void ShaderWorkshop::newBufferRequested(const QString &name)
     Q_ASSERT(pages.contains(name));
 
     EditorPage *page = pages.value(name);
-    page->setShaderSource(renderer->defaultFragmentShader());
     page->clearShaderLog();
 
     tab->insertTab(tab->count(), page, name);
@@ -79,9 +160,20 @@ void ShaderWorkshop::newBufferRequested(const QString &name)
     // always show default combo box item
     comboBox->setCurrentText(defaultItemName);
 
+    if (!hasEffect(page)) {
+        page->setShaderSource(tr("// code shared between buffers, "
+                                 "use it with #include \"%1\"\n").arg(commonPageName));
+        return;
+    }
+
+    page->setShaderSource(renderer->defaultFragmentShader());
+
     renderer->createEffect(pageIndex(page));
 
     connectPage(page);
+    // new effect always starts with default policy and channels
+    page->setUpdatePolicy(EffectUpdatePolicy::EveryFrame, 1);
+    page->setChannelCount(Effect::defaultChannels);
 }
 
 void ShaderWorkshop::bufferCloseRequested(int tabIndex)
@@ -95,11 +187,173 @@ void ShaderWorkshop::bufferCloseRequested(int tabIndex)
 
     EditorPage *page = pages.value(name);
 
+    updateDependencies(page, QStringList());
+
+    if (!hasEffect(page)) {
+        return;
+    }
+
     renderer->deleteEffect(pageIndex(page));
 
     disconnectPage(page);
 }
 
+void ShaderWorkshop::channelTextureRequested(int pageIndex, int channel,
+                                             const QString &fileName)
+{
+    QString error = renderer->setEffectChannelTexture(pageIndex, channel, fileName);
+
+    if (error.isEmpty()) {
+        return;
+    }
+
+    QMessageBox::critical(this, tr("Error"),
+                          tr("Could not load texture %1:\n%2")
+                            .arg(fileName)
+                            .arg(error));
+
+    EditorPage *page = qobject_cast<EditorPage*>(sender());
+    page->resetChannelInput(channel);
+}
+
+void ShaderWorkshop::symbolDefinitionRequested(const QString &name)
+{
+    EditorPage *page = qobject_cast<EditorPage*>(sender());
+    const QVector<Symbol> definitions = symbolIndex->definitions(name);
+    int found = -1;
+
+    // prefer definition from the same page, then from other open pages
+    for (int i = 0; i < definitions.size(); i++) {
+        EditorPage *definitionPage = openPage(definitions[i].document);
+
+        if (!definitionPage) {
+            continue;
+        }
+
+        if (definitionPage == page) {
+            found = i;
+            break;
+        }
+
+        if (found < 0) {
+            found = i;
+        }
+    }
+
+    if (found >= 0) {
+        showSymbol(definitions[found]);
+    }
+}
+
+void ShaderWorkshop::symbolUsagesRequested(const QString &name)
+{
+    symbolIndex->findUsages(name);
+}
+
+void ShaderWorkshop::symbolUsagesFound(const QString &name, const QVector<Symbol> &usages)
+{
+    // long menus are useless, show only first usages
+    const int maxUsages = 50;
+    QMenu menu(this);
+
+    for (int i = 0; i < usages.size() && menu.actions().size() < maxUsages; i++) {
+        const Symbol &usage = usages[i];
+        EditorPage *page = openPage(usage.document);
+
+        if (!page) {
+            continue;
+        }
+
+        QString text = QString("%1:%2: %3").arg(tab->tabText(tab->indexOf(page)))
+                .arg(usage.line).arg(page->lineText(usage.line).trimmed());
+        QAction *action = menu.addAction(text);
+
+        action->setData(i);
+    }
+
+    if (menu.isEmpty()) {
+        menu.addAction(tr("No usages of %1 found").arg(name))->setEnabled(false);
+    }
+
+    QAction *selected = menu.exec(QCursor::pos());
+
+    if (selected && selected->data().isValid()) {
+        showSymbol(usages[selected->data().toInt()]);
+    }
+}
+
+void ShaderWorkshop::currentPageChanged()
+{
+    if (ui->actionCostHeatmap->isChecked()) {
+        updateHeatmap();
+    }
+}
+
+void ShaderWorkshop::playbackFrameChanged(int frame)
+{
+    QSlider *slider = ui->timelineSlider;
+    const QSignalBlocker sliderBlocker(slider);
+    const QSignalBlocker pauseBlocker(ui->actionPause);
+
+    slider->setRange(renderer->firstSeekableFrame(), qMax(renderer->lastFrame(), 0));
+    slider->setValue(frame);
+
+    ui->timelineLabel->setText(tr("Frame %1, %2 s").arg(qMax(frame, 0))
+                               .arg(renderer->playbackTime(), 0, 'f', 2));
+    ui->actionPause->setChecked(renderer->isPaused());
+}
+
+void ShaderWorkshop::timelineValueChanged(int value)
+{
+    renderer->seekFrame(value);
+}
+
+void ShaderWorkshop::framesInFlightTriggered(QAction *action)
+{
+    renderer->setMaxFramesInFlight(action->data().toInt());
+}
+
+void ShaderWorkshop::memoryBudgetTriggered()
+{
+    const qint64 megabytes = memoryBudgetGroup->checkedAction()->data().toLongLong();
+    const int policy = memoryPolicyGroup->checkedAction()->data().toInt();
+
+    renderer->setMemoryBudget(megabytes * 1024 * 1024, policy);
+}
+
+void ShaderWorkshop::memoryUsageChanged(qint64 total, qint64 budget)
+{
+    const qint64 megabyte = 1024 * 1024;
+    QLabel *label = ui->memoryLabel;
+
+    if (budget > 0) {
+        label->setText(tr("GPU %1 / %2 MB").arg(total / megabyte).arg(budget / megabyte));
+    }
+    else {
+        label->setText(tr("GPU %1 MB").arg(total / megabyte));
+    }
+
+    label->setStyleSheet(budget > 0 && total > budget ? "color: red;" : QString());
+}
+
+void ShaderWorkshop::bakeFailed(int index, const QString &log)
+{
+    EditorPage *page = pageIndices.key(index, Q_NULLPTR);
+
+    if (page) {
+        page->shaderLogUpdated(tr("Baking parameters failed, uniforms are used:\n%1")
+                               .arg(log));
+    }
+}
+
+void ShaderWorkshop::memoryBudgetExceeded(int index, const QString &message)
+{
+    EditorPage *page = pageIndices.key(index, Q_NULLPTR);
+    const QString text = page ? QString("%1: %2").arg(pageName(page), message) : message;
+
+    QMessageBox::warning(this, tr("GPU Memory Budget"), text);
+}
+
 void ShaderWorkshop::setupWidgets()
 {
     tab = ui->tabWidget;
@@ -121,11 +375,35 @@ void ShaderWorkshop::setupWidgets()
 
     createPages(pagesData);
 
+    createCommonPage();
+
     connect(comboBox, static_cast<void (QComboBox::*)(const QString&)>(&QComboBox::activated),
             this, &ShaderWorkshop::newBufferRequested);
 
     connect(tab, SIGNAL(tabCloseRequested(int)),
             this, SLOT(bufferCloseRequested(int)));
+
+    connect(tab, SIGNAL(currentChanged(int)),
+            this, SLOT(currentPageChanged()));
+
+    ui->stepBackwardButton->setDefaultAction(ui->actionStepBackward);
+    ui->pauseButton->setDefaultAction(ui->actionPause);
+    ui->stepForwardButton->setDefaultAction(ui->actionStepForward);
+
+    connect(ui->timelineSlider, SIGNAL(valueChanged(int)),
+            this, SLOT(timelineValueChanged(int)));
+
+    // renderer signals are emitted in the middle of rendering, which may
+    // happen on GUI thread too, slots calling renderer must run after it
+    connect(renderer, SIGNAL(playbackFrameChanged(int)),
+            this, SLOT(playbackFrameChanged(int)), Qt::QueuedConnection);
+
+    connect(renderer, SIGNAL(bakeFailed(int,QString)),
+            this, SLOT(bakeFailed(int,QString)), Qt::QueuedConnection);
+    connect(renderer, SIGNAL(memoryUsageChanged(qint64,qint64)),
+            this, SLOT(memoryUsageChanged(qint64,qint64)), Qt::QueuedConnection);
+    connect(renderer, SIGNAL(memoryBudgetExceeded(int,QString)),
+            this, SLOT(memoryBudgetExceeded(int,QString)), Qt::QueuedConnection);
 }
 
 EditorPage* ShaderWorkshop::createPage(const QString &name, int pageIndex,
@@ -136,6 +414,14 @@ EditorPage* ShaderWorkshop::createPage(const QString &name, int pageIndex,
     pages[name] = page;
     pageIndices[page] = pageIndex;
 
+    symbolIndex->addDocument(pageIndex, page->document());
+    page->setCompletionModel(symbolIndex->completionModel());
+
+    connect(page, SIGNAL(definitionRequested(QString)),
+            this, SLOT(symbolDefinitionRequested(QString)));
+    connect(page, SIGNAL(usagesRequested(QString)),
+            this, SLOT(symbolUsagesRequested(QString)));
+
     return page;
 }
 
@@ -154,29 +440,119 @@ void ShaderWorkshop::createPages(const PagesData &data)
     for (const auto &item : data) {
         const QString &name = item.second;
 
-        createPage(name, item.first, data);
+        EditorPage *page = createPage(name, item.first, data);
+
+        page->setUpdatePolicyEnabled(true);
         comboBox->addItem(name);
     }
 }
 
+void ShaderWorkshop::createCommonPage()
+{
+    // shared code page has no input channels
+    commonPage = createPage(commonPageName, commonPageIndex, PagesData());
+    comboBox->addItem(commonPageName);
+}
+
 void ShaderWorkshop::createMenus()
 {
     QMenuBar *bar = new QMenuBar(this);
     QMenu *file = bar->addMenu(tr("&File"));
     QMenu *build = bar->addMenu(tr("&Build"));
+    QMenu *playback = bar->addMenu(tr("&Playback"));
+    QMenu *diagnostics = bar->addMenu(tr("&Diagnostics"));
     QMenu *about = bar->addMenu(tr("&Help"));
 
     file->addAction(ui->actionOpen);
     file->addAction(ui->actionSave);
+    file->addSeparator();
+    file->addAction(ui->actionOpenProject);
+    file->addAction(ui->actionSaveProject);
+    file->addSeparator();
+    file->addAction(ui->actionBrowseLibrary);
     build->addAction(ui->actionRecompile_Shader);
+    build->addSeparator();
+    build->addAction(ui->actionBakeParameters);
+    build->addAction(ui->actionAutoBake);
+    playback->addAction(ui->actionPause);
+    playback->addAction(ui->actionStepBackward);
+    playback->addAction(ui->actionStepForward);
+    playback->addSeparator();
+    playback->addAction(ui->actionFullScreen);
+    playback->addAction(ui->actionSpillHistory);
+
+    // fewer frames queued by driver lower input latency at throughput cost
+    QMenu *framesInFlight = playback->addMenu(tr("&Frames in Flight"));
+    QActionGroup *framesInFlightGroup = new QActionGroup(this);
+
+    for (int frames = 0; frames <= 3; frames++) {
+        QAction *action = framesInFlight->addAction(frames ? QString::number(frames)
+                                                           : tr("Driver Default"));
+
+        action->setCheckable(true);
+        action->setChecked(frames == 0);
+        action->setData(frames);
+        framesInFlightGroup->addAction(action);
+    }
+
+    connect(framesInFlightGroup, SIGNAL(triggered(QAction*)),
+            this, SLOT(framesInFlightTriggered(QAction*)));
+
+    // budget covers effect buffers, textures, programs and frame history
+    QMenu *memoryBudget = playback->addMenu(tr("GPU &Memory Budget"));
+    memoryBudgetGroup = new QActionGroup(this);
+
+    for (int megabytes : {0, 256, 512, 1024, 2048, 4096}) {
+        QAction *action = memoryBudget->addAction(megabytes ? tr("%1 MB").arg(megabytes)
+                                                            : tr("Unlimited"));
+
+        action->setCheckable(true);
+        action->setChecked(megabytes == 0);
+        action->setData(megabytes);
+        memoryBudgetGroup->addAction(action);
+    }
+
+    memoryBudget->addSeparator();
+    memoryPolicyGroup = new QActionGroup(this);
+
+    const QPair<GpuMemory::Policy, QString> policies[] = {
+        {GpuMemory::Warn, tr("&Warn")},
+        {GpuMemory::Refuse, tr("&Refuse Allocation")},
+        {GpuMemory::Downsize, tr("&Downsize Buffers")}
+    };
+
+    for (const auto &policy : policies) {
+        QAction *action = memoryBudget->addAction(policy.second);
+
+        action->setCheckable(true);
+        action->setChecked(policy.first == GpuMemory::Warn);
+        action->setData(policy.first);
+        memoryPolicyGroup->addAction(action);
+    }
+
+    connect(memoryBudgetGroup, SIGNAL(triggered(QAction*)),
+            this, SLOT(memoryBudgetTriggered()));
+    connect(memoryPolicyGroup, SIGNAL(triggered(QAction*)),
+            this, SLOT(memoryBudgetTriggered()));
+    diagnostics->addAction(ui->actionRecordTrace);
+    diagnostics->addAction(ui->actionExportTrace);
+    diagnostics->addSeparator();
+    diagnostics->addAction(ui->actionCostHeatmap);
+    diagnostics->addAction(ui->actionInputLatency);
+    diagnostics->addAction(ui->actionGpuMemory);
     about->addAction(ui->actionAbout);
 }
 
 QString ShaderWorkshop::bufferName(int index) const
 {
-    char letter = 'A' + index;
+    QString letters;
+
+    // bijective base 26, like spreadsheet columns
+    for (int i = index + 1; i > 0; i = (i - 1) / 26) {
+        letters.prepend(QChar('A' + (i - 1) % 26));
+    }
 
-    return QString("Buffer %1").arg(letter);
+    return QString("Buffer %1").arg(letters);
 }
 
 EditorPage* ShaderWorkshop::currentPage() const
@@ -191,6 +567,37 @@ int ShaderWorkshop::pageIndex(EditorPage *page) const
     return pageIndices.value(page);
 }
 
+EditorPage* ShaderWorkshop::openPage(int pageIndex) const
+{
+    EditorPage *page = pageIndices.key(pageIndex, Q_NULLPTR);
+
+    return page && tab->indexOf(page) >= 0 ? page : Q_NULLPTR;
+}
+
+void ShaderWorkshop::showSymbol(const Symbol &symbol)
+{
+    EditorPage *page = openPage(symbol.document);
+
+    Q_ASSERT(page != Q_NULLPTR);
+
+    tab->setCurrentWidget(page);
+    page->showLine(symbol.line);
+}
+
+void ShaderWorkshop::updateHeatmap()
+{
+    EditorPage *page = currentPage();
+    const bool enabled = ui->actionCostHeatmap->isChecked() && page && hasEffect(page);
+
+    if (!renderer->setHeatmapEffect(enabled ? pageIndex(page) : -1)) {
+        QMessageBox::warning(this, tr("Shader Workshop"),
+                             tr("Cost heatmap requires OpenGL timer queries, "
+                                "which are not supported by the driver"));
+
+        ui->actionCostHeatmap->setChecked(false);
+    }
+}
+
 void ShaderWorkshop::connectPage(EditorPage *page)
 {
     connect(page, SIGNAL(channelInputChanged(int,int,int)),
@@ -201,6 +608,21 @@ void ShaderWorkshop::connectPage(EditorPage *page)
 
     connect(page, SIGNAL(channelWrapChanged(int,int,GLint)),
             renderer, SLOT(effectWrapChanged(int,int,GLint)));
+
+    connect(page, SIGNAL(channelTextureChanged(int,int,QString)),
+            this, SLOT(channelTextureRequested(int,int,QString)));
+
+    connect(page, SIGNAL(channelAttachmentChanged(int,int,int)),
+            renderer, SLOT(effectAttachmentChanged(int,int,int)));
+
+    connect(page, SIGNAL(channelCountChanged(int,int)),
+            renderer, SLOT(effectChannelCountChanged(int,int)));
+
+    connect(page, SIGNAL(parameterChanged(int,QString,QVector4D)),
+            renderer, SLOT(effectParameterChanged(int,QString,QVector4D)));
+
+    connect(page, SIGNAL(updatePolicyChanged(int,int,int)),
+            renderer, SLOT(effectUpdatePolicyChanged(int,int,int)));
 }
 
 void ShaderWorkshop::disconnectPage(EditorPage *page)
@@ -213,16 +635,422 @@ void ShaderWorkshop::disconnectPage(EditorPage *page)
 
     disconnect(page, SIGNAL(channelWrapChanged(int,int,GLint)),
                renderer, SLOT(effectWrapChanged(int,int,GLint)));
+
+    disconnect(page, SIGNAL(channelTextureChanged(int,int,QString)),
+               this, SLOT(channelTextureRequested(int,int,QString)));
+
+    disconnect(page, SIGNAL(channelAttachmentChanged(int,int,int)),
+               renderer, SLOT(effectAttachmentChanged(int,int,int)));
+
+    disconnect(page, SIGNAL(channelCountChanged(int,int)),
+               renderer, SLOT(effectChannelCountChanged(int,int)));
+
+    disconnect(page, SIGNAL(parameterChanged(int,QString,QVector4D)),
+               renderer, SLOT(effectParameterChanged(int,QString,QVector4D)));
+
+    disconnect(page, SIGNAL(updatePolicyChanged(int,int,int)),
+               renderer, SLOT(effectUpdatePolicyChanged(int,int,int)));
+}
+
+QString ShaderWorkshop::pageName(EditorPage *page) const
+{
+    Q_ASSERT(pages.values().contains(page));
+
+    return pages.key(page);
+}
+
+void ShaderWorkshop::readProject(Project &project)
+{
+    project.driver = renderer->driverId();
+
+    // use a small frame of current state as project thumbnail
+    project.thumbnail = renderer->grabFramebuffer().scaled(256, 256, Qt::KeepAspectRatio,
+                                                           Qt::SmoothTransformation);
+
+    for (int i = 0; i < tab->count(); i++) {
+        EditorPage *page = static_cast<EditorPage*>(tab->widget(i));
+        const int index = pageIndex(page);
+        ProjectPage item;
+
+        item.name = pageName(page);
+        item.source = page->shaderSource();
+
+        if (!hasEffect(page)) {
+            project.pages.append(item);
+            continue;
+        }
+
+        item.bufferSize = renderer->effectBufferSize(index);
+        item.bufferFormat = renderer->effectBufferFormat(index);
+        item.updateMode = page->updateMode();
+        item.updateValue = page->updateValue();
+
+        for (const auto &parameter : page->parameters()) {
+            item.parameters.insert(parameter.name, parameter.value);
+        }
+
+        QString output;
+        QStringList includes;
+        QString error;
+
+        // binary is stored only if it was linked from current code
+        if (preprocessor.process(item.source, output, includes, error)
+                && renderer->effectProgramBinary(index, output, item.binaryFormat,
+                                                 item.binary)) {
+            item.binarySourceHash = Project::sourceHash(output);
+        }
+
+        for (int channelNumber = 0; channelNumber < page->channelCount(); channelNumber++) {
+            const ChannelSettings *settings = page->channelSettings(channelNumber);
+            const int inputPage = settings->inputPage();
+            ProjectChannel channel;
+
+            for (auto it = pageIndices.cbegin(); it != pageIndices.cend(); ++it) {
+                if (it.value() == inputPage) {
+                    channel.input = pageName(it.key());
+                    break;
+                }
+            }
+
+            channel.textureFile = settings->textureFile();
+            channel.filter = settings->filtering();
+            channel.wrap = settings->wrap();
+            channel.attachment = settings->attachment();
+
+            item.channels.append(channel);
+        }
+
+        project.pages.append(item);
+    }
+}
+
+QString ShaderWorkshop::applyProject(const Project &project)
+{
+    // close all buffers, main image page is always the first one
+    for (int i = tab->count() - 1; i > 0; i--) {
+        bufferCloseRequested(i);
+    }
+
+    // open all pages first, so shared code is available for compilation
+    for (const auto &item : project.pages) {
+        EditorPage *page = pages.value(item.name);
+
+        if (!page) {
+            continue;
+        }
+
+        if (page != imagePage) {
+            newBufferRequested(item.name);
+        }
+
+        page->setShaderSource(item.source);
+
+        if (hasEffect(page) && item.bufferSize.isValid() && item.bufferFormat) {
+            renderer->setEffectBuffer(pageIndex(page), item.bufferSize, item.bufferFormat);
+        }
+
+        if (page != imagePage && hasEffect(page)) {
+            page->setUpdatePolicy(item.updateMode, item.updateValue);
+        }
+    }
+
+    const bool binariesUsable = project.driver == renderer->driverId();
+    QList<EditorPage*> compilePages;
+
+    for (const auto &item : project.pages) {
+        EditorPage *page = pages.value(item.name);
+
+        if (!page || !hasEffect(page)) {
+            continue;
+        }
+
+        QString output;
+        QString error;
+
+        // skip compilation if binary was produced by the same driver
+        // from the same code
+        if (binariesUsable && preprocess(page, output, error)
+                && Project::sourceHash(output) == item.binarySourceHash
+                && renderer->loadEffectProgramBinary(pageIndex(page), output,
+                                                     item.binaryFormat, item.binary)) {
+            page->clearShaderLog();
+            updateParameters(page, output);
+        }
+        else {
+            compilePages.append(page);
+        }
+    }
+
+    const QString log = recompilePages(compilePages);
+
+    for (const auto &item : project.pages) {
+        EditorPage *page = pages.value(item.name);
+
+        if (page && hasEffect(page)) {
+            page->setParameterValues(item.parameters);
+        }
+    }
+
+    // connect channels only after all pages are created
+    for (const auto &item : project.pages) {
+        EditorPage *page = pages.value(item.name);
+
+        if (!page) {
+            continue;
+        }
+
+        if (hasEffect(page) && !item.channels.isEmpty()) {
+            page->setChannelCount(qMin(item.channels.size(), int(Effect::maxChannels)));
+        }
+
+        const int channels = qMin(page->channelCount(), item.channels.size());
+
+        for (int channelNumber = 0; channelNumber < channels; channelNumber++) {
+            const ProjectChannel &channel = item.channels[channelNumber];
+            ChannelSettings *settings = page->channelSettings(channelNumber);
+            EditorPage *inputPage = pages.value(channel.input);
+
+            settings->setFiltering(channel.filter);
+            settings->setWrap(channel.wrap);
+            settings->setAttachment(channel.attachment);
+
+            if (!channel.textureFile.isEmpty()) {
+                settings->setTextureFile(channel.textureFile);
+            }
+            else {
+                settings->setInputPage(inputPage ? pageIndex(inputPage) : -1);
+            }
+        }
+    }
+
+    tab->setCurrentIndex(0);
+
+    return log;
+}
+
+bool ShaderWorkshop::hasEffect(EditorPage *page) const
+{
+    return page != commonPage;
+}
+
+bool ShaderWorkshop::resolveInclude(const QString &name, QString &contents) const
+{
+    if (name == commonPageName) {
+        // shared code page can be used only while it is open
+        if (tab->indexOf(commonPage) < 0) {
+            return false;
+        }
+
+        contents = commonPage->shaderSource();
+        return true;
+    }
+
+    QFile file(QDir(includeDirectory).absoluteFilePath(name));
+
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        return false;
+    }
+
+    contents = QString::fromUtf8(file.readAll());
+    return true;
+}
+
+bool ShaderWorkshop::preprocess(EditorPage *page, QString &output, QString &error)
+{
+    QStringList includes;
+
+    if (!preprocessor.process(page->shaderSource(), output, includes, error)) {
+        page->shaderLogUpdated(error);
+        return false;
+    }
+
+    updateDependencies(page, includes);
+
+    return true;
+}
+
+void ShaderWorkshop::updateDependencies(EditorPage *page, const QStringList &includes)
+{
+    for (auto &users : includeUsers) {
+        users.remove(page);
+    }
+
+    for (const auto &name : includes) {
+        includeUsers[name].insert(page);
+    }
+}
+
+QList<EditorPage*> ShaderWorkshop::commonPageUsers()
+{
+    QList<EditorPage*> users;
+
+    for (int i = 0; i < tab->count(); i++) {
+        EditorPage *page = static_cast<EditorPage*>(tab->widget(i));
+        QStringList includes;
+        QString output;
+        QString error;
+
+        if (!hasEffect(page)) {
+            continue;
+        }
+
+        if (!preprocessor.process(page->shaderSource(), output, includes, error)) {
+            // recompile to show error, a missing include may be from shared code
+            users.append(page);
+            continue;
+        }
+
+        updateDependencies(page, includes);
+    }
+
+    // failed page may still be remembered as user from earlier compilation
+    for (EditorPage *page : includeUsers.value(commonPageName)) {
+        if (!users.contains(page)) {
+            users.append(page);
+        }
+    }
+
+    return users;
+}
+
+QString ShaderWorkshop::recompilePages(const QList<EditorPage*> &list)
+{
+    TRACE_SCOPE("recompilePages", "ui");
+
+    QHash<int, QString> sources;
+    QString failedLogs;
+
+    for (EditorPage *page : list) {
+        QString output;
+        QString error;
+
+        if (preprocess(page, output, error)) {
+            sources.insert(pageIndex(page), output);
+        }
+        else {
+            failedLogs += QString("%1: %2\n").arg(pageName(page)).arg(error);
+        }
+    }
+
+    if (sources.isEmpty()) {
+        return failedLogs;
+    }
+
+    const QHash<int, QString> logs = renderer->recompileEffectShaders(sources);
+
+    for (EditorPage *page : list) {
+        const int index = pageIndex(page);
+
+        if (!logs.contains(index)) {
+            continue;
+        }
+
+        const QString &log = logs.value(index);
+
+        page->shaderLogUpdated(log);
+
+        // parameters of failed source are ignored, fallback is still running
+        if (log.isEmpty()) {
+            updateParameters(page, sources.value(index));
+        }
+        else {
+            failedLogs += QString("%1: %2").arg(pageName(page)).arg(log);
+        }
+    }
+
+    return failedLogs;
+}
+
+void ShaderWorkshop::updateParameters(EditorPage *page, const QString &source)
+{
+    page->setParameters(ShaderParameter::parse(source));
+
+    renderer->setEffectParameters(pageIndex(page), page->parameters());
 }
 
 void ShaderWorkshop::on_actionRecompile_Shader_triggered()
 {
     EditorPage *page = currentPage();
-    const QString source = page->shaderSource();
 
-    QString log = renderer->recompileEffectShader(pageIndex(page), source);
+    if (!hasEffect(page)) {
+        // recompile only buffers using shared code
+        recompilePages(commonPageUsers());
+        return;
+    }
 
-    page->shaderLogUpdated(log);
+    recompilePages(QList<EditorPage*>() << page);
+}
+
+void ShaderWorkshop::on_actionBakeParameters_triggered()
+{
+    EditorPage *page = currentPage();
+
+    if (hasEffect(page)) {
+        renderer->bakeEffectParameters(pageIndex(page));
+    }
+}
+
+void ShaderWorkshop::on_actionAutoBake_toggled(bool checked)
+{
+    renderer->setAutoBake(checked);
+}
+
+void ShaderWorkshop::on_actionPause_toggled(bool checked)
+{
+    renderer->setPaused(checked);
+}
+
+void ShaderWorkshop::on_actionStepBackward_triggered()
+{
+    renderer->stepFrame(-1);
+}
+
+void ShaderWorkshop::on_actionStepForward_triggered()
+{
+    renderer->stepFrame(1);
+}
+
+void ShaderWorkshop::on_actionSpillHistory_toggled(bool checked)
+{
+    renderer->setHistorySpill(checked);
+}
+
+void ShaderWorkshop::on_actionFullScreen_toggled(bool checked)
+{
+    if (!checked) {
+        renderer->setPresenter(Q_NULLPTR);
+
+        // may be called from window event handler
+        presenterWindow->deleteLater();
+        presenterWindow = Q_NULLPTR;
+        return;
+    }
+
+    QScreen *editorScreen = window()->windowHandle() ? window()->windowHandle()->screen()
+                                                     : QGuiApplication::primaryScreen();
+    QScreen *screen = editorScreen;
+
+    // keep editor visible when there is a projector or second display
+    for (QScreen *other : QGuiApplication::screens()) {
+        if (other != editorScreen) {
+            screen = other;
+            break;
+        }
+    }
+
+    presenterWindow = new PresenterWindow(renderer->format(), screen);
+    presenterWindow->setGeometry(screen->geometry());
+    presenterWindow->showFullScreen();
+
+    connect(presenterWindow, SIGNAL(closeRequested()),
+            this, SLOT(presenterCloseRequested()));
+
+    renderer->setPresenter(presenterWindow);
+}
+
+void ShaderWorkshop::presenterCloseRequested()
+{
+    ui->actionFullScreen->setChecked(false);
 }
 
 void ShaderWorkshop::on_actionOpen_triggered()
@@ -230,9 +1058,14 @@ void ShaderWorkshop::on_actionOpen_triggered()
     QString fileName = QFileDialog::getOpenFileName(this, tr("Open Shader"), "",
                         tr("GLSL Fragment shader (*.frag);; Text file (*.txt)"));
 
-    if (fileName.isEmpty()) {
-        return;
+    if (!fileName.isEmpty()) {
+        openShader(fileName);
     }
+}
+
+void ShaderWorkshop::openShader(const QString &fileName)
+{
+    TRACE_SCOPE("openShader", "ui");
 
     QFile file(fileName);
 
@@ -244,6 +1077,10 @@ void ShaderWorkshop::on_actionOpen_triggered()
         return;
     }
 
+    includeDirectory = QFileInfo(fileName).absolutePath();
+
+    // reading is fast even for large files, inserting them into editor is not,
+    // so only the editor appends source in chunks
     currentPage()->setShaderSource(file.readAll());
 }
 
@@ -262,6 +1099,8 @@ void ShaderWorkshop::on_actionSave_triggered()
         return;
     }
 
+    TRACE_SCOPE("saveShader", "ui");
+
     QFile file(fileName);
 
     if (!file.open(QFile::WriteOnly | QFile::Text)) {
@@ -272,11 +1111,186 @@ void ShaderWorkshop::on_actionSave_triggered()
         return;
     }
 
+    includeDirectory = QFileInfo(fileName).absolutePath();
+
     QTextStream out(&file);
 
     out << page->shaderSource();
 }
 
+void ShaderWorkshop::on_actionOpenProject_triggered()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open Project"), "",
+                        tr("ShaderWorkshop project (*.swproj)"));
+
+    if (!fileName.isEmpty()) {
+        openProject(fileName);
+    }
+}
+
+void ShaderWorkshop::openProject(const QString &fileName)
+{
+    TRACE_SCOPE("openProject", "ui");
+
+    Project project;
+    QString error;
+
+    if (!project.load(fileName, error)) {
+        QMessageBox::critical(this, tr("Error"),
+                              tr("Could not open project %1:\n%2")
+                                .arg(fileName)
+                                .arg(error));
+        return;
+    }
+
+    includeDirectory = QFileInfo(fileName).absolutePath();
+
+    applyProject(project);
+}
+
+void ShaderWorkshop::on_actionSaveProject_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Project"), "",
+                        tr("ShaderWorkshop project (*.swproj)"));
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    TRACE_SCOPE("saveProject", "ui");
+
+    Project project;
+    QString error;
+
+    readProject(project);
+
+    if (!project.save(fileName, error)) {
+        QMessageBox::warning(this, tr("Shader Workshop"),
+                             tr("Could not write project %1:\n%2")
+                                .arg(fileName)
+                                .arg(error));
+    }
+}
+
+void ShaderWorkshop::on_actionBrowseLibrary_triggered()
+{
+    if (!libraryBrowser) {
+        libraryBrowser = new LibraryBrowser(this);
+
+        connect(libraryBrowser, SIGNAL(shaderOpenRequested(QString)),
+                this, SLOT(openShader(QString)));
+        connect(libraryBrowser, SIGNAL(projectOpenRequested(QString)),
+                this, SLOT(openProject(QString)));
+    }
+
+    libraryBrowser->show();
+    libraryBrowser->raise();
+    libraryBrowser->activateWindow();
+}
+
+void ShaderWorkshop::on_actionRecordTrace_toggled(bool checked)
+{
+    Tracer::instance().setEnabled(checked);
+}
+
+void ShaderWorkshop::on_actionExportTrace_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Trace"), "",
+                        tr("Chrome trace (*.json)"));
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QString error;
+
+    if (!Tracer::instance().exportJson(fileName, error)) {
+        QMessageBox::warning(this, tr("Shader Workshop"),
+                             tr("Could not write trace %1:\n%2")
+                                .arg(fileName)
+                                .arg(error));
+    }
+}
+
+void ShaderWorkshop::on_actionCostHeatmap_toggled(bool checked)
+{
+    Q_UNUSED(checked);
+
+    updateHeatmap();
+}
+
+void ShaderWorkshop::on_actionInputLatency_triggered()
+{
+    const QVector<qint64> latencies = renderer->inputLatencyPercentiles({50, 90, 99});
+
+    if (latencies.isEmpty()) {
+        QMessageBox::information(this, tr("Input Latency"),
+                                 tr("Move mouse over preview with left button "
+                                    "pressed to measure input latency"));
+        return;
+    }
+
+    const QString text = tr("Time from mouse event to presenting frame that used it, "
+                            "last %1 events:\n\n"
+                            "50%: %2 ms\n90%: %3 ms\n99%: %4 ms")
+            .arg(renderer->inputLatencySamples())
+            .arg(latencies[0] / 1000.0, 0, 'f', 1)
+            .arg(latencies[1] / 1000.0, 0, 'f', 1)
+            .arg(latencies[2] / 1000.0, 0, 'f', 1);
+
+    const auto button = QMessageBox::information(this, tr("Input Latency"), text,
+                                                 QMessageBox::Ok | QMessageBox::Reset);
+
+    if (button == QMessageBox::Reset) {
+        renderer->resetInputLatency();
+    }
+}
+
+void ShaderWorkshop::on_actionGpuMemory_triggered()
+{
+    const GpuMemoryUsage usage = renderer->memoryUsage();
+    const double megabyte = 1024.0 * 1024.0;
+    QStringList lines;
+
+    for (auto it = usage.owners.cbegin(); it != usage.owners.cend(); ++it) {
+        const QVector<qint64> &bytes = it.value();
+        QString name;
+
+        if (it.key() == GpuMemory::historyOwner) {
+            name = tr("Frame history");
+        }
+        else if (it.key() == GpuMemory::outputOwner) {
+            name = tr("Preview frames");
+        }
+        else if (EditorPage *page = pageIndices.key(it.key(), Q_NULLPTR)) {
+            name = pageName(page);
+        }
+
+        lines.append(tr("%1: buffers %2 MB, textures %3 MB, programs %4 MB")
+                     .arg(name)
+                     .arg(bytes[GpuMemory::Framebuffers] / megabyte, 0, 'f', 1)
+                     .arg(bytes[GpuMemory::Textures] / megabyte, 0, 'f', 1)
+                     .arg(bytes[GpuMemory::Programs] / megabyte, 0, 'f', 1));
+    }
+
+    lines.append(QString());
+    lines.append(usage.budget > 0 ? tr("Total: %1 MB of %2 MB budget")
+                                    .arg(usage.total / megabyte, 0, 'f', 1)
+                                    .arg(usage.budget / megabyte, 0, 'f', 0)
+                                  : tr("Total: %1 MB").arg(usage.total / megabyte, 0, 'f', 1));
+
+    if (usage.driverTotal >= 0) {
+        lines.append(tr("Video memory: %1 MB").arg(usage.driverTotal / megabyte, 0, 'f', 0));
+    }
+
+    if (usage.driverAvailable >= 0) {
+        lines.append(tr("Available video memory: %1 MB")
+                     .arg(usage.driverAvailable / megabyte, 0, 'f', 0));
+    }
+
+    QMessageBox::information(this, tr("GPU Memory"), lines.join('\n'));
+}
+
 void ShaderWorkshop::on_actionAbout_triggered()
 {
     const QString text{
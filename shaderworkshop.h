@@ -23,7 +23,11 @@
 #include <QTabWidget>
 #include <QComboBox>
 #include <QHash>
+#include <QSet>
+#include <QImage>
 #include "editorpage.h"
+#include "shaderpreprocessor.h"
+#include "symbolindex.h"
 
 namespace Ui {
 class ShaderWorkshop;
@@ -31,6 +35,10 @@ class ShaderWorkshop;
 
 class EditorPage;
 class Renderer;
+class Project;
+class PresenterWindow;
+class LibraryBrowser;
+class QActionGroup;
 
 class ShaderWorkshop : public QWidget
 {
@@ -40,19 +48,71 @@ public:
     explicit ShaderWorkshop(QWidget *parent = 0);
     ~ShaderWorkshop();
 
+    /// open shader or project file and capture its main image at ascending
+    /// times, for golden image tests. Editor must have been painted once.
+    /// Scene fails if any of its pages does not compile
+    bool captureFrames(const QString &fileName, const QVector<GLfloat> &times, QSize size,
+                       QVector<QImage> &images, QString &error);
+
 protected:
     virtual void paintEvent(QPaintEvent *event);
 
 private slots:
     void newBufferRequested(const QString &name);
     void bufferCloseRequested(int tabIndex);
+    void channelTextureRequested(int pageIndex, int channel, const QString &fileName);
+    void symbolDefinitionRequested(const QString &name);
+    void symbolUsagesRequested(const QString &name);
+    void symbolUsagesFound(const QString &name, const QVector<Symbol> &usages);
+    void currentPageChanged();
+    void playbackFrameChanged(int frame);
+    void timelineValueChanged(int value);
+    void framesInFlightTriggered(QAction *action);
+    /// pass checked budget and policy of GPU memory menu to renderer
+    void memoryBudgetTriggered();
+    void memoryUsageChanged(qint64 total, qint64 budget);
+    void bakeFailed(int index, const QString &log);
+    void memoryBudgetExceeded(int index, const QString &message);
+    void presenterCloseRequested();
+    void openShader(const QString &fileName);
+    void openProject(const QString &fileName);
 
     void on_actionRecompile_Shader_triggered();
 
+    void on_actionBakeParameters_triggered();
+
+    void on_actionAutoBake_toggled(bool checked);
+
+    void on_actionPause_toggled(bool checked);
+
+    void on_actionStepBackward_triggered();
+
+    void on_actionStepForward_triggered();
+
+    void on_actionSpillHistory_toggled(bool checked);
+
+    void on_actionFullScreen_toggled(bool checked);
+
     void on_actionOpen_triggered();
 
     void on_actionSave_triggered();
 
+    void on_actionOpenProject_triggered();
+
+    void on_actionSaveProject_triggered();
+
+    void on_actionBrowseLibrary_triggered();
+
+    void on_actionRecordTrace_toggled(bool checked);
+
+    void on_actionExportTrace_triggered();
+
+    void on_actionCostHeatmap_toggled(bool checked);
+
+    void on_actionInputLatency_triggered();
+
+    void on_actionGpuMemory_triggered();
+
     void on_actionAbout_triggered();
 
 private:
@@ -60,24 +120,70 @@ private:
     EditorPage* createPage(const QString &name, int pageIndex, const PagesData &data);
     void createImagePage(const PagesData &data);
     void createPages(const PagesData &data);
+    void createCommonPage();
     void createMenus();
+    /// 'Buffer A' to 'Buffer Z', then 'Buffer AA' and so on
     QString bufferName(int index) const;
     EditorPage* currentPage() const;
     int pageIndex(EditorPage *page) const;
+    /// open page with specified index, Q_NULLPTR if page is closed
+    EditorPage* openPage(int pageIndex) const;
+    void showSymbol(const Symbol &symbol);
+    /// measure cost heatmap of current page, if enabled
+    void updateHeatmap();
     void connectPage(EditorPage *page);
     void disconnectPage(EditorPage *page);
+    /// name page is registered with, not translated
+    QString pageName(EditorPage *page) const;
+    void readProject(Project &project);
+    /// returns logs of pages that failed to compile, empty if all did
+    QString applyProject(const Project &project);
+    /// true if page has renderer effect, shared code page does not
+    bool hasEffect(EditorPage *page) const;
+    /// find contents of shared code page or include file
+    bool resolveInclude(const QString &name, QString &contents) const;
+    /// expand includes of page source and remember its dependencies.
+    /// Errors are shown in page log
+    bool preprocess(EditorPage *page, QString &output, QString &error);
+    void updateDependencies(EditorPage *page, const QStringList &includes);
+    /// effect pages using shared code page, found from current source of every
+    /// page since pages never compiled yet have no dependencies remembered
+    QList<EditorPage*> commonPageUsers();
+    /// returns logs of failed pages prefixed by their names
+    QString recompilePages(const QList<EditorPage*> &list);
+    /// show user parameters of compiled source and pass them to renderer
+    void updateParameters(EditorPage *page, const QString &source);
 
     Ui::ShaderWorkshop *ui;
     Renderer *renderer;
+    /// full screen window frames are presented to, if any
+    PresenterWindow *presenterWindow;
+    /// created when first shown
+    LibraryBrowser *libraryBrowser;
+    /// GPU memory budget sizes in megabytes and budget policies
+    QActionGroup *memoryBudgetGroup;
+    QActionGroup *memoryPolicyGroup;
+    /// symbols of all pages for completion and navigation
+    SymbolIndex *symbolIndex;
     QTabWidget *tab;
     QComboBox *comboBox;
     EditorPage *imagePage;
+    /// page with code shared between buffers through '#include "Common"'
+    EditorPage *commonPage;
     QHash<QString, EditorPage*> pages;
     /// indices for renderer effects management
     QHash<EditorPage*, int> pageIndices;
+    /// pages using each include, directly or through other includes
+    QHash<QString, QSet<EditorPage*>> includeUsers;
+    ShaderPreprocessor preprocessor;
+    /// include files are searched relative to last opened file
+    QString includeDirectory;
     const QString defaultItemName;
+    const QString commonPageName;
+    /// main image page and buffer pages
     const int maxBufferPages;
     const int imagePageIndex;
+    const int commonPageIndex;
     bool imageEffectCreated;
 };
 
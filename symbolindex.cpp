@@ -0,0 +1,329 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "symbolindex.h"
+#include "glslhighlighter.h"
+#include "tracer.h"
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QStringListModel>
+#include <QRegularExpression>
+
+namespace {
+
+bool isIdentifierChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+
+/// line text without single-line comment
+QString stripComment(const QString &text)
+{
+    const int comment = text.indexOf(QLatin1String("//"));
+
+    return comment < 0 ? text : text.left(comment);
+}
+
+} // namespace
+
+SymbolIndex::SymbolIndex(QObject *parent) :
+    QObject(parent),
+    worker(new SymbolIndexWorker()),
+    model(new QStringListModel(this)),
+    builtins(GLSLHighlighter::builtinWords())
+{
+    qRegisterMetaType<QVector<Symbol>>("QVector<Symbol>");
+
+    builtins.sort();
+    model->setStringList(builtins);
+
+    worker->moveToThread(&thread);
+
+    connect(worker, &SymbolIndexWorker::definitionsChanged,
+            this, &SymbolIndex::updateDefinitions);
+    connect(worker, &SymbolIndexWorker::usagesFound, this, &SymbolIndex::usagesFound);
+
+    thread.setObjectName("Symbol index");
+    thread.start();
+}
+
+SymbolIndex::~SymbolIndex()
+{
+    thread.quit();
+    thread.wait();
+
+    delete worker;
+}
+
+void SymbolIndex::addDocument(int id, QTextDocument *document)
+{
+    Q_ASSERT(!documents.contains(document));
+
+    documents.insert(document, id);
+    blockCounts.insert(document, document->blockCount());
+
+    sendLines(id, document, 0, document->blockCount() - 1, 0);
+
+    connect(document, SIGNAL(contentsChange(int,int,int)),
+            this, SLOT(documentChanged(int,int,int)));
+}
+
+QStringListModel* SymbolIndex::completionModel() const
+{
+    return model;
+}
+
+QVector<Symbol> SymbolIndex::definitions(const QString &name) const
+{
+    return symbols.value(name);
+}
+
+void SymbolIndex::findUsages(const QString &name)
+{
+    QMetaObject::invokeMethod(worker, "findUsages", Qt::QueuedConnection,
+                              Q_ARG(QString, name));
+}
+
+void SymbolIndex::documentChanged(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+
+    QTextDocument *document = qobject_cast<QTextDocument*>(sender());
+
+    Q_ASSERT(documents.contains(document));
+
+    QTextBlock firstBlock = document->findBlock(position);
+    QTextBlock lastBlock = document->findBlock(position + charsAdded);
+
+    if (!firstBlock.isValid()) {
+        firstBlock = document->lastBlock();
+    }
+
+    if (!lastBlock.isValid()) {
+        lastBlock = document->lastBlock();
+    }
+
+    const int first = firstBlock.blockNumber();
+    const int last = lastBlock.blockNumber();
+    const int blockCount = document->blockCount();
+    // lines from first to last replace this many old lines
+    const int removed = last - first + 1 - (blockCount - blockCounts.value(document));
+
+    blockCounts[document] = blockCount;
+
+    sendLines(documents.value(document), document, first, last, removed);
+}
+
+void SymbolIndex::updateDefinitions(const QVector<Symbol> &definitions)
+{
+    symbols.clear();
+
+    for (const auto &symbol : definitions) {
+        symbols[symbol.name].append(symbol);
+    }
+
+    QStringList words = builtins + symbols.keys();
+
+    words.sort();
+    words.removeDuplicates();
+
+    if (words != model->stringList()) {
+        model->setStringList(words);
+    }
+}
+
+void SymbolIndex::sendLines(int id, QTextDocument *document, int first, int last,
+                            int removed)
+{
+    QStringList texts;
+    QTextBlock block = document->findBlockByNumber(first);
+
+    for (int i = first; i <= last && block.isValid(); i++, block = block.next()) {
+        texts.append(block.text());
+    }
+
+    QMetaObject::invokeMethod(worker, "replaceLines", Qt::QueuedConnection,
+                              Q_ARG(int, id), Q_ARG(int, first), Q_ARG(int, removed),
+                              Q_ARG(QStringList, texts));
+}
+
+SymbolIndexWorker::SymbolIndexWorker(QObject *parent) :
+    QObject(parent),
+    publishPending(false)
+{
+}
+
+void SymbolIndexWorker::replaceLines(int document, int first, int removed,
+                                     const QStringList &texts)
+{
+    TRACE_SCOPE("indexLines", "editor");
+
+    QVector<Line> &lines = documents[document];
+
+    first = qBound(0, first, lines.size());
+    removed = qBound(0, removed, lines.size() - first);
+
+    const int replaced = qMin(removed, texts.size());
+    bool changed = false;
+
+    // text formatting changes are reported as edits too,
+    // lines with the same text are not parsed again
+    for (int i = 0; i < replaced; i++) {
+        Line &line = lines[first + i];
+
+        if (line.text != texts[i]) {
+            parseLine(texts[i], line);
+            changed = true;
+        }
+    }
+
+    if (removed > replaced) {
+        lines.remove(first + replaced, removed - replaced);
+        changed = true;
+    }
+    else if (texts.size() > replaced) {
+        lines.insert(first + replaced, texts.size() - replaced, Line());
+
+        for (int i = replaced; i < texts.size(); i++) {
+            parseLine(texts[i], lines[first + i]);
+        }
+
+        changed = true;
+    }
+
+    if (changed && !publishPending) {
+        publishPending = true;
+        QMetaObject::invokeMethod(this, "publishDefinitions", Qt::QueuedConnection);
+    }
+}
+
+void SymbolIndexWorker::findUsages(const QString &name)
+{
+    QVector<Symbol> usages;
+
+    for (auto it = documents.cbegin(); it != documents.cend(); ++it) {
+        const QVector<Line> &lines = it.value();
+
+        for (int i = 0; i < lines.size(); i++) {
+            const QString text = stripComment(lines[i].text);
+            int column = text.indexOf(name);
+
+            while (column >= 0) {
+                const int end = column + name.size();
+                const bool whole = (column == 0 || !isIdentifierChar(text[column - 1]))
+                        && (end == text.size() || !isIdentifierChar(text[end]));
+
+                if (whole) {
+                    Symbol usage;
+
+                    usage.name = name;
+                    usage.document = it.key();
+                    usage.line = i + 1;
+                    usage.column = column;
+
+                    usages.append(usage);
+                }
+
+                column = text.indexOf(name, end);
+            }
+        }
+    }
+
+    emit usagesFound(name, usages);
+}
+
+void SymbolIndexWorker::publishDefinitions()
+{
+    publishPending = false;
+
+    QVector<Symbol> definitions;
+
+    for (auto it = documents.cbegin(); it != documents.cend(); ++it) {
+        const QVector<Line> &lines = it.value();
+
+        for (int i = 0; i < lines.size(); i++) {
+            for (Symbol symbol : lines[i].definitions) {
+                symbol.document = it.key();
+                symbol.line = i + 1;
+
+                definitions.append(symbol);
+            }
+        }
+    }
+
+    emit definitionsChanged(definitions);
+}
+
+void SymbolIndexWorker::parseLine(const QString &text, Line &line) const
+{
+    static const QRegularExpression macro("^\\s*#\\s*define\\s+(\\w+)");
+    static const QRegularExpression structure("\\bstruct\\s+(\\w+)");
+    static const QRegularExpression uniform("\\buniform\\s+\\w+\\s+(\\w+)");
+    // return type, name and opening parenthesis, prototypes are skipped
+    static const QRegularExpression function(
+                "^\\s*(?:(?:highp|mediump|lowp|precise|invariant)\\s+)?"
+                "(\\w+)\\s+(\\w+)\\s*\\((?![^{]*\\)\\s*;)");
+    static const QStringList statements{"return", "else", "case", "const"};
+
+    line.text = text;
+    line.definitions.clear();
+
+    const QString code = stripComment(text);
+
+    if (!code.contains(QLatin1String("define")) && !code.contains('(')
+            && !code.contains(QLatin1String("struct"))
+            && !code.contains(QLatin1String("uniform"))) {
+        // nothing to define, skip matching
+        return;
+    }
+
+    auto add = [&line](const QRegularExpressionMatch &match, int group, Symbol::Kind kind) {
+        Symbol symbol;
+
+        symbol.name = match.captured(group);
+        symbol.kind = kind;
+        symbol.column = match.capturedStart(group);
+
+        line.definitions.append(symbol);
+    };
+
+    QRegularExpressionMatch match = macro.match(code);
+
+    if (match.hasMatch()) {
+        add(match, 1, Symbol::Macro);
+        return;
+    }
+
+    match = structure.match(code);
+
+    if (match.hasMatch()) {
+        add(match, 1, Symbol::Struct);
+    }
+
+    match = uniform.match(code);
+
+    if (match.hasMatch()) {
+        add(match, 1, Symbol::Uniform);
+    }
+
+    match = function.match(code);
+
+    if (match.hasMatch() && !statements.contains(match.captured(1))) {
+        add(match, 2, Symbol::Function);
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include <QObject>
+#include <QThread>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QMetaType>
+
+class QTextDocument;
+class QStringListModel;
+class SymbolIndexWorker;
+
+/// symbol definition or usage location
+struct Symbol
+{
+    enum Kind
+    {
+        Usage,
+        Function,
+        Struct,
+        Macro,
+        Uniform
+    };
+
+    Symbol() :
+        kind(Usage),
+        document(-1),
+        line(0),
+        column(0)
+    {
+    }
+
+    QString name;
+    Kind kind;
+    /// id document was registered with
+    int document;
+    /// line number starting from 1
+    int line;
+    int column;
+};
+
+Q_DECLARE_METATYPE(Symbol)
+
+/// Index of user-defined functions, structs, macros and uniforms
+/// of several documents. Documents are parsed on a worker thread line by line,
+/// edits send only changed lines, so indexing never blocks typing
+class SymbolIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SymbolIndex(QObject *parent = Q_NULLPTR);
+    ~SymbolIndex();
+
+    /// index document and track its changes, id is reported in symbol locations
+    void addDocument(int id, QTextDocument *document);
+
+    /// sorted GLSL built-in and user-defined names for completion
+    QStringListModel* completionModel() const;
+    /// definitions of symbol with specified name, as of last update
+    QVector<Symbol> definitions(const QString &name) const;
+    /// search symbol usages in background, result is reported by usagesFound()
+    void findUsages(const QString &name);
+
+signals:
+    void usagesFound(const QString &name, const QVector<Symbol> &usages);
+
+private slots:
+    void documentChanged(int position, int charsRemoved, int charsAdded);
+    void updateDefinitions(const QVector<Symbol> &symbols);
+
+private:
+    void sendLines(int id, QTextDocument *document, int first, int last, int removed);
+
+    QThread thread;
+    SymbolIndexWorker *worker;
+    QStringListModel *model;
+    QStringList builtins;
+    /// registered documents and their ids
+    QHash<QTextDocument*, int> documents;
+    /// document block count known to worker
+    QHash<QTextDocument*, int> blockCounts;
+    /// user-defined symbols by name
+    QHash<QString, QVector<Symbol>> symbols;
+};
+
+class SymbolIndexWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SymbolIndexWorker(QObject *parent = Q_NULLPTR);
+
+public slots:
+    /// replace removed lines of document starting at first with new ones
+    void replaceLines(int document, int first, int removed, const QStringList &texts);
+    void findUsages(const QString &name);
+
+signals:
+    void definitionsChanged(const QVector<Symbol> &symbols);
+    void usagesFound(const QString &name, const QVector<Symbol> &usages);
+
+private slots:
+    /// report definitions once all queued edits are applied
+    void publishDefinitions();
+
+private:
+    struct Line
+    {
+        QString text;
+        /// definitions without line number
+        QVector<Symbol> definitions;
+    };
+
+    void parseLine(const QString &text, Line &line) const;
+
+    QHash<int, QVector<Line>> documents;
+    bool publishPending;
+};
+
+#endif // SYMBOLINDEX_H
@@ -0,0 +1,23 @@
+QT       += core gui testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_batchvalidator
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_batchvalidator.cpp \
+    ../../batchvalidator.cpp \
+    ../../shaderpreprocessor.cpp \
+    ../../shaderlog.cpp \
+    ../../tracer.cpp \
+    ../../glshader.cpp \
+    ../../offscreenworker.cpp
+
+HEADERS += ../../batchvalidator.h \
+    ../../shaderpreprocessor.h \
+    ../../shaderlog.h \
+    ../../tracer.h \
+    ../../glshader.h \
+    ../../offscreenworker.h
@@ -0,0 +1,206 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "batchvalidator.h"
+#include <QtTest>
+#include <QGuiApplication>
+#include <QSurfaceFormat>
+#include <QTemporaryDir>
+#include <QJsonArray>
+
+namespace {
+
+const char *const validSource =
+    "#version 330 core\n"
+    "out vec4 fragColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "    fragColor = vec4(1.0);\n"
+    "}\n";
+
+const char *const includingSource =
+    "#version 330 core\n"
+    "#include \"common.glsl\"\n"
+    "out vec4 fragColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "    fragColor = shade();\n"
+    "}\n";
+
+const char *const includedSource =
+    "vec4 shade()\n"
+    "{\n"
+    "    return vec4(0.5);\n"
+    "}\n";
+
+const char *const brokenSource =
+    "#version 330 core\n"
+    "out vec4 fragColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "    fragColor = undeclared;\n"
+    "}\n";
+
+const char *const missingIncludeSource =
+    "#version 330 core\n"
+    "#include \"nothing.glsl\"\n";
+
+} // namespace
+
+/// Shader discovery, results of valid and failing shaders on one and
+/// several threads, and their report
+class BatchValidatorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void findShaders();
+    void validate_data();
+    void validate();
+    void reportSources();
+
+private:
+    /// false if file could not be written
+    bool writeFile(const QString &name, const char *contents);
+
+    QTemporaryDir directory;
+};
+
+void BatchValidatorTest::initTestCase()
+{
+    QVERIFY(directory.isValid());
+    QVERIFY(QDir(directory.path()).mkdir("sub"));
+
+    QVERIFY(writeFile("valid.frag", validSource));
+    QVERIFY(writeFile("sub/including.frag", includingSource));
+    QVERIFY(writeFile("sub/common.glsl", includedSource));
+    QVERIFY(writeFile("broken.frag", brokenSource));
+    QVERIFY(writeFile("missing.frag", missingIncludeSource));
+    QVERIFY(writeFile("notes.txt", "not a shader"));
+}
+
+void BatchValidatorTest::findShaders()
+{
+    const QDir root(directory.path());
+    QStringList names;
+
+    for (const QString &file : BatchValidator::findShaders(directory.path())) {
+        names.append(root.relativeFilePath(file));
+    }
+
+    QCOMPARE(names, QStringList() << "broken.frag" << "missing.frag"
+                                  << "sub/including.frag" << "valid.frag");
+}
+
+void BatchValidatorTest::validate_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("single thread") << 1;
+    QTest::newRow("4 threads") << 4;
+}
+
+void BatchValidatorTest::validate()
+{
+    QFETCH(int, threads);
+
+    BatchValidator validator(threads);
+    const QStringList files = BatchValidator::findShaders(directory.path());
+    const QVector<BatchValidator::Result> results = validator.validate(files);
+
+    QCOMPARE(results.size(), files.size());
+
+    for (int i = 0; i < files.size(); i++) {
+        QCOMPARE(results[i].fileName, files[i]);
+    }
+
+    const BatchValidator::Result &broken = results[0];
+    const BatchValidator::Result &missing = results[1];
+
+    QVERIFY(!broken.success);
+    QVERIFY(broken.error.isEmpty());
+    QVERIFY(!broken.messages.isEmpty());
+
+    // include errors are reported before compilation
+    QVERIFY(!missing.success);
+    QVERIFY(!missing.error.isEmpty());
+    QVERIFY(missing.messages.isEmpty());
+
+    QVERIFY2(results[2].success, qPrintable(results[2].error));
+    QVERIFY2(results[3].success, qPrintable(results[3].error));
+
+    // includes are numbered in order they are found
+    QCOMPARE(results[2].sources, QStringList() << files[2]
+             << QDir(directory.path()).filePath("sub/common.glsl"));
+    QCOMPARE(results[3].sources, QStringList() << files[3]);
+
+    const QJsonObject report = validator.report(results, 0);
+
+    QCOMPARE(report["total"].toInt(), 4);
+    QCOMPARE(report["failed"].toInt(), 2);
+    QCOMPARE(report["threads"].toInt(), threads);
+}
+
+void BatchValidatorTest::reportSources()
+{
+    BatchValidator validator(1);
+    BatchValidator::Result result;
+    ShaderLogMessage included;
+    ShaderLogMessage unknown;
+
+    result.fileName = "effect.frag";
+    result.sources << "effect.frag" << "common.glsl";
+
+    QVERIFY(ShaderLogMessage::parse("ERROR: 1:3: 'x' : undeclared identifier", included));
+    unknown.description = "Link failed";
+
+    result.messages << included << unknown;
+
+    const QJsonObject report = validator.report(QVector<BatchValidator::Result>() << result, 0);
+    const QJsonArray messages = report["files"].toArray()[0].toObject()["messages"].toArray();
+
+    QCOMPARE(messages.size(), 2);
+    QCOMPARE(messages[0].toObject()["source"].toString(), QString("common.glsl"));
+    QCOMPARE(messages[0].toObject()["line"].toInt(), 3);
+    QCOMPARE(messages[1].toObject()["source"].toString(), QString());
+}
+
+bool BatchValidatorTest::writeFile(const QString &name, const char *contents)
+{
+    QFile file(QDir(directory.path()).filePath(name));
+
+    return file.open(QFile::WriteOnly | QFile::Text) && file.write(contents) > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // validator contexts use default format, like in --validate mode
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    QSurfaceFormat::setDefaultFormat(format);
+
+    QGuiApplication app(argc, argv);
+    BatchValidatorTest test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_batchvalidator.moc"
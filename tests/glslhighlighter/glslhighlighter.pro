@@ -0,0 +1,15 @@
+QT       += core gui testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_glslhighlighter
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_glslhighlighter.cpp \
+    ../../glslhighlighter.cpp \
+    ../../tracer.cpp
+
+HEADERS += ../../glslhighlighter.h \
+    ../../tracer.h
@@ -0,0 +1,160 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "glslhighlighter.h"
+#include <QtTest>
+#include <QTextDocument>
+#include <QTextLayout>
+#include <QTextBlock>
+
+namespace {
+
+/// expected highlighting of a range
+enum Highlight
+{
+    Plain,
+    /// keywords and built-in variables
+    Keyword,
+    Type,
+    Function,
+    Comment,
+    Preprocessor
+};
+
+/// format of character at position in block, empty if it has none
+QTextCharFormat formatAt(const QTextBlock &block, int position)
+{
+    for (const QTextLayout::FormatRange &range : block.layout()->formats()) {
+        if (position >= range.start && position < range.start + range.length) {
+            return range.format;
+        }
+    }
+
+    return QTextCharFormat();
+}
+
+bool matches(const QTextCharFormat &format, Highlight highlight)
+{
+    const bool bold = format.fontWeight() == QFont::Bold;
+    const QColor color = format.foreground().color();
+
+    switch (highlight) {
+    case Plain:
+        return !format.hasProperty(QTextFormat::ForegroundBrush)
+                && !format.hasProperty(QTextFormat::FontWeight);
+    case Keyword:
+        return bold && color == QColor(Qt::black);
+    case Type:
+        return bold && color == QColor("#0086b3");
+    case Function:
+        return bold && color == QColor(Qt::blue);
+    case Comment:
+        return !bold && color == QColor("#8a8a8a");
+    case Preprocessor:
+        return bold && color == QColor("#8a8a8a");
+    }
+
+    return false;
+}
+
+} // namespace
+
+Q_DECLARE_METATYPE(Highlight)
+
+/// Formats GLSLHighlighter gives to each kind of token
+class GLSLHighlighterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void formats_data();
+    void formats();
+    void commentState();
+};
+
+void GLSLHighlighterTest::formats_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<int>("blockNumber");
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<Highlight>("highlight");
+
+    QTest::newRow("keyword") << "    return x;" << 0 << "return" << Keyword;
+    QTest::newRow("type") << "vec3 p;" << 0 << "vec3" << Type;
+    QTest::newRow("variable") << "x = gl_FragCoord.xy;" << 0 << "gl_FragCoord" << Keyword;
+    QTest::newRow("function") << "n = normalize(p);" << 0 << "normalize" << Function;
+    QTest::newRow("word prefix") << "vec3 normalized;" << 0 << "normalized" << Plain;
+    QTest::newRow("exponent") << "x = 3.5e-1;" << 0 << "3.5e-1" << Plain;
+    QTest::newRow("hex suffix") << "x = 0x1Fu;" << 0 << "0x1Fu" << Plain;
+    QTest::newRow("comment")
+            << "x = 1.0; // return vec3" << 0 << "// return vec3" << Comment;
+    QTest::newRow("comment start")
+            << "float x; /* first\nreturn vec3\nlast */ float y;" << 0 << "/* first" << Comment;
+    QTest::newRow("comment middle")
+            << "float x; /* first\nreturn vec3\nlast */ float y;" << 1 << "return vec3" << Comment;
+    QTest::newRow("comment end")
+            << "float x; /* first\nreturn vec3\nlast */ float y;" << 2 << "last */" << Comment;
+    QTest::newRow("after comment")
+            << "float x; /* first\nreturn vec3\nlast */ float y;" << 2 << "float" << Type;
+    QTest::newRow("preprocessor")
+            << "#define STEPS 64 // steps" << 0 << "#define STEPS 64 " << Preprocessor;
+    QTest::newRow("preprocessor comment")
+            << "#define STEPS 64 // steps" << 0 << "// steps" << Comment;
+}
+
+void GLSLHighlighterTest::formats()
+{
+    QFETCH(QString, source);
+    QFETCH(int, blockNumber);
+    QFETCH(QString, text);
+    QFETCH(Highlight, highlight);
+
+    QTextDocument document(source);
+    GLSLHighlighter *highlighter = new GLSLHighlighter(&document);
+
+    highlighter->setVisibleBlocks(0, document.blockCount());
+    highlighter->rehighlight();
+
+    const QTextBlock block = document.findBlockByNumber(blockNumber);
+    const int start = block.text().indexOf(text);
+
+    QVERIFY(start >= 0);
+
+    for (int i = start; i < start + text.length(); i++) {
+        QVERIFY2(matches(formatAt(block, i), highlight),
+                 qPrintable(QString("at %1 of '%2'").arg(i).arg(block.text())));
+    }
+}
+
+void GLSLHighlighterTest::commentState()
+{
+    QTextDocument document("/* first\nsecond\nthird */\nfloat x;");
+    GLSLHighlighter *highlighter = new GLSLHighlighter(&document);
+
+    highlighter->rehighlight();
+
+    // blocks ending inside of multi-line comment have state 1
+    QCOMPARE(document.findBlockByNumber(0).userState(), 1);
+    QCOMPARE(document.findBlockByNumber(1).userState(), 1);
+    QCOMPARE(document.findBlockByNumber(2).userState(), 0);
+    QCOMPARE(document.findBlockByNumber(3).userState(), 0);
+}
+
+QTEST_MAIN(GLSLHighlighterTest)
+
+#include "tst_glslhighlighter.moc"
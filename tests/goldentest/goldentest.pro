@@ -0,0 +1,84 @@
+QT       += core gui widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_goldentest
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_goldentest.cpp \
+    ../../shaderworkshop.cpp \
+    ../../renderer.cpp \
+    ../../effect.cpp \
+    ../../editorpage.cpp \
+    ../../codeeditor.cpp \
+    ../../glslhighlighter.cpp \
+    ../../channelsettings.cpp \
+    ../../channeltexture.cpp \
+    ../../audiotexture.cpp \
+    ../../audioanalyzer.cpp \
+    ../../fft.cpp \
+    ../../project.cpp \
+    ../../shaderpreprocessor.cpp \
+    ../../shaderparameter.cpp \
+    ../../parameterswidget.cpp \
+    ../../shadercompiler.cpp \
+    ../../symbolindex.cpp \
+    ../../tracer.cpp \
+    ../../gputimer.cpp \
+    ../../costheatmap.cpp \
+    ../../framehistory.cpp \
+    ../../glstatecache.cpp \
+    ../../presenterwindow.cpp \
+    ../../commandqueue.cpp \
+    ../../renderthread.cpp \
+    ../../shaderlog.cpp \
+    ../../batchvalidator.cpp \
+    ../../shaderlibrary.cpp \
+    ../../librarybrowser.cpp \
+    ../../imagedifference.cpp \
+    ../../goldentest.cpp \
+    ../../gpumemory.cpp \
+    ../../glshader.cpp \
+    ../../offscreenworker.cpp
+
+HEADERS += ../../shaderworkshop.h \
+    ../../renderer.h \
+    ../../effect.h \
+    ../../editorpage.h \
+    ../../linenumberarea.h \
+    ../../codeeditor.h \
+    ../../glslhighlighter.h \
+    ../../channelsettings.h \
+    ../../channeltexture.h \
+    ../../audiotexture.h \
+    ../../audioanalyzer.h \
+    ../../fft.h \
+    ../../project.h \
+    ../../shaderpreprocessor.h \
+    ../../shaderparameter.h \
+    ../../parameterswidget.h \
+    ../../shadercompiler.h \
+    ../../symbolindex.h \
+    ../../tracer.h \
+    ../../gputimer.h \
+    ../../costheatmap.h \
+    ../../framehistory.h \
+    ../../glstatecache.h \
+    ../../presenterwindow.h \
+    ../../commandqueue.h \
+    ../../renderthread.h \
+    ../../shaderlog.h \
+    ../../batchvalidator.h \
+    ../../shaderlibrary.h \
+    ../../librarybrowser.h \
+    ../../imagedifference.h \
+    ../../goldentest.h \
+    ../../gpumemory.h \
+    ../../glshader.h \
+    ../../offscreenworker.h
+
+FORMS += ../../shaderworkshop.ui \
+    ../../editorpage.ui \
+    ../../channelsettings.ui
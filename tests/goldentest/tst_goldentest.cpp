@@ -0,0 +1,132 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "goldentest.h"
+#include "shaderworkshop.h"
+#include <QtTest>
+#include <QApplication>
+#include <QSurfaceFormat>
+
+namespace {
+
+/// same captures and tolerance as scripts/golden.sh, which also
+/// regenerates golden images of this test
+const QSize captureSize(64, 64);
+const int maxError = 1;
+
+} // namespace
+
+/// Reference scenes in 'scenes' rendered through editor and renderer
+/// and compared with their committed golden images
+class GoldenImagesTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    GoldenImagesTest();
+    ~GoldenImagesTest();
+
+private slots:
+    void initTestCase();
+    void scenes_data();
+    void scenes();
+
+private:
+    ShaderWorkshop *workshop;
+    QString sceneDirectory;
+};
+
+GoldenImagesTest::GoldenImagesTest() :
+    workshop(Q_NULLPTR)
+{
+}
+
+GoldenImagesTest::~GoldenImagesTest()
+{
+    delete workshop;
+}
+
+void GoldenImagesTest::initTestCase()
+{
+    sceneDirectory = QFINDTESTDATA("../../scenes");
+
+    QVERIFY(!sceneDirectory.isEmpty());
+
+    // renderer context is created and main image effect is added when editor
+    // is shown and painted for the first time
+    workshop = new ShaderWorkshop();
+    workshop->show();
+    workshop->repaint();
+    QCoreApplication::processEvents();
+}
+
+void GoldenImagesTest::scenes_data()
+{
+    QTest::addColumn<QString>("scene");
+
+    const QDir root(sceneDirectory);
+
+    for (const QString &scene : GoldenTest::findScenes(sceneDirectory)) {
+        QTest::newRow(qPrintable(root.relativeFilePath(scene))) << scene;
+    }
+}
+
+void GoldenImagesTest::scenes()
+{
+    QFETCH(QString, scene);
+
+    GoldenTest::Tolerance tolerance;
+
+    tolerance.maxError = maxError;
+
+    GoldenTest test(workshop, sceneDirectory, QDir(sceneDirectory).filePath("golden"),
+                    captureSize, tolerance);
+    const QVector<GoldenTest::Result> results = test.run(scene, { 0.0f, 1.0f }, false);
+
+    QCOMPARE(results.size(), 2);
+
+    for (const GoldenTest::Result &result : results) {
+        const QString message = result.error.isEmpty()
+                ? QString("%1s: max error %2, PSNR %3, SSIM %4").arg(result.time)
+                  .arg(result.difference.maxError).arg(result.difference.psnr)
+                  .arg(result.difference.ssim)
+                : QString("%1s: %2 %3").arg(result.time).arg(result.error)
+                  .arg(result.goldenFile);
+
+        QVERIFY2(result.passed, qPrintable(message));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // editor renders with the same format as in --golden mode
+    QSurfaceFormat format;
+    format.setDepthBufferSize(24);
+    format.setStencilBufferSize(8);
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    QSurfaceFormat::setDefaultFormat(format);
+
+    QApplication app(argc, argv);
+    GoldenImagesTest test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_goldentest.moc"
@@ -0,0 +1,13 @@
+QT       += core gui testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_gpumemory
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_gpumemory.cpp \
+    ../../gpumemory.cpp
+
+HEADERS += ../../gpumemory.h
@@ -0,0 +1,135 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gpumemory.h"
+#include <QtTest>
+
+/// Accounting by owner and budget checks, no OpenGL context is needed
+class GpuMemoryTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void textureBytes_data();
+    void textureBytes();
+    void setUsage();
+    void removeOwner();
+    void fits_data();
+    void fits();
+};
+
+void GpuMemoryTest::textureBytes_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("format");
+    QTest::addColumn<bool>("mipmaps");
+    QTest::addColumn<qint64>("bytes");
+
+    QTest::newRow("level 0") << QSize(64, 64) << GL_RGBA8 << false << qint64(16384);
+    // 64x64 down to 1x1 is 5461 texels
+    QTest::newRow("mip chain") << QSize(64, 64) << GL_RGBA8 << true << qint64(21844);
+    // 8x2, 4x1, 2x1 and 1x1
+    QTest::newRow("non-square") << QSize(8, 2) << GL_RGBA16F << true << qint64(184);
+    QTest::newRow("float") << QSize(16, 16) << GL_RGBA32F << false << qint64(4096);
+    QTest::newRow("unknown format") << QSize(16, 16) << GL_DEPTH_COMPONENT24 << false
+                                    << qint64(1024);
+}
+
+void GpuMemoryTest::textureBytes()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, format);
+    QFETCH(bool, mipmaps);
+    QFETCH(qint64, bytes);
+
+    QCOMPARE(GpuMemory::textureBytes(size, GLenum(format), mipmaps), bytes);
+}
+
+void GpuMemoryTest::setUsage()
+{
+    GpuMemory memory;
+
+    memory.setUsage(1, GpuMemory::Framebuffers, 1000);
+    memory.setUsage(1, GpuMemory::Programs, 200);
+    memory.setUsage(GpuMemory::historyOwner, GpuMemory::Framebuffers, 3000);
+
+    QCOMPARE(memory.totalUsage(), qint64(4200));
+
+    // new size replaces previous one instead of adding to it
+    memory.setUsage(1, GpuMemory::Framebuffers, 500);
+
+    QCOMPARE(memory.usage(1, GpuMemory::Framebuffers), qint64(500));
+    QCOMPARE(memory.usage(1, GpuMemory::Textures), qint64(0));
+    QCOMPARE(memory.usage(2, GpuMemory::Framebuffers), qint64(0));
+    QCOMPARE(memory.totalUsage(), qint64(3700));
+}
+
+void GpuMemoryTest::removeOwner()
+{
+    GpuMemory memory;
+
+    memory.setUsage(1, GpuMemory::Framebuffers, 1000);
+    memory.setUsage(1, GpuMemory::Textures, 300);
+    memory.setUsage(2, GpuMemory::Framebuffers, 50);
+    memory.removeOwner(1);
+
+    QCOMPARE(memory.usage(1, GpuMemory::Framebuffers), qint64(0));
+    QCOMPARE(memory.totalUsage(), qint64(50));
+
+    memory.removeOwner(3);
+
+    QCOMPARE(memory.totalUsage(), qint64(50));
+
+    QVERIFY(memory.snapshot().owners.keys() == QList<int>() << 2);
+}
+
+void GpuMemoryTest::fits_data()
+{
+    QTest::addColumn<qint64>("budget");
+    QTest::addColumn<int>("owner");
+    QTest::addColumn<qint64>("bytes");
+    QTest::addColumn<bool>("result");
+
+    // owner 1 uses 600 bytes and owner 2 uses 300 of framebuffers
+    QTest::newRow("no budget") << qint64(0) << 3 << qint64(1000000) << true;
+    QTest::newRow("new owner fits") << qint64(1000) << 3 << qint64(100) << true;
+    QTest::newRow("new owner exceeds") << qint64(1000) << 3 << qint64(101) << false;
+    QTest::newRow("own usage is replaced") << qint64(1000) << 1 << qint64(700) << true;
+    QTest::newRow("replacement exceeds") << qint64(1000) << 1 << qint64(701) << false;
+    QTest::newRow("over budget shrinks") << qint64(500) << 1 << qint64(100) << true;
+}
+
+void GpuMemoryTest::fits()
+{
+    QFETCH(qint64, budget);
+    QFETCH(int, owner);
+    QFETCH(qint64, bytes);
+    QFETCH(bool, result);
+
+    GpuMemory memory;
+
+    memory.setUsage(1, GpuMemory::Framebuffers, 600);
+    memory.setUsage(2, GpuMemory::Framebuffers, 300);
+    memory.setBudget(budget, GpuMemory::Refuse);
+
+    QCOMPARE(memory.fits(owner, GpuMemory::Framebuffers, bytes), result);
+}
+
+QTEST_APPLESS_MAIN(GpuMemoryTest)
+
+#include "tst_gpumemory.moc"
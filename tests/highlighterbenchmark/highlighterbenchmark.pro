@@ -0,0 +1,17 @@
+QT       += core gui testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_highlighterbenchmark
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_highlighterbenchmark.cpp \
+    regexhighlighter.cpp \
+    ../../glslhighlighter.cpp \
+    ../../tracer.cpp
+
+HEADERS += regexhighlighter.h \
+    ../../glslhighlighter.h \
+    ../../tracer.h
@@ -0,0 +1,92 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "regexhighlighter.h"
+#include "glslhighlighter.h"
+
+RegexHighlighter::RegexHighlighter(QTextDocument *parent) :
+    QSyntaxHighlighter(parent),
+    commentStart("/\\*"),
+    commentEnd("\\*/")
+{
+    // word categories only differ by format, which does not change the cost
+    QTextCharFormat format;
+
+    format.setFontWeight(QFont::Bold);
+
+    for (const QString &word : GLSLHighlighter::builtinWords()) {
+        addRule(QString("\\b%1\\b").arg(word), format);
+    }
+
+    // add highlighting rule for preprocessor directives
+    format.setForeground(QColor("#8a8a8a"));
+    addRule("#[^\n]*", format);
+    // add rule for single-line comments
+    format.setFontWeight(QFont::Normal);
+    addRule("//[^\n]*", format);
+
+    multiLineCommentFormat.setForeground(QColor("#8a8a8a"));
+}
+
+void RegexHighlighter::highlightBlock(const QString &text)
+{
+    for (auto rule : rules) {
+        QRegularExpressionMatchIterator it = rule.pattern.globalMatch(text);
+
+        while (it.hasNext()) {
+            QRegularExpressionMatch match = it.next();
+
+            setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+        }
+    }
+
+    highlightMultiLineComments(text);
+}
+
+void RegexHighlighter::highlightMultiLineComments(const QString &text)
+{
+    setCurrentBlockState(0);
+
+    int startIndex = 0;
+
+    if (previousBlockState() != 1) {
+        startIndex = text.indexOf(commentStart);
+    }
+
+    while (startIndex >= 0) {
+        QRegularExpressionMatch match = commentEnd.match(text, startIndex);
+        int endIndex = match.capturedStart();
+        int commentLength = 0;
+
+        if (endIndex == -1) {
+            setCurrentBlockState(1);
+            commentLength = text.length() - startIndex;
+        }
+        else {
+            commentLength = endIndex - startIndex + match.capturedLength();
+        }
+
+        setFormat(startIndex, commentLength, multiLineCommentFormat);
+        startIndex = text.indexOf(commentStart, startIndex + commentLength);
+    }
+}
+
+void RegexHighlighter::addRule(const QString &pattern, const QTextCharFormat &format)
+{
+    rules.append(HighlightingRule(QRegularExpression(pattern), format));
+}
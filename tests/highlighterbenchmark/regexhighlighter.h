@@ -0,0 +1,66 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef REGEXHIGHLIGHTER_H
+#define REGEXHIGHLIGHTER_H
+
+#include <QSyntaxHighlighter>
+#include <QRegularExpression>
+#include <QVector>
+
+/// Highlighter that matches one regular expression per known word and per
+/// comment or directive kind, as GLSLHighlighter did before its single-pass
+/// scanner. Kept only as a baseline for the benchmark
+class RegexHighlighter : public QSyntaxHighlighter
+{
+    Q_OBJECT
+
+public:
+    explicit RegexHighlighter(QTextDocument *parent = Q_NULLPTR);
+
+protected:
+    void highlightBlock(const QString &text) Q_DECL_OVERRIDE;
+
+private:
+    void highlightMultiLineComments(const QString &text);
+    void addRule(const QString &pattern, const QTextCharFormat &format);
+
+    struct HighlightingRule
+    {
+        HighlightingRule() {}
+
+        HighlightingRule(const QRegularExpression &pattern,
+                         const QTextCharFormat &format) :
+            pattern(pattern),
+            format(format)
+        {
+        }
+
+        QRegularExpression pattern;
+        QTextCharFormat format;
+    };
+
+    QVector<HighlightingRule> rules;
+    // multi-line comment patterns
+    QRegularExpression commentStart;
+    QRegularExpression commentEnd;
+
+    QTextCharFormat multiLineCommentFormat;
+};
+
+#endif // REGEXHIGHLIGHTER_H
@@ -0,0 +1,148 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "glslhighlighter.h"
+#include "regexhighlighter.h"
+#include <QtTest>
+#include <QTextDocument>
+#include <QTextBlock>
+
+namespace {
+
+/// lines of a typical fragment shader, repeated to make a large one
+const char *const shaderChunk =
+    "#define STEPS 64\n"
+    "/* signed distance of scene,\n"
+    "   material id in y */\n"
+    "vec2 map(in vec3 p)\n"
+    "{\n"
+    "    float sphere = length(p - vec3(0.0, 1.0, 0.0)) - 1.0; // unit sphere\n"
+    "    float plane = p.y + 0.25 * sin(p.x * 3.5e-1) * cos(p.z * 0.5);\n"
+    "    return sphere < plane ? vec2(sphere, 1.0) : vec2(plane, 2.0);\n"
+    "}\n"
+    "\n"
+    "vec3 calcNormal(in vec3 pos)\n"
+    "{\n"
+    "    const vec2 e = vec2(1.0, -1.0) * 0.5773 * 0.0005;\n"
+    "    return normalize(e.xyy * map(pos + e.xyy).x + e.yyx * map(pos + e.yyx).x +\n"
+    "                     e.yxy * map(pos + e.yxy).x + e.xxx * map(pos + e.xxx).x);\n"
+    "}\n"
+    "\n"
+    "void mainImage(out vec4 fragColor, in vec2 fragCoord)\n"
+    "{\n"
+    "    vec2 uv = (2.0 * fragCoord - iResolution.xy) / iResolution.y;\n"
+    "    vec3 ro = vec3(4.0 * cos(iTime), 1.5, 4.0 * sin(iTime));\n"
+    "    vec3 rd = normalize(vec3(uv, -1.5));\n"
+    "    float t = 0.0;\n"
+    "    for (int i = 0; i < STEPS; i++) {\n"
+    "        vec2 h = map(ro + t * rd);\n"
+    "        if (h.x < 0.001 || t > 20.0) break;\n"
+    "        t += h.x;\n"
+    "    }\n"
+    "    vec3 col = texture(iChannel0, uv * 0.5 + 0.5).rgb * 0.2;\n"
+    "    fragColor = vec4(pow(col, vec3(0.4545)), 1.0);\n"
+    "}\n";
+
+const int chunkCount = 300;
+
+} // namespace
+
+/// Cost of GLSLHighlighter::highlightBlock, for whole large shader and for
+/// single lines of each kind
+class HighlighterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void highlightDocument_data();
+    void highlightDocument();
+    void highlightBlock_data();
+    void highlightBlock();
+};
+
+void HighlighterBenchmark::highlightDocument_data()
+{
+    QTest::addColumn<bool>("baseline");
+    QTest::addColumn<bool>("allVisible");
+
+    // editor formats blocks near visible ones and only scans the others
+    QTest::newRow("formatted") << false << true;
+    QTest::newRow("scanned") << false << false;
+    // one regular expression per word, formats every block
+    QTest::newRow("regex baseline") << true << true;
+}
+
+void HighlighterBenchmark::highlightDocument()
+{
+    QFETCH(bool, baseline);
+    QFETCH(bool, allVisible);
+
+    QTextDocument document;
+    QString source;
+
+    for (int i = 0; i < chunkCount; i++) {
+        source += QLatin1String(shaderChunk);
+    }
+
+    document.setPlainText(source);
+
+    QSyntaxHighlighter *highlighter = Q_NULLPTR;
+
+    if (baseline) {
+        highlighter = new RegexHighlighter(&document);
+    }
+    else {
+        GLSLHighlighter *glslHighlighter = new GLSLHighlighter(&document);
+
+        glslHighlighter->setVisibleBlocks(0, allVisible ? document.blockCount() : 40);
+        highlighter = glslHighlighter;
+    }
+
+    QBENCHMARK {
+        highlighter->rehighlight();
+    }
+}
+
+void HighlighterBenchmark::highlightBlock_data()
+{
+    QTest::addColumn<QString>("line");
+
+    QTest::newRow("code")
+            << "    float plane = p.y + 0.25 * sin(p.x * 3.5e-1) * cos(p.z * 0.5);";
+    QTest::newRow("comment")
+            << "    // march along ray until surface or far plane is reached";
+    QTest::newRow("preprocessor") << "#define SHADOW_SOFTNESS 16.0 // penumbra size";
+    QTest::newRow("numbers") << "const vec4 k = vec4(1.0, 2.0 / 3.0, 1.0e-3, 0x1Fu);";
+}
+
+void HighlighterBenchmark::highlightBlock()
+{
+    QFETCH(QString, line);
+
+    QTextDocument document(line);
+    GLSLHighlighter *highlighter = new GLSLHighlighter(&document);
+    const QTextBlock block = document.firstBlock();
+
+    QBENCHMARK {
+        highlighter->rehighlightBlock(block);
+    }
+}
+
+QTEST_MAIN(HighlighterBenchmark)
+
+#include "tst_highlighterbenchmark.moc"
@@ -0,0 +1,13 @@
+QT       += core gui testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_imagedifference
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_imagedifference.cpp \
+    ../../imagedifference.cpp
+
+HEADERS += ../../imagedifference.h
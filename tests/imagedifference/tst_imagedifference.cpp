@@ -0,0 +1,173 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "imagedifference.h"
+#include <QtTest>
+#include <QImage>
+#include <QtMath>
+
+namespace {
+
+/// horizontal gradient with vertical stripes in green
+QImage gradient(QSize size)
+{
+    QImage image(size, QImage::Format_RGBX8888);
+
+    for (int y = 0; y < size.height(); y++) {
+        for (int x = 0; x < size.width(); x++) {
+            const int red = x * 255 / (size.width() - 1);
+
+            image.setPixel(x, y, qRgb(red, (x & 4) ? 200 : 40, y & 255));
+        }
+    }
+
+    return image;
+}
+
+QImage checkerboard(QSize size, bool inverted)
+{
+    QImage image(size, QImage::Format_RGBX8888);
+
+    for (int y = 0; y < size.height(); y++) {
+        for (int x = 0; x < size.width(); x++) {
+            const bool white = (((x ^ y) & 1) != 0) != inverted;
+
+            image.setPixel(x, y, white ? qRgb(255, 255, 255) : qRgb(0, 0, 0));
+        }
+    }
+
+    return image;
+}
+
+} // namespace
+
+/// Metrics of golden image comparison and their speed at 4K
+class ImageDifferenceTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void identical();
+    void alphaIgnored();
+    void singlePixel();
+    void brightnessShift();
+    void inverted();
+    void formatsMatch();
+    void compare4k();
+};
+
+void ImageDifferenceTest::identical()
+{
+    const QImage image = gradient(QSize(64, 48));
+    const ImageDifference difference = ImageDifference::compare(image, image);
+
+    QCOMPARE(difference.maxError, 0);
+    QVERIFY(qIsInf(difference.psnr));
+    QCOMPARE(difference.ssim, 1.0);
+}
+
+void ImageDifferenceTest::alphaIgnored()
+{
+    const QImage opaque = gradient(QSize(32, 32)).convertToFormat(QImage::Format_ARGB32);
+    QImage transparent = opaque;
+
+    for (int y = 0; y < transparent.height(); y++) {
+        for (int x = 0; x < transparent.width(); x++) {
+            const QRgb pixel = transparent.pixel(x, y);
+
+            transparent.setPixel(x, y, qRgba(qRed(pixel), qGreen(pixel), qBlue(pixel), 17));
+        }
+    }
+
+    QCOMPARE(ImageDifference::compare(opaque, transparent).maxError, 0);
+}
+
+void ImageDifferenceTest::singlePixel()
+{
+    const QImage expected = gradient(QSize(64, 64));
+    QImage actual = expected;
+    const QRgb pixel = actual.pixel(10, 20);
+
+    actual.setPixel(10, 20, qRgb(qRed(pixel), qGreen(pixel), qBlue(pixel) + 10));
+
+    const ImageDifference difference = ImageDifference::compare(expected, actual);
+    // one squared error of 100 over all color channels
+    const double mse = 100.0 / (64 * 64 * 3);
+
+    QCOMPARE(difference.maxError, 10);
+    QVERIFY(qFuzzyCompare(difference.psnr, 10.0 * std::log10(255.0 * 255.0 / mse)));
+    QVERIFY(difference.ssim < 1.0);
+}
+
+void ImageDifferenceTest::brightnessShift()
+{
+    const QImage expected = gradient(QSize(64, 64));
+    QImage actual = expected;
+
+    for (int y = 0; y < actual.height(); y++) {
+        for (int x = 0; x < actual.width(); x++) {
+            const QRgb pixel = actual.pixel(x, y);
+
+            actual.setPixel(x, y, qRgb(qMin(qRed(pixel) + 1, 255), qGreen(pixel),
+                                       qBlue(pixel)));
+        }
+    }
+
+    const ImageDifference difference = ImageDifference::compare(expected, actual);
+
+    // rounding differences of drivers stay within loose tolerance
+    QCOMPARE(difference.maxError, 1);
+    QVERIFY(difference.psnr > 50.0);
+    QVERIFY(difference.ssim > 0.99);
+}
+
+void ImageDifferenceTest::inverted()
+{
+    const QSize size(32, 32);
+    const ImageDifference difference = ImageDifference::compare(checkerboard(size, false),
+                                                                checkerboard(size, true));
+
+    QCOMPARE(difference.maxError, 255);
+    // mean and contrast are the same, structure is opposite
+    QVERIFY(difference.ssim < 0.0);
+}
+
+void ImageDifferenceTest::formatsMatch()
+{
+    const QImage image = gradient(QSize(16, 16));
+    const ImageDifference difference = ImageDifference::compare(
+                image.convertToFormat(QImage::Format_RGB32), image);
+
+    QCOMPARE(difference.maxError, 0);
+}
+
+void ImageDifferenceTest::compare4k()
+{
+    const QImage expected = gradient(QSize(3840, 2160));
+    QImage actual = expected;
+
+    actual.setPixel(1000, 1000, qRgb(0, 0, 0));
+
+    QBENCHMARK {
+        ImageDifference::compare(expected, actual);
+    }
+}
+
+QTEST_APPLESS_MAIN(ImageDifferenceTest)
+
+#include "tst_imagedifference.moc"
@@ -0,0 +1,47 @@
+QT       += core gui widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_rendererbenchmark
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_rendererbenchmark.cpp \
+    ../../renderer.cpp \
+    ../../effect.cpp \
+    ../../channeltexture.cpp \
+    ../../audiotexture.cpp \
+    ../../audioanalyzer.cpp \
+    ../../fft.cpp \
+    ../../shaderparameter.cpp \
+    ../../shadercompiler.cpp \
+    ../../tracer.cpp \
+    ../../gputimer.cpp \
+    ../../costheatmap.cpp \
+    ../../framehistory.cpp \
+    ../../glstatecache.cpp \
+    ../../commandqueue.cpp \
+    ../../renderthread.cpp \
+    ../../gpumemory.cpp \
+    ../../glshader.cpp \
+    ../../offscreenworker.cpp
+
+HEADERS += ../../renderer.h \
+    ../../effect.h \
+    ../../channeltexture.h \
+    ../../audiotexture.h \
+    ../../audioanalyzer.h \
+    ../../fft.h \
+    ../../shaderparameter.h \
+    ../../shadercompiler.h \
+    ../../tracer.h \
+    ../../gputimer.h \
+    ../../costheatmap.h \
+    ../../framehistory.h \
+    ../../glstatecache.h \
+    ../../commandqueue.h \
+    ../../renderthread.h \
+    ../../gpumemory.h \
+    ../../glshader.h \
+    ../../offscreenworker.h
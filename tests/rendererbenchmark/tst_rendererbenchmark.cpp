@@ -0,0 +1,172 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "renderer.h"
+#include <QtTest>
+#include <QApplication>
+#include <QSurfaceFormat>
+
+namespace {
+
+/// buffer averaging its four inputs, so every bound channel is sampled
+const char *const bufferSource =
+    "#version 330 core\n"
+    "out vec4 fragColor;\n"
+    "uniform vec2 iResolution;\n"
+    "uniform sampler2D iChannel0;\n"
+    "uniform sampler2D iChannel1;\n"
+    "uniform sampler2D iChannel2;\n"
+    "uniform sampler2D iChannel3;\n"
+    "void main(void)\n"
+    "{\n"
+    "    vec2 uv = gl_FragCoord.xy / iResolution;\n"
+    "    fragColor = 0.25 * (texture(iChannel0, uv) + texture(iChannel1, uv)\n"
+    "                        + texture(iChannel2, uv) + texture(iChannel3, uv)) + 0.01;\n"
+    "}\n";
+
+const char *const imageSource =
+    "#version 330 core\n"
+    "out vec4 fragColor;\n"
+    "uniform vec2 iResolution;\n"
+    "uniform sampler2D iChannel0;\n"
+    "void main(void)\n"
+    "{\n"
+    "    fragColor = texture(iChannel0, gl_FragCoord.xy / iResolution);\n"
+    "}\n";
+
+const int imageIndex = 0;
+const int channels = 4;
+/// small buffers, so time is spent on passes and binds, not on shading
+const QSize bufferSize(64, 64);
+/// frames from 0 to 30 are rendered by each capture
+const GLfloat captureTime = 0.5f;
+
+} // namespace
+
+/// Cost of rendering frames with a chain of buffers, each sampling four
+/// buffers before it. Capture time should grow linearly with buffer count
+class RendererBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void renderFrames_data();
+    void renderFrames();
+
+private:
+    Renderer *renderer;
+};
+
+void RendererBenchmark::initTestCase()
+{
+    renderer = new Renderer();
+    renderer->resize(bufferSize);
+    renderer->show();
+
+    QVERIFY(QTest::qWaitForWindowExposed(renderer));
+
+    // context of render thread is created on first paint
+    renderer->repaint();
+    QCoreApplication::processEvents();
+
+    renderer->setPaused(true);
+    renderer->createEffect(imageIndex);
+
+    const QString log = renderer->recompileEffectShader(imageIndex, imageSource);
+
+    QVERIFY2(log.isEmpty(), qPrintable(log));
+}
+
+void RendererBenchmark::cleanupTestCase()
+{
+    delete renderer;
+}
+
+void RendererBenchmark::renderFrames_data()
+{
+    QTest::addColumn<int>("buffers");
+
+    QTest::newRow("1 buffer") << 1;
+    QTest::newRow("8 buffers") << 8;
+    QTest::newRow("32 buffers") << 32;
+}
+
+void RendererBenchmark::renderFrames()
+{
+    QFETCH(int, buffers);
+
+    QHash<int, QString> sources;
+
+    for (int index = 1; index <= buffers; index++) {
+        renderer->createEffect(index);
+        renderer->setEffectBuffer(index, bufferSize, GL_RGBA8);
+        renderer->effectChannelCountChanged(index, channels);
+
+        for (int channel = 0; channel < channels; channel++) {
+            // first buffers have fewer buffers before them to sample
+            const int input = index - channel - 1 > 0 ? index - channel - 1 : -1;
+
+            renderer->effectInputChanged(index, channel, input);
+            renderer->effectFilteringChanged(index, channel, GL_LINEAR);
+        }
+
+        sources.insert(index, bufferSource);
+    }
+
+    renderer->effectInputChanged(imageIndex, 0, buffers);
+    renderer->effectFilteringChanged(imageIndex, 0, GL_LINEAR);
+
+    const QHash<int, QString> logs = renderer->recompileEffectShaders(sources);
+
+    for (const QString &log : logs) {
+        QVERIFY2(log.isEmpty(), qPrintable(log));
+    }
+
+    const QVector<GLfloat> times(1, captureTime);
+    QVector<QImage> images;
+
+    QBENCHMARK {
+        images = renderer->captureFrames(times, bufferSize);
+    }
+
+    QCOMPARE(images.size(), times.size());
+
+    // buffers are removed from inputs of remaining effects too
+    for (int index = 1; index <= buffers; index++) {
+        renderer->deleteEffect(index);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // renderer expects the same context as in application
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    QSurfaceFormat::setDefaultFormat(format);
+
+    QApplication app(argc, argv);
+    RendererBenchmark benchmark;
+
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "tst_rendererbenchmark.moc"
@@ -0,0 +1,23 @@
+QT       += core gui testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_shaderlibrary
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_shaderlibrary.cpp \
+    ../../shaderlibrary.cpp \
+    ../../shaderpreprocessor.cpp \
+    ../../project.cpp \
+    ../../tracer.cpp \
+    ../../glshader.cpp \
+    ../../offscreenworker.cpp
+
+HEADERS += ../../shaderlibrary.h \
+    ../../shaderpreprocessor.h \
+    ../../project.h \
+    ../../tracer.h \
+    ../../glshader.h \
+    ../../offscreenworker.h
@@ -0,0 +1,256 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shaderlibrary.h"
+#include <QtTest>
+#include <QGuiApplication>
+#include <QSurfaceFormat>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+namespace {
+
+const char *const validSource =
+    "#version 330 core\n"
+    "out vec4 fragColor;\n"
+    "uniform float iTime;\n"
+    "void main(void)\n"
+    "{\n"
+    "    fragColor = vec4(0.5 + 0.5 * sin(iTime), 0.2, 0.4, 1.0);\n"
+    "}\n";
+
+const char *const brokenSource =
+    "#version 330 core\n"
+    "out vec4 fragColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "    fragColor = undeclared;\n"
+    "}\n";
+
+const char *const missingIncludeSource =
+    "#version 330 core\n"
+    "#include \"nothing.glsl\"\n";
+
+const char *const includingSource =
+    "#version 330 core\n"
+    "#include \"color.glsl\"\n"
+    "out vec4 fragColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "    fragColor = color();\n"
+    "}\n";
+
+const char *const redSource =
+    "vec4 color()\n"
+    "{\n"
+    "    return vec4(1.0, 0.0, 0.0, 1.0);\n"
+    "}\n";
+
+const char *const blueSource =
+    "vec4 color()\n"
+    "{\n"
+    "    return vec4(0.0, 0.0, 1.0, 1.0);\n"
+    "}\n";
+
+/// main image uses shared code of project
+const char *const projectSource =
+    "{\n"
+    "    \"version\": 1,\n"
+    "    \"pages\": [\n"
+    "        {\n"
+    "            \"name\": \"Image\",\n"
+    "            \"source\": \"#version 330 core\\n#include \\\"Common\\\"\\n"
+    "out vec4 fragColor;\\nvoid main(void)\\n{\\n    fragColor = shade();\\n}\\n\"\n"
+    "        },\n"
+    "        {\n"
+    "            \"name\": \"Common\",\n"
+    "            \"source\": \"vec4 shade()\\n{\\n    return vec4(0.1, 0.6, 0.3, 1.0);\\n}\\n\"\n"
+    "        }\n"
+    "    ]\n"
+    "}\n";
+
+} // namespace
+
+/// Indexing of a shader directory, thumbnails rendered on worker thread and
+/// their cache. Cache goes to test location of QStandardPaths
+class ShaderLibraryTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void index();
+    void indexAgain();
+    void includeChanged();
+
+private:
+    /// false if file could not be written
+    bool writeFile(const QString &name, const char *contents);
+    /// file names of entries and thumbnails reported for directory,
+    /// waits until specified number of thumbnails is reported
+    void indexDirectory(QStringList &entries, QHash<QString, QImage> &thumbnails,
+                        int expectedThumbnails);
+
+    QTemporaryDir directory;
+    QDir thumbnailDirectory;
+};
+
+void ShaderLibraryTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    const QString cache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + "/library";
+
+    QVERIFY(QDir(cache).removeRecursively());
+
+    thumbnailDirectory = QDir(cache + "/thumbnails");
+
+    QVERIFY(directory.isValid());
+    QVERIFY(QDir(directory.path()).mkdir("sub"));
+
+    QVERIFY(writeFile("valid.frag", validSource));
+    QVERIFY(writeFile("broken.frag", brokenSource));
+    QVERIFY(writeFile("missing.frag", missingIncludeSource));
+    QVERIFY(writeFile("sub/effect.swproj", projectSource));
+    QVERIFY(writeFile("notes.txt", "not a shader"));
+}
+
+void ShaderLibraryTest::index()
+{
+    QStringList entries;
+    QHash<QString, QImage> thumbnails;
+
+    indexDirectory(entries, thumbnails, 2);
+
+    QCOMPARE(entries, QStringList() << "broken.frag" << "missing.frag"
+                                    << "sub/effect.swproj" << "valid.frag");
+
+    // effects that do not compile have no thumbnail
+    QCOMPARE(thumbnails.size(), 2);
+    QVERIFY(!thumbnails.value("valid.frag").isNull());
+    QVERIFY(!thumbnails.value("sub/effect.swproj").isNull());
+    QVERIFY(thumbnails.value("valid.frag").width() <= 160);
+
+    // only compile errors are remembered, missing include may appear later
+    const QFileInfoList cached = thumbnailDirectory.entryInfoList(QDir::Files);
+    int markers = 0;
+
+    for (const QFileInfo &info : cached) {
+        markers += info.size() == 0 ? 1 : 0;
+    }
+
+    QCOMPARE(cached.size(), 3);
+    QCOMPARE(markers, 1);
+}
+
+void ShaderLibraryTest::indexAgain()
+{
+    QStringList entries;
+    QHash<QString, QImage> thumbnails;
+
+    // index and thumbnails come from cache
+    indexDirectory(entries, thumbnails, 2);
+
+    QCOMPARE(entries.size(), 4);
+    QCOMPARE(thumbnails.size(), 2);
+    QCOMPARE(thumbnailDirectory.entryList(QDir::Files).size(), 3);
+}
+
+void ShaderLibraryTest::includeChanged()
+{
+    QStringList entries;
+    QHash<QString, QImage> thumbnails;
+
+    QVERIFY(writeFile("including.frag", includingSource));
+    QVERIFY(writeFile("color.glsl", redSource));
+
+    indexDirectory(entries, thumbnails, 3);
+
+    const QImage red = thumbnails.value("including.frag");
+
+    QVERIFY(!red.isNull());
+    QCOMPARE(thumbnailDirectory.entryList(QDir::Files).size(), 4);
+
+    // including file is unchanged, its thumbnail is rendered again anyway
+    QVERIFY(writeFile("color.glsl", blueSource));
+
+    entries.clear();
+    thumbnails.clear();
+    indexDirectory(entries, thumbnails, 3);
+
+    const QImage blue = thumbnails.value("including.frag");
+
+    QVERIFY(!blue.isNull());
+    QVERIFY(blue != red);
+    QCOMPARE(thumbnailDirectory.entryList(QDir::Files).size(), 5);
+}
+
+bool ShaderLibraryTest::writeFile(const QString &name, const char *contents)
+{
+    QFile file(QDir(directory.path()).filePath(name));
+
+    return file.open(QFile::WriteOnly | QFile::Text) && file.write(contents) > 0;
+}
+
+void ShaderLibraryTest::indexDirectory(QStringList &entries,
+                                       QHash<QString, QImage> &thumbnails,
+                                       int expectedThumbnails)
+{
+    ShaderLibrary library;
+    QSignalSpy found(&library, SIGNAL(entriesFound(QVector<LibraryEntry>)));
+    QSignalSpy finished(&library, SIGNAL(indexingFinished(int)));
+    QSignalSpy ready(&library, SIGNAL(thumbnailReady(QString,QImage)));
+    const QDir root(directory.path());
+
+    library.setDirectory(directory.path());
+
+    QTRY_COMPARE(finished.count(), 1);
+
+    for (const QList<QVariant> &arguments : found) {
+        for (const LibraryEntry &entry : arguments.at(0).value<QVector<LibraryEntry>>()) {
+            entries.append(root.relativeFilePath(entry.fileName));
+        }
+    }
+
+    QCOMPARE(finished.at(0).at(0).toInt(), entries.size());
+
+    QTRY_COMPARE(ready.count(), expectedThumbnails);
+
+    for (const QList<QVariant> &arguments : ready) {
+        thumbnails.insert(root.relativeFilePath(arguments.at(0).toString()),
+                          arguments.at(1).value<QImage>());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // thumbnails are rendered with the same context as editor uses
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    QSurfaceFormat::setDefaultFormat(format);
+
+    QGuiApplication app(argc, argv);
+    ShaderLibraryTest test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_shaderlibrary.moc"
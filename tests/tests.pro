@@ -0,0 +1,10 @@
+TEMPLATE = subdirs
+
+SUBDIRS += highlighterbenchmark \
+    glslhighlighter \
+    rendererbenchmark \
+    gpumemory \
+    imagedifference \
+    batchvalidator \
+    shaderlibrary \
+    goldentest
@@ -0,0 +1,242 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tracer.h"
+#include <QThread>
+#include <QThreadStorage>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+
+namespace {
+
+/// events kept per thread
+const int bufferCapacity = 1 << 16;
+/// trace event process id, there is only one process
+const int processId = 1;
+
+} // namespace
+
+Tracer::Buffer::Buffer(const QString &name, int id) :
+    name(name),
+    id(id),
+    events(bufferCapacity),
+    head(0),
+    epoch(0)
+{
+}
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+
+    return tracer;
+}
+
+Tracer::Tracer() :
+    enabled(0),
+    epoch(0)
+{
+    timer.start();
+}
+
+bool Tracer::isEnabled() const
+{
+    return enabled.load() != 0;
+}
+
+void Tracer::setEnabled(bool enable)
+{
+    // buffers may be written right now, their owners reset them instead
+    if (enable) {
+        epoch.fetchAndAddOrdered(1);
+    }
+
+    enabled.store(enable ? 1 : 0);
+}
+
+qint64 Tracer::now() const
+{
+    return timer.nsecsElapsed() / 1000;
+}
+
+void Tracer::record(const char *name, const char *category, qint64 start,
+                    qint64 duration, int argument)
+{
+    write(*threadBuffer(), TraceEvent{name, category, start, duration, argument});
+}
+
+void Tracer::recordGpu(const char *name, qint64 start, qint64 duration, int argument)
+{
+    if (!gpuBuffer) {
+        QMutexLocker locker(&mutex);
+
+        gpuBuffer.reset(new Buffer("GPU", buffers.size() + 1000));
+    }
+
+    write(*gpuBuffer, TraceEvent{name, "gpu", start, duration, argument});
+}
+
+bool Tracer::exportJson(const QString &fileName, QString &error) const
+{
+    QList<QSharedPointer<Buffer>> list;
+
+    {
+        QMutexLocker locker(&mutex);
+
+        list = buffers;
+
+        if (gpuBuffer) {
+            list.append(gpuBuffer);
+        }
+    }
+
+    QJsonArray events;
+    const quint32 recording = epoch.loadAcquire();
+
+    for (const auto &buffer : list) {
+        QJsonObject metadata;
+        QJsonObject threadName;
+
+        threadName["name"] = buffer->name;
+
+        metadata["name"] = "thread_name";
+        metadata["ph"] = "M";
+        metadata["pid"] = processId;
+        metadata["tid"] = buffer->id;
+        metadata["args"] = threadName;
+
+        events.append(metadata);
+
+        // events written by other threads during export may be torn,
+        // that is acceptable for diagnostics
+        // buffer not written since recording started holds old events only
+        if (buffer->epoch.loadAcquire() != recording) {
+            continue;
+        }
+
+        const quint32 head = buffer->head.loadAcquire();
+        const quint32 count = qMin<quint32>(head, bufferCapacity);
+
+        for (quint32 i = head - count; i != head; i++) {
+            const TraceEvent &event = buffer->events.at(i % bufferCapacity);
+            QJsonObject object;
+
+            object["name"] = event.name;
+            object["cat"] = event.category;
+            object["ph"] = "X";
+            object["ts"] = double(event.start);
+            object["dur"] = double(event.duration);
+            object["pid"] = processId;
+            object["tid"] = buffer->id;
+
+            if (event.argument >= 0) {
+                QJsonObject args;
+
+                args["index"] = event.argument;
+                object["args"] = args;
+            }
+
+            events.append(object);
+        }
+    }
+
+    QJsonObject root;
+
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(fileName);
+
+    if (!file.open(QFile::WriteOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+
+    return true;
+}
+
+Tracer::Buffer* Tracer::threadBuffer()
+{
+    // storage keeps buffer alive while thread runs,
+    // buffers list keeps it for export after thread finishes
+    static QThreadStorage<QSharedPointer<Buffer>> storage;
+
+    if (!storage.hasLocalData()) {
+        QThread *thread = QThread::currentThread();
+        QString name = thread->objectName();
+        QMutexLocker locker(&mutex);
+
+        if (thread == QCoreApplication::instance()->thread()) {
+            name = "GUI";
+        }
+        else if (name.isEmpty()) {
+            name = QString("Thread %1").arg(buffers.size());
+        }
+
+        QSharedPointer<Buffer> buffer(new Buffer(name, buffers.size() + 1));
+
+        buffers.append(buffer);
+        storage.setLocalData(buffer);
+    }
+
+    return storage.localData().data();
+}
+
+void Tracer::write(Buffer &buffer, const TraceEvent &event)
+{
+    const quint32 recording = epoch.loadAcquire();
+
+    if (buffer.epoch.load() != recording) {
+        // head is reset before new epoch is published to exporting thread
+        buffer.head.store(0);
+        buffer.epoch.storeRelease(recording);
+    }
+
+    const quint32 index = buffer.head.load();
+
+    buffer.events[index % bufferCapacity] = event;
+    // publish event to exporting thread
+    buffer.head.storeRelease(index + 1);
+}
+
+TraceScope::TraceScope(const char *name, const char *category, int argument) :
+    name(name),
+    category(category),
+    argument(argument),
+    start(Tracer::instance().isEnabled() ? Tracer::instance().now() : -1)
+{
+}
+
+TraceScope::~TraceScope()
+{
+    if (start < 0) {
+        return;
+    }
+
+    Tracer &tracer = Tracer::instance();
+
+    // recording could be stopped inside of scope
+    if (tracer.isEnabled()) {
+        tracer.record(name, category, start, tracer.now() - start, argument);
+    }
+}
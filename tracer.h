@@ -0,0 +1,124 @@
+/*
+ * This file is part of ShaderWorkshop (https://github.com/VladimirMakeev/ShaderWorkshop).
+ * Copyright (C) 2019 Vladimir Makeev.
+ *
+ * ShaderWorkshop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * ShaderWorkshop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with ShaderWorkshop.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QList>
+#include <QVector>
+#include <QSharedPointer>
+#include <QString>
+
+/// single trace event, names and categories must be string literals
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    /// start time and duration in microseconds
+    qint64 start;
+    qint64 duration;
+    /// optional argument, for example effect index, -1 if unused
+    int argument;
+};
+
+/// Records scoped CPU markers and GPU time ranges of all threads
+/// and exports them in Chrome trace event format,
+/// which can be opened in chrome://tracing or Perfetto.
+/// Each thread writes to its own ring buffer without locking,
+/// oldest events are overwritten when buffer is full
+class Tracer
+{
+public:
+    static Tracer& instance();
+
+    /// cheap check done by every marker
+    bool isEnabled() const;
+    /// enabling recording discards previously recorded events
+    void setEnabled(bool enabled);
+
+    /// microseconds since tracer creation
+    qint64 now() const;
+
+    /// record event of calling thread
+    void record(const char *name, const char *category, qint64 start, qint64 duration,
+                int argument = -1);
+    /// record GPU time range, converted to CPU time already.
+    /// Must be called from rendering thread only
+    void recordGpu(const char *name, qint64 start, qint64 duration, int argument = -1);
+
+    /// write recorded events as trace event JSON, fill error on failure
+    bool exportJson(const QString &fileName, QString &error) const;
+
+private:
+    struct Buffer
+    {
+        Buffer(const QString &name, int id);
+
+        QString name;
+        int id;
+        QVector<TraceEvent> events;
+        /// total number of events written, only owner thread writes
+        QAtomicInteger<quint32> head;
+        /// recording events belong to, only owner thread writes
+        QAtomicInteger<quint32> epoch;
+    };
+
+    Tracer();
+    Q_DISABLE_COPY(Tracer)
+
+    Buffer* threadBuffer();
+    void write(Buffer &buffer, const TraceEvent &event);
+
+    QAtomicInt enabled;
+    /// incremented when recording is enabled, owner threads discard events
+    /// of previous recording from their buffers on next write
+    QAtomicInteger<quint32> epoch;
+    QElapsedTimer timer;
+    /// protects buffers list, not buffer contents
+    mutable QMutex mutex;
+    QList<QSharedPointer<Buffer>> buffers;
+    QSharedPointer<Buffer> gpuBuffer;
+};
+
+/// Records event covering lifetime of scope object when tracing is enabled
+class TraceScope
+{
+public:
+    TraceScope(const char *name, const char *category, int argument = -1);
+    ~TraceScope();
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char *name;
+    const char *category;
+    int argument;
+    /// -1 if tracing was disabled at scope start
+    qint64 start;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+/// trace current scope: TRACE_SCOPE("paintGL", "render") or with argument
+#define TRACE_SCOPE(...) TraceScope TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+
+#endif // TRACER_H